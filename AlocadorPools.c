@@ -0,0 +1,457 @@
+/*
+ * Alocador por classes de tamanho.  Ver AlocadorPools.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "AlocadorPools.h"
+
+#define alocadorSEM_CLASSE              0xFFU
+
+/* Arredonda para a granularidade, que e tambem o alinhamento dos blocos. */
+#define alocadorARREDONDAR( x )         ( ( ( x ) + alocadorGRANULARIDADE - 1 ) & ~( ( size_t ) alocadorGRANULARIDADE - 1 ) )
+
+/* Cabe em configTOTAL_HEAP_SIZE com TCBs e pilhas de 32 e de 64 bits. */
+const ConfigClasse_t xClassesSistema[] = {
+    { 32,                                                16 },
+    { 64,                                                16 },
+    { sizeof(StaticEventGroup_t),                        4 },
+    { sizeof(StaticQueue_t),                             16 },
+    { 128,                                               16 },
+    { sizeof(StaticTask_t),                              24 },
+    { configMINIMAL_STACK_SIZE * sizeof(StackType_t),    24 },
+    { 256,                                               8 },
+    { 512,                                               8 },
+    { 1024,                                              4 },
+    { 2048,                                              2 },
+    { 4096,                                              1 },
+};
+const UBaseType_t uxNumClassesSistema = sizeof(xClassesSistema) / sizeof(xClassesSistema[0]);
+
+static Alocador_t xSistema;
+static uint64_t ullArenaSistema[configTOTAL_HEAP_SIZE / sizeof(uint64_t)];
+static BaseType_t xSistemaIniciado = pdFALSE;
+static size_t xLiberacoesSistema;
+
+/* Sequencia gravada e endereco de cada alocacao gravada, ate a liberacao. */
+static OperacaoAlocador_t xSequencia[alocadorMAX_OPERACOES];
+static void* pvGravados[alocadorMAX_OPERACOES];
+static UBaseType_t uxOperacoes;
+static UBaseType_t uxAlocacoesGravadas;
+
+const size_t xRamAlocador = sizeof(ullArenaSistema) + sizeof(xSequencia) + sizeof(pvGravados);
+
+/*-----------------------------------------------------------*/
+
+static ClassePool_t* prvClasseDoBloco(const Alocador_t* pxAlocador, const void* pv)
+{
+    const uint8_t* puc = (const uint8_t*)pv;
+
+    /* Poucas classes: a busca tem custo fixo. */
+    for (UBaseType_t ux = 0; ux < pxAlocador->uxNumClasses; ux++) {
+        const ClassePool_t* pxClasse = &pxAlocador->xClasses[ux];
+
+        if (puc >= pxClasse->pucInicio && puc < pxClasse->pucFim)
+            return (ClassePool_t*)pxClasse;
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t AlocadorInicializar(Alocador_t* pxAlocador, void* pvArena, size_t xTamanhoArena,
+                               const ConfigClasse_t* pxConfig, UBaseType_t uxNumClasses)
+{
+    uint8_t* puc = (uint8_t*)pvArena;
+    uint8_t* pucFimArena = puc + xTamanhoArena;
+    UBaseType_t uxClasse = 0;
+
+    configASSERT((alocadorGRANULARIDADE % portBYTE_ALIGNMENT) == 0);
+    configASSERT(((uintptr_t)pvArena % alocadorGRANULARIDADE) == 0);
+    configASSERT(uxNumClasses <= alocadorMAX_CLASSES);
+
+    memset(pxAlocador, 0, sizeof(*pxAlocador));
+
+    /* Ordena por tamanho (insercao; sao poucas classes), juntando as que
+     * arredondam para o mesmo bloco. */
+    for (UBaseType_t ux = 0; ux < uxNumClasses; ux++) {
+        size_t xTamanho = alocadorARREDONDAR(pxConfig[ux].xTamanho);
+        UBaseType_t uxPos;
+
+        if (xTamanho < sizeof(void*))
+            xTamanho = alocadorARREDONDAR(sizeof(void*));
+        if (xTamanho > alocadorMAIOR_BLOCO || pxConfig[ux].uxBlocos == 0)
+            return pdFAIL;
+
+        for (uxPos = 0; uxPos < pxAlocador->uxNumClasses; uxPos++) {
+            if (pxAlocador->xClasses[uxPos].xTamanho >= xTamanho)
+                break;
+        }
+
+        if (uxPos < pxAlocador->uxNumClasses && pxAlocador->xClasses[uxPos].xTamanho == xTamanho) {
+            pxAlocador->xClasses[uxPos].uxBlocos += pxConfig[ux].uxBlocos;
+            continue;
+        }
+
+        memmove(&pxAlocador->xClasses[uxPos + 1], &pxAlocador->xClasses[uxPos],
+                (pxAlocador->uxNumClasses - uxPos) * sizeof(ClassePool_t));
+        pxAlocador->xClasses[uxPos].xTamanho = xTamanho;
+        pxAlocador->xClasses[uxPos].uxBlocos = pxConfig[ux].uxBlocos;
+        pxAlocador->uxNumClasses++;
+    }
+
+    /* Fatia a arena.  Os blocos entram na lista do ultimo para o primeiro, para
+     * as primeiras alocacoes sairem dos enderecos mais baixos. */
+    for (UBaseType_t ux = 0; ux < pxAlocador->uxNumClasses; ux++) {
+        ClassePool_t* pxClasse = &pxAlocador->xClasses[ux];
+        size_t xBytes = pxClasse->xTamanho * pxClasse->uxBlocos;
+
+        if ((size_t)(pucFimArena - puc) < xBytes)
+            return pdFAIL;
+
+        pxClasse->pucInicio = puc;
+        pxClasse->pucFim = puc + xBytes;
+        pxClasse->pvLivres = NULL;
+        for (UBaseType_t uxBloco = pxClasse->uxBlocos; uxBloco > 0; uxBloco--) {
+            void** ppvBloco = (void**)(puc + (uxBloco - 1) * pxClasse->xTamanho);
+
+            *ppvBloco = pxClasse->pvLivres;
+            pxClasse->pvLivres = ppvBloco;
+        }
+
+        puc += xBytes;
+        pxAlocador->xLivres += xBytes;
+    }
+    pxAlocador->xMinimoLivres = pxAlocador->xLivres;
+
+    /* Menor classe que atende cada faixa de alocadorGRANULARIDADE bytes. */
+    for (size_t xIndice = 0; xIndice < sizeof(pxAlocador->ucClassePorTamanho); xIndice++) {
+        while (uxClasse < pxAlocador->uxNumClasses &&
+               pxAlocador->xClasses[uxClasse].xTamanho < xIndice * alocadorGRANULARIDADE)
+            uxClasse++;
+        pxAlocador->ucClassePorTamanho[xIndice] =
+            uxClasse < pxAlocador->uxNumClasses ? (uint8_t)uxClasse : alocadorSEM_CLASSE;
+    }
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void* pvAlocadorAlocar(Alocador_t* pxAlocador, size_t xTamanho)
+{
+    ClassePool_t* pxPedida;
+    ClassePool_t* pxClasse;
+    uint8_t ucClasse;
+    void** ppvBloco;
+
+    if (xTamanho == 0)
+        return NULL;
+
+    ucClasse = xTamanho <= alocadorMAIOR_BLOCO ?
+        pxAlocador->ucClassePorTamanho[(xTamanho + alocadorGRANULARIDADE - 1) / alocadorGRANULARIDADE] :
+        alocadorSEM_CLASSE;
+    if (ucClasse == alocadorSEM_CLASSE) {
+        pxAlocador->ulGrandesDemais++;
+        return NULL;
+    }
+
+    /* Classe esgotada: transborda para a menor maior com bloco livre. */
+    pxPedida = &pxAlocador->xClasses[ucClasse];
+    pxClasse = pxPedida;
+    while (pxClasse->pvLivres == NULL) {
+        if (++pxClasse == &pxAlocador->xClasses[pxAlocador->uxNumClasses]) {
+            pxPedida->ulFalhas++;
+            return NULL;
+        }
+    }
+    if (pxClasse != pxPedida)
+        pxPedida->ulTransbordos++;
+
+    ppvBloco = (void**)pxClasse->pvLivres;
+    pxClasse->pvLivres = *ppvBloco;
+
+    pxClasse->ulAlocacoes++;
+    if (++pxClasse->uxEmUso > pxClasse->uxMaximo)
+        pxClasse->uxMaximo = pxClasse->uxEmUso;
+
+    pxAlocador->xLivres -= pxClasse->xTamanho;
+    if (pxAlocador->xLivres < pxAlocador->xMinimoLivres)
+        pxAlocador->xMinimoLivres = pxAlocador->xLivres;
+
+    return ppvBloco;
+}
+/*-----------------------------------------------------------*/
+
+void vAlocadorLiberar(Alocador_t* pxAlocador, void* pv)
+{
+    ClassePool_t* pxClasse;
+    void** ppvBloco = (void**)pv;
+
+    if (pv == NULL)
+        return;
+
+    pxClasse = prvClasseDoBloco(pxAlocador, pv);
+    configASSERT(pxClasse != NULL);
+    configASSERT((((uint8_t*)pv - pxClasse->pucInicio) % pxClasse->xTamanho) == 0);
+    configASSERT(pxClasse->uxEmUso > 0);
+    if (pxClasse == NULL)
+        return;
+
+    *ppvBloco = pxClasse->pvLivres;
+    pxClasse->pvLivres = ppvBloco;
+    pxClasse->uxEmUso--;
+    pxAlocador->xLivres += pxClasse->xTamanho;
+}
+/*-----------------------------------------------------------*/
+
+size_t xAlocadorTamanhoBloco(const Alocador_t* pxAlocador, const void* pv)
+{
+    const ClassePool_t* pxClasse = prvClasseDoBloco(pxAlocador, pv);
+
+    return pxClasse != NULL ? pxClasse->xTamanho : 0;
+}
+/*-----------------------------------------------------------*/
+
+size_t xAlocadorMaiorLivre(const Alocador_t* pxAlocador)
+{
+    for (UBaseType_t ux = pxAlocador->uxNumClasses; ux > 0; ux--) {
+        if (pxAlocador->xClasses[ux - 1].pvLivres != NULL)
+            return pxAlocador->xClasses[ux - 1].xTamanho;
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t AlocadorObterEstatisticas(const Alocador_t* pxAlocador, EstatisticaClasse_t* pxEstatisticas,
+                                      UBaseType_t uxMax)
+{
+    UBaseType_t uxCopiadas = 0;
+
+    vTaskSuspendAll();
+    {
+        for (; uxCopiadas < pxAlocador->uxNumClasses && uxCopiadas < uxMax; uxCopiadas++) {
+            const ClassePool_t* pxClasse = &pxAlocador->xClasses[uxCopiadas];
+
+            pxEstatisticas[uxCopiadas].xTamanho = pxClasse->xTamanho;
+            pxEstatisticas[uxCopiadas].uxBlocos = pxClasse->uxBlocos;
+            pxEstatisticas[uxCopiadas].uxEmUso = pxClasse->uxEmUso;
+            pxEstatisticas[uxCopiadas].uxMaximo = pxClasse->uxMaximo;
+            pxEstatisticas[uxCopiadas].ulAlocacoes = pxClasse->ulAlocacoes;
+            pxEstatisticas[uxCopiadas].ulTransbordos = pxClasse->ulTransbordos;
+            pxEstatisticas[uxCopiadas].ulFalhas = pxClasse->ulFalhas;
+        }
+    }
+    (void)xTaskResumeAll();
+
+    return uxCopiadas;
+}
+/*-----------------------------------------------------------*/
+
+void AlocadorImprimir(const Alocador_t* pxAlocador, const char* pcPrefixo)
+{
+    EstatisticaClasse_t xClasses[alocadorMAX_CLASSES];
+    UBaseType_t uxClasses = AlocadorObterEstatisticas(pxAlocador, xClasses, alocadorMAX_CLASSES);
+
+    for (UBaseType_t ux = 0; ux < uxClasses; ux++) {
+        printf("%s classe %4u bytes: %3u blocos, em uso %3u, maximo %3u, alocacoes %8lu, transbordos %lu, falhas %lu\n",
+               pcPrefixo,
+               (unsigned)xClasses[ux].xTamanho,
+               (unsigned)xClasses[ux].uxBlocos,
+               (unsigned)xClasses[ux].uxEmUso,
+               (unsigned)xClasses[ux].uxMaximo,
+               (unsigned long)xClasses[ux].ulAlocacoes,
+               (unsigned long)xClasses[ux].ulTransbordos,
+               (unsigned long)xClasses[ux].ulFalhas);
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvIniciarSistema(void)
+{
+    BaseType_t xOk;
+
+    xOk = AlocadorInicializar(&xSistema, ullArenaSistema, sizeof(ullArenaSistema),
+                              xClassesSistema, uxNumClassesSistema);
+    configASSERT(xOk == pdPASS);
+    (void)xOk;
+
+    xSistemaIniciado = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvGravarAlocacao(size_t xTamanho, void* pv)
+{
+    if (pv == NULL || uxOperacoes >= alocadorMAX_OPERACOES)
+        return;
+
+    xSequencia[uxOperacoes].ulTamanho = (uint32_t)xTamanho;
+    xSequencia[uxOperacoes].usAlocacao = (uint16_t)uxAlocacoesGravadas;
+    uxOperacoes++;
+    pvGravados[uxAlocacoesGravadas++] = pv;
+}
+/*-----------------------------------------------------------*/
+
+static void prvGravarLiberacao(void* pv)
+{
+    /* Busca linear, mas so enquanto a sequencia nao enche. */
+    if (uxOperacoes >= alocadorMAX_OPERACOES)
+        return;
+
+    for (UBaseType_t ux = 0; ux < uxAlocacoesGravadas; ux++) {
+        if (pvGravados[ux] == pv) {
+            xSequencia[uxOperacoes].ulTamanho = 0;
+            xSequencia[uxOperacoes].usAlocacao = (uint16_t)ux;
+            uxOperacoes++;
+            pvGravados[ux] = NULL;
+            return;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+Alocador_t* AlocadorSistema(void)
+{
+    vTaskSuspendAll();
+    {
+        if (!xSistemaIniciado)
+            prvIniciarSistema();
+    }
+    (void)xTaskResumeAll();
+
+    return &xSistema;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t AlocadorCopiarSequencia(OperacaoAlocador_t* pxDestino, UBaseType_t uxMax)
+{
+    UBaseType_t uxCopiadas;
+
+    vTaskSuspendAll();
+    {
+        uxCopiadas = uxOperacoes < uxMax ? uxOperacoes : uxMax;
+        memcpy(pxDestino, xSequencia, uxCopiadas * sizeof(OperacaoAlocador_t));
+    }
+    (void)xTaskResumeAll();
+
+    return uxCopiadas;
+}
+/*-----------------------------------------------------------*/
+
+/* Interface de portable.h, no lugar de heap_5.c. */
+
+void* pvPortMalloc(size_t xWantedSize)
+{
+    void* pvReturn;
+
+    vTaskSuspendAll();
+    {
+        if (!xSistemaIniciado)
+            prvIniciarSistema();
+
+        pvReturn = pvAlocadorAlocar(&xSistema, xWantedSize);
+        prvGravarAlocacao(xWantedSize, pvReturn);
+
+        /* O tamanho do bloco, como no traceFREE(): as contas do recorder
+         * fecham.  Na falha, o tamanho pedido. */
+        traceMALLOC(pvReturn, pvReturn != NULL ? xAlocadorTamanhoBloco(&xSistema, pvReturn) : xWantedSize);
+    }
+    (void)xTaskResumeAll();
+
+#if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    {
+        if (pvReturn == NULL && xWantedSize > 0) {
+            extern void vApplicationMallocFailedHook(void);
+
+            vApplicationMallocFailedHook();
+        }
+    }
+#endif
+
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree(void* pv)
+{
+    if (pv == NULL)
+        return;
+
+    vTaskSuspendAll();
+    {
+        traceFREE(pv, xAlocadorTamanhoBloco(&xSistema, pv));
+        prvGravarLiberacao(pv);
+        vAlocadorLiberar(&xSistema, pv);
+        xLiberacoesSistema++;
+    }
+    (void)xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void* pvPortCalloc(size_t xNum, size_t xSize)
+{
+    void* pv = NULL;
+
+    if (xSize == 0 || xNum <= (size_t)-1 / xSize) {
+        pv = pvPortMalloc(xNum * xSize);
+        if (pv != NULL)
+            memset(pv, 0, xNum * xSize);
+    }
+
+    return pv;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize(void)
+{
+    return AlocadorSistema()->xLivres;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize(void)
+{
+    return AlocadorSistema()->xMinimoLivres;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks(void)
+{
+    /* As classes sao montadas na primeira alocacao. */
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats(HeapStats_t* pxHeapStats)
+{
+    Alocador_t* pxAlocador = AlocadorSistema();
+    size_t xMenor = 0;
+    size_t xBlocosLivres = 0;
+    size_t xAlocacoes = 0;
+
+    vTaskSuspendAll();
+    {
+        for (UBaseType_t ux = 0; ux < pxAlocador->uxNumClasses; ux++) {
+            const ClassePool_t* pxClasse = &pxAlocador->xClasses[ux];
+
+            xBlocosLivres += pxClasse->uxBlocos - pxClasse->uxEmUso;
+            xAlocacoes += pxClasse->ulAlocacoes;
+            if (xMenor == 0 && pxClasse->pvLivres != NULL)
+                xMenor = pxClasse->xTamanho;
+        }
+
+        pxHeapStats->xAvailableHeapSpaceInBytes = pxAlocador->xLivres;
+        pxHeapStats->xSizeOfLargestFreeBlockInBytes = xAlocadorMaiorLivre(pxAlocador);
+        pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMenor;
+        pxHeapStats->xNumberOfFreeBlocks = xBlocosLivres;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = pxAlocador->xMinimoLivres;
+        pxHeapStats->xNumberOfSuccessfulAllocations = xAlocacoes;
+        pxHeapStats->xNumberOfSuccessfulFrees = xLiberacoesSistema;
+    }
+    (void)xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
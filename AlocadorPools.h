@@ -0,0 +1,113 @@
+#ifndef ALOCADOR_POOLS_H
+#define ALOCADOR_POOLS_H
+
+/*
+ * Alocador por classes de tamanho, usado no lugar do heap_5 por pvPortMalloc()
+ * e vPortFree().
+ *
+ * A arena e dividida na inicializacao em classes de blocos de tamanho fixo.
+ * Cada classe guarda seus blocos livres numa lista encadeada pelos proprios
+ * blocos, entao alocar e liberar so tiram ou poem um bloco no inicio da lista.
+ * O pedido acha a sua classe por uma tabela indexada pelo tamanho, e a
+ * liberacao acha a classe pela faixa de enderecos.  Um bloco volta sempre para
+ * a sua classe: nao ha fragmentacao externa, so a sobra dentro do bloco.
+ *
+ * As classes seguem o que o gateway aloca de fato (TCBs, pilhas de
+ * configMINIMAL_STACK_SIZE, mutexes e grupos de eventos, ver main.c), mais
+ * algumas genericas.  Quando a classe do pedido esgota, o bloco sai da menor
+ * classe maior que ainda tenha bloco livre, e o transbordo e contado.
+ *
+ * As primeiras alocacoes e liberacoes do sistema sao gravadas para o
+ * benchmark de heap reproduzir a sequencia real (ver Benchmarks.h).
+ */
+
+#include "FreeRTOS.h"
+
+/* Granularidade da tabela de tamanho para classe e maior pedido atendido. */
+#define alocadorGRANULARIDADE           8
+#define alocadorMAIOR_BLOCO             4096
+#define alocadorMAX_CLASSES             16
+
+/* Operacoes gravadas da sequencia real. */
+#define alocadorMAX_OPERACOES           256
+
+typedef struct {
+    size_t xTamanho;
+    UBaseType_t uxBlocos;
+} ConfigClasse_t;
+
+typedef struct {
+    uint8_t* pucInicio;
+    uint8_t* pucFim;
+    void* pvLivres;                 /* Lista de blocos livres */
+    size_t xTamanho;                /* Do bloco, ja arredondado */
+    UBaseType_t uxBlocos;
+    UBaseType_t uxEmUso;
+    UBaseType_t uxMaximo;           /* Maior uxEmUso ja visto */
+    uint32_t ulAlocacoes;
+    uint32_t ulTransbordos;         /* Pedidos desta classe servidos por uma maior */
+    uint32_t ulFalhas;              /* Pedidos desta classe sem bloco em nenhuma */
+} ClassePool_t;
+
+typedef struct {
+    ClassePool_t xClasses[alocadorMAX_CLASSES];
+    UBaseType_t uxNumClasses;
+    uint8_t ucClassePorTamanho[alocadorMAIOR_BLOCO / alocadorGRANULARIDADE + 1];
+    size_t xLivres;
+    size_t xMinimoLivres;
+    uint32_t ulGrandesDemais;       /* Pedidos acima da maior classe */
+} Alocador_t;
+
+typedef struct {
+    size_t xTamanho;
+    UBaseType_t uxBlocos;
+    UBaseType_t uxEmUso;
+    UBaseType_t uxMaximo;
+    uint32_t ulAlocacoes;
+    uint32_t ulTransbordos;
+    uint32_t ulFalhas;
+} EstatisticaClasse_t;
+
+/* Uma operacao da sequencia gravada: alocacao de ulTamanho bytes, ou liberacao
+ * (ulTamanho 0) da alocacao de numero usAlocacao. */
+typedef struct {
+    uint32_t ulTamanho;
+    uint16_t usAlocacao;
+} OperacaoAlocador_t;
+
+/* Classes do alocador do sistema, usadas tambem pelo benchmark. */
+extern const ConfigClasse_t xClassesSistema[];
+extern const UBaseType_t uxNumClassesSistema;
+
+/* Divide a arena nas classes de pxConfig, em qualquer ordem; tamanhos que
+ * arredondam para o mesmo bloco sao juntados.  Retorna pdFAIL se as classes
+ * nao cabem na arena. */
+BaseType_t AlocadorInicializar(Alocador_t* pxAlocador, void* pvArena, size_t xTamanhoArena,
+                               const ConfigClasse_t* pxConfig, UBaseType_t uxNumClasses);
+
+/* Sem protecao propria: o chamador serializa o acesso a cada instancia. */
+void* pvAlocadorAlocar(Alocador_t* pxAlocador, size_t xTamanho);
+void vAlocadorLiberar(Alocador_t* pxAlocador, void* pv);
+
+/* Tamanho do bloco que contem pv, ou 0 se pv nao e da arena. */
+size_t xAlocadorTamanhoBloco(const Alocador_t* pxAlocador, const void* pv);
+
+/* Maior bloco livre: o da maior classe que ainda tem algum. */
+size_t xAlocadorMaiorLivre(const Alocador_t* pxAlocador);
+
+UBaseType_t AlocadorObterEstatisticas(const Alocador_t* pxAlocador, EstatisticaClasse_t* pxEstatisticas,
+                                      UBaseType_t uxMax);
+
+/* Instancia usada por pvPortMalloc()/vPortFree(). */
+Alocador_t* AlocadorSistema(void);
+
+/* Copia a sequencia gravada do sistema e retorna quantas operacoes copiou. */
+UBaseType_t AlocadorCopiarSequencia(OperacaoAlocador_t* pxDestino, UBaseType_t uxMax);
+
+/* Imprime as estatisticas por classe, cada linha com o prefixo dado. */
+void AlocadorImprimir(const Alocador_t* pxAlocador, const char* pcPrefixo);
+
+/* Bytes da arena do sistema e da sequencia gravada, para o orcamento de RAM. */
+extern const size_t xRamAlocador;
+
+#endif /* ALOCADOR_POOLS_H */
@@ -0,0 +1,168 @@
+/*
+ * Periodo de amostragem adaptativo.  Ver AmostragemAdaptativa.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "AmostragemAdaptativa.h"
+
+typedef struct {
+    EstatisticaAmostragem_t xEstatisticas;
+    TickType_t xPrimeiraAmostra;
+    TickType_t xInicioEstavel;      /* Inicio da janela sem mudanca */
+} EstadoAmostragem_t;
+
+static const ConfigAmostragem_t* pxConfigs;
+static EstadoAmostragem_t xEstados[NUM_SENSORES];
+
+static const char* const pcNomes[NUM_SENSORES] = {
+    "presenca", "temperatura", "tensao", "particulas", "gas"
+};
+
+/*-----------------------------------------------------------*/
+
+void AmostragemInicializar(const ConfigAmostragem_t* pxConfig)
+{
+    configASSERT(pxConfig != NULL);
+
+    for (UBaseType_t ux = 0; ux < NUM_SENSORES; ux++) {
+        configASSERT(pxConfig[ux].xPeriodoMinimo > 0);
+        configASSERT(pxConfig[ux].xPeriodoMinimo <= pxConfig[ux].xPeriodoBase);
+        configASSERT(pxConfig[ux].xPeriodoBase <= pxConfig[ux].xPeriodoMaximo);
+
+        xEstados[ux].xEstatisticas.xPeriodo = pxConfig[ux].xPeriodoBase;
+        xEstados[ux].xEstatisticas.xMenorPeriodo = pxConfig[ux].xPeriodoBase;
+        xEstados[ux].xEstatisticas.xMaiorPeriodo = pxConfig[ux].xPeriodoBase;
+    }
+
+    pxConfigs = pxConfig;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvPertoLimiar(const ConfigAmostragem_t* pxConfig, int32_t lPiorValor)
+{
+    switch (pxConfig->eLimiar) {
+    /* Estrito, como os alarmes dos modulos: margem 0 e so o alarme. */
+    case LIMIAR_ACIMA:
+        return lPiorValor > pxConfig->lLimiar - pxConfig->lMargemLimiar;
+    case LIMIAR_ABAIXO:
+        return lPiorValor < pxConfig->lLimiar + pxConfig->lMargemLimiar;
+    default:
+        return pdFALSE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+TickType_t AmostragemRegistrar(Sensor_t eSensor, int32_t lMaiorDelta, int32_t lPiorValor)
+{
+    const ConfigAmostragem_t* pxConfig = &pxConfigs[eSensor];
+    EstadoAmostragem_t* pxEstado = &xEstados[eSensor];
+    EstatisticaAmostragem_t* pxEstatisticas = &pxEstado->xEstatisticas;
+    TickType_t xAgora = xTaskGetTickCount();
+    TickType_t xPeriodo;
+    BaseType_t xPerto = prvPertoLimiar(pxConfig, lPiorValor);
+
+    if (lMaiorDelta < 0)
+        lMaiorDelta = -lMaiorDelta;
+
+    vTaskSuspendAll();
+    {
+        xPeriodo = pxEstatisticas->xPeriodo;
+
+        if (pxEstatisticas->ulAmostras++ == 0) {
+            pxEstado->xPrimeiraAmostra = xAgora;
+            pxEstado->xInicioEstavel = xAgora;
+        }
+        pxEstatisticas->xDecorrido = xAgora - pxEstado->xPrimeiraAmostra;
+
+        if (xPerto || lMaiorDelta >= pxConfig->lDeltaGrande) {
+            xPeriodo = pxConfig->xPeriodoMinimo;
+            pxEstado->xInicioEstavel = xAgora;
+        }
+        else if (lMaiorDelta <= pxConfig->lDeltaEstavel) {
+            if (xAgora - pxEstado->xInicioEstavel >= pxConfig->xJanelaEstavel) {
+                xPeriodo = xPeriodo >= pxConfig->xPeriodoMaximo / 2 ? pxConfig->xPeriodoMaximo : xPeriodo * 2;
+                pxEstado->xInicioEstavel = xAgora;
+            }
+        }
+        else {
+            /* Acima da base volta a ela; abaixo, depois de uma mudanca grande,
+             * dobra ate ela. */
+            if (xPeriodo > pxConfig->xPeriodoBase / 2)
+                xPeriodo = pxConfig->xPeriodoBase;
+            else
+                xPeriodo *= 2;
+            pxEstado->xInicioEstavel = xAgora;
+        }
+
+        if (xPerto)
+            pxEstatisticas->ulPertoLimiar++;
+        if (xPeriodo < pxEstatisticas->xPeriodo)
+            pxEstatisticas->ulAceleracoes++;
+        else if (xPeriodo > pxEstatisticas->xPeriodo)
+            pxEstatisticas->ulDesaceleracoes++;
+
+        if (xPeriodo < pxEstatisticas->xMenorPeriodo)
+            pxEstatisticas->xMenorPeriodo = xPeriodo;
+        if (xPeriodo > pxEstatisticas->xMaiorPeriodo)
+            pxEstatisticas->xMaiorPeriodo = xPeriodo;
+        pxEstatisticas->xPeriodo = xPeriodo;
+    }
+    (void)xTaskResumeAll();
+
+    return xPeriodo;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t AmostragemObter(Sensor_t eSensor, EstatisticaAmostragem_t* pxEstatisticas)
+{
+    if (pxConfigs == NULL || eSensor >= NUM_SENSORES)
+        return pdFAIL;
+
+    vTaskSuspendAll();
+    {
+        *pxEstatisticas = xEstados[eSensor].xEstatisticas;
+    }
+    (void)xTaskResumeAll();
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void AmostragemExportar(void)
+{
+    EstatisticaAmostragem_t xEstatisticas;
+
+    for (UBaseType_t ux = 0; ux < NUM_SENSORES; ux++) {
+        unsigned long long ullMs, ullFixas;
+
+        if (AmostragemObter((Sensor_t)ux, &xEstatisticas) != pdPASS)
+            return;
+
+        ullMs = (unsigned long long)xEstatisticas.xDecorrido * portTICK_PERIOD_MS;
+        if (ullMs == 0)
+            ullMs = 1;
+
+        /* O periodo base teria amostrado uma vez a cada xPeriodoBase ticks. */
+        ullFixas = (unsigned long long)xEstatisticas.xDecorrido / pxConfigs[ux].xPeriodoBase + 1;
+
+        printf("[amostragem] %-11s %6llu/min (fixo %6llu/min, %3lld%%)  periodo %4lu ms [%lu..%lu]  aceleracoes %lu  desaceleracoes %lu  perto do limiar %lu\n",
+               pcNomes[ux],
+               (unsigned long long)xEstatisticas.ulAmostras * 60000ULL / ullMs,
+               60000ULL / ((unsigned long long)pxConfigs[ux].xPeriodoBase * portTICK_PERIOD_MS),
+               (long long)xEstatisticas.ulAmostras * 100LL / (long long)ullFixas,
+               (unsigned long)(xEstatisticas.xPeriodo * portTICK_PERIOD_MS),
+               (unsigned long)(xEstatisticas.xMenorPeriodo * portTICK_PERIOD_MS),
+               (unsigned long)(xEstatisticas.xMaiorPeriodo * portTICK_PERIOD_MS),
+               (unsigned long)xEstatisticas.ulAceleracoes,
+               (unsigned long)xEstatisticas.ulDesaceleracoes,
+               (unsigned long)xEstatisticas.ulPertoLimiar);
+    }
+    printf("\n");
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,70 @@
+#ifndef AMOSTRAGEM_ADAPTATIVA_H
+#define AMOSTRAGEM_ADAPTATIVA_H
+
+/*
+ * Periodo de amostragem adaptativo por modulo sensor, ligado por
+ * mainAMOSTRAGEM_ADAPTATIVA em main.c.
+ *
+ * Ao fim de cada varredura o modulo informa a maior mudanca entre duas
+ * amostras de uma mesma zona e o pior valor entre as zonas (o mais perto do
+ * limiar de alarme), e recebe o periodo ate a proxima varredura:
+ *
+ *  - mudanca de pelo menos lDeltaGrande, ou pior valor alem do limiar ou a
+ *    menos de lMargemLimiar dele: vai direto ao periodo minimo;
+ *  - mudanca de no maximo lDeltaEstavel por xJanelaEstavel ticks seguidos:
+ *    dobra o periodo, ate o maximo, e recomeca a janela;
+ *  - mudanca intermediaria: recomeca a janela e volta ao periodo base, direto
+ *    se estiver acima dele e dobrando se estiver abaixo.
+ *
+ * Cada modulo escreve so o seu estado; a leitura das estatisticas suspende o
+ * escalonador.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Gateway.h"
+
+typedef enum {
+    LIMIAR_NENHUM = 0,
+    LIMIAR_ACIMA,                   /* Alarme com o valor acima de lLimiar (estrito) */
+    LIMIAR_ABAIXO                   /* Alarme com o valor abaixo de lLimiar (estrito) */
+} SentidoLimiar_t;
+
+typedef struct {
+    TickType_t xPeriodoMinimo;
+    TickType_t xPeriodoBase;        /* O periodo fixo; usado na partida */
+    TickType_t xPeriodoMaximo;
+    TickType_t xJanelaEstavel;
+    int32_t lDeltaEstavel;
+    int32_t lDeltaGrande;
+    SentidoLimiar_t eLimiar;
+    int32_t lLimiar;
+    int32_t lMargemLimiar;
+} ConfigAmostragem_t;
+
+typedef struct {
+    TickType_t xPeriodo;            /* Atual */
+    TickType_t xMenorPeriodo;       /* Usados desde a partida */
+    TickType_t xMaiorPeriodo;
+    uint32_t ulAmostras;
+    uint32_t ulAceleracoes;         /* Reducoes do periodo */
+    uint32_t ulDesaceleracoes;      /* Janelas estaveis que dobraram o periodo */
+    uint32_t ulPertoLimiar;         /* Amostras a lMargemLimiar do limiar ou alem */
+    TickType_t xDecorrido;          /* Desde a primeira amostra */
+} EstatisticaAmostragem_t;
+
+/* pxConfig: uma entrada por Sensor_t, valida durante toda a execucao. */
+void AmostragemInicializar(const ConfigAmostragem_t* pxConfig);
+
+/* Chamada pelo modulo ao fim de cada varredura.  Retorna o periodo, em ticks,
+ * ate a proxima. */
+TickType_t AmostragemRegistrar(Sensor_t eSensor, int32_t lMaiorDelta, int32_t lPiorValor);
+
+/* Retorna pdFAIL sem AmostragemInicializar(). */
+BaseType_t AmostragemObter(Sensor_t eSensor, EstatisticaAmostragem_t* pxEstatisticas);
+
+/* Imprime a taxa efetiva de cada sensor contra a do periodo base. */
+void AmostragemExportar(void);
+
+#endif /* AMOSTRAGEM_ADAPTATIVA_H */
@@ -0,0 +1,141 @@
+/*
+ * Buffer circular SPSC de amostras.  Ver AnelAmostras.h.
+ *
+ * Os indices sao contadores livres de 32 bits; a posicao no vetor e o indice
+ * mascarado.  A cabeca aponta para a proxima posicao a ser escrita, portanto a
+ * amostra mais recente esta em ulCabeca - 1.
+ */
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "AnelAmostras.h"
+
+/*-----------------------------------------------------------*/
+
+void AnelInicializar(AnelAmostras_t* pxAnel, Amostra_t* pxArmazenamento, uint32_t ulProfundidade)
+{
+    /* Potencia de 2 para que o indice seja obtido com uma mascara. */
+    configASSERT(ulProfundidade >= anelPROFUNDIDADE_MINIMA);
+    configASSERT((ulProfundidade & (ulProfundidade - 1)) == 0);
+
+    pxAnel->ulCabeca = 0;
+    pxAnel->ulCauda = 0;
+    pxAnel->ulPerdidas = 0;
+    pxAnel->ulMascara = ulProfundidade - 1;
+    pxAnel->pxAmostras = pxArmazenamento;
+}
+/*-----------------------------------------------------------*/
+
+void AnelPublicar(AnelAmostras_t* pxAnel, int32_t lValor)
+{
+    uint32_t ulCabeca = pxAnel->ulCabeca;
+    Amostra_t* pxPosicao = &pxAnel->pxAmostras[ulCabeca & pxAnel->ulMascara];
+
+    pxPosicao->xTick = xTaskGetTickCount();
+    pxPosicao->lValor = lValor;
+
+    /* A amostra precisa estar completa antes de ficar visivel. */
+    atomicoBARREIRA_LIBERAR();
+    pxAnel->ulCabeca = ulCabeca + 1;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t AnelUltimas(const AnelAmostras_t* pxAnel, Amostra_t* pxAtual, Amostra_t* pxAnterior)
+{
+    uint32_t ulCabeca, ulCabecaDepois;
+    uint32_t ulMascara = pxAnel->ulMascara;
+    UBaseType_t uxCopiadas;
+
+    do {
+        ulCabeca = pxAnel->ulCabeca;
+        atomicoBARREIRA_ADQUIRIR();
+
+        uxCopiadas = 0;
+
+        if (ulCabeca >= 1) {
+            *pxAtual = pxAnel->pxAmostras[(ulCabeca - 1) & ulMascara];
+            uxCopiadas++;
+        }
+
+        if (ulCabeca >= 2) {
+            *pxAnterior = pxAnel->pxAmostras[(ulCabeca - 2) & ulMascara];
+            uxCopiadas++;
+        }
+
+        atomicoBARREIRA_ADQUIRIR();
+        ulCabecaDepois = pxAnel->ulCabeca;
+
+        /* A posicao de ulCabeca - 2 so e reescrita quando o produtor chega a
+         * ulCabeca - 2 + profundidade; antes disso a copia e consistente. */
+    } while ((ulCabecaDepois - ulCabeca) >= ulMascara - 1);
+
+    return uxCopiadas;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t AnelConsumir(AnelAmostras_t* pxAnel, Amostra_t* pxAmostra)
+{
+    uint32_t ulCauda = pxAnel->ulCauda;
+    uint32_t ulCabeca;
+
+    for (;;) {
+        ulCabeca = pxAnel->ulCabeca;
+        atomicoBARREIRA_ADQUIRIR();
+
+        if (ulCabeca == ulCauda)
+            return pdFALSE;
+
+        /* O produtor deu a volta: descarta o que ja foi sobrescrito e deixa
+         * uma posicao de folga para a escrita em andamento. */
+        if ((ulCabeca - ulCauda) > pxAnel->ulMascara) {
+            pxAnel->ulPerdidas += (ulCabeca - ulCauda) - pxAnel->ulMascara;
+            ulCauda = ulCabeca - pxAnel->ulMascara;
+        }
+
+        *pxAmostra = pxAnel->pxAmostras[ulCauda & pxAnel->ulMascara];
+
+        atomicoBARREIRA_ADQUIRIR();
+
+        /* Se o produtor alcancou a posicao durante a copia, tenta de novo. */
+        if ((pxAnel->ulCabeca - ulCauda) <= pxAnel->ulMascara)
+            break;
+    }
+
+    atomicoBARREIRA_LIBERAR();
+    pxAnel->ulCauda = ulCauda + 1;
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t AnelPosicaoLivre(const AnelAmostras_t* pxAnel)
+{
+    return pxAnel->ulCabeca & pxAnel->ulMascara;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t AnelConsumirUltimas(AnelAmostras_t* pxAnel, Amostra_t* pxAtual, uint32_t* pulAtual, uint32_t* pulAnterior)
+{
+    uint32_t ulCabeca = pxAnel->ulCabeca;
+    uint32_t ulCauda = pxAnel->ulCauda;
+
+    configASSERT(ulCabeca > 0);
+    atomicoBARREIRA_ADQUIRIR();
+
+    *pulAtual = (ulCabeca - 1) & pxAnel->ulMascara;
+    *pulAnterior = (ulCabeca - 2) & pxAnel->ulMascara;
+    *pxAtual = pxAnel->pxAmostras[*pulAtual];
+
+    if (ulCabeca == ulCauda)
+        return pdFALSE;
+
+    pxAnel->ulPerdidas += ulCabeca - ulCauda - 1;
+
+    atomicoBARREIRA_LIBERAR();
+    pxAnel->ulCauda = ulCabeca;
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
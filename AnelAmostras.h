@@ -0,0 +1,73 @@
+#ifndef ANEL_AMOSTRAS_H
+#define ANEL_AMOSTRAS_H
+
+/*
+ * Buffer circular sem trava de um produtor e um consumidor (SPSC) de amostras.
+ * Cada gerador de main.c publica no anel do seu sensor e o modulo sensor
+ * consome a geracao mais recente.
+ *
+ * - O produtor nunca bloqueia: quando o anel esta cheio a amostra mais antiga
+ *   e sobrescrita e contada como perdida para o consumidor.
+ * - A cabeca e escrita apenas pelo produtor e a cauda apenas pelo consumidor,
+ *   cada uma na sua propria linha de cache.
+ * - AnelUltimas() devolve a amostra mais recente e a anterior em O(1), sem
+ *   consumir nada; AnelConsumir() le as amostras em ordem FIFO.
+ * - Uma amostra pode ter dados fora do anel, em vetores paralelos de
+ *   ulProfundidade linhas: o produtor escreve a linha de AnelPosicaoLivre()
+ *   antes de publicar e o consumidor le as linhas de AnelConsumirUltimas().
+ */
+
+#include "FreeRTOS.h"
+
+#include "Atomico.h"
+
+/* Profundidade minima: AnelUltimas() precisa que o produtor possa escrever ao
+ * menos uma amostra enquanto as duas ultimas sao copiadas. */
+#define anelPROFUNDIDADE_MINIMA    4
+
+typedef struct {
+    TickType_t xTick;
+    int32_t lValor;
+} Amostra_t;
+
+typedef struct {
+    /* Escrito apenas pelo produtor. */
+    volatile uint32_t ulCabeca;
+    uint8_t ucPreenchimentoCabeca[atomicoLINHA_CACHE - sizeof(uint32_t)];
+
+    /* Escritos apenas pelo consumidor. */
+    volatile uint32_t ulCauda;
+    uint32_t ulPerdidas;
+    uint8_t ucPreenchimentoCauda[atomicoLINHA_CACHE - 2 * sizeof(uint32_t)];
+
+    /* Constantes apos AnelInicializar(). */
+    uint32_t ulMascara;
+    Amostra_t* pxAmostras;
+} AnelAmostras_t;
+
+/* ulProfundidade deve ser potencia de 2 e no minimo anelPROFUNDIDADE_MINIMA;
+ * pxArmazenamento deve ter ulProfundidade posicoes. */
+void AnelInicializar(AnelAmostras_t* pxAnel, Amostra_t* pxArmazenamento, uint32_t ulProfundidade);
+
+/* Somente o produtor. */
+void AnelPublicar(AnelAmostras_t* pxAnel, int32_t lValor);
+
+/* Qualquer leitor.  Retorna quantas amostras foram copiadas (0, 1 ou 2);
+ * pxAnterior so e preenchida quando o retorno e 2. */
+UBaseType_t AnelUltimas(const AnelAmostras_t* pxAnel, Amostra_t* pxAtual, Amostra_t* pxAnterior);
+
+/* Somente o consumidor.  Retorna pdFALSE se nao ha amostra nova. */
+BaseType_t AnelConsumir(AnelAmostras_t* pxAnel, Amostra_t* pxAmostra);
+
+/* Somente o produtor: posicao que a proxima AnelPublicar() ocupa. */
+uint32_t AnelPosicaoLivre(const AnelAmostras_t* pxAnel);
+
+/* Somente o consumidor, depois da primeira publicacao.  Consome tudo o que foi
+ * publicado e devolve a amostra mais recente, a posicao dela e a da anterior,
+ * em O(1); as amostras puladas contam como perdidas.  As duas linhas ficam
+ * intactas enquanto o produtor publicar menos de ulProfundidade - 1 vezes.
+ * Retorna pdFALSE, com a mesma amostra da chamada anterior, se nada foi
+ * publicado desde entao. */
+BaseType_t AnelConsumirUltimas(AnelAmostras_t* pxAnel, Amostra_t* pxAtual, uint32_t* pulAtual, uint32_t* pulAnterior);
+
+#endif /* ANEL_AMOSTRAS_H */
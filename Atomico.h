@@ -0,0 +1,38 @@
+#ifndef ATOMICO_H
+#define ATOMICO_H
+
+/*
+ * Barreiras de memoria e operacoes atomicas usadas pelas estruturas sem trava
+ * do gateway.
+ *
+ * O simulador Windows roda em x86/x64, onde stores nao sao reordenados com
+ * outros stores nem loads com outros loads, entao basta impedir o compilador de
+ * reordenar os acessos.  Nas demais plataformas as barreiras do GCC geram as
+ * instrucoes necessarias.
+ */
+
+#if defined( _MSC_VER )
+    #include <intrin.h>
+    #define atomicoBARREIRA_LIBERAR()     _ReadWriteBarrier()
+    #define atomicoBARREIRA_ADQUIRIR()    _ReadWriteBarrier()
+#else
+    #define atomicoBARREIRA_LIBERAR()     __atomic_thread_fence( __ATOMIC_RELEASE )
+    #define atomicoBARREIRA_ADQUIRIR()    __atomic_thread_fence( __ATOMIC_ACQUIRE )
+#endif
+
+/* Troca *pulValor por ulNovo se ele ainda for ulEsperado, com barreira
+ * completa.  Verdadeiro se trocou.  Necessario quando ha mais de um produtor:
+ * no simulador uma tarefa pode ser suspensa entre a leitura e a escrita. */
+#if defined( _MSC_VER )
+    #define atomicoCOMPARAR_TROCAR( pulValor, ulEsperado, ulNovo ) \
+    ( _InterlockedCompareExchange( ( volatile long * ) ( pulValor ), ( long ) ( ulNovo ), ( long ) ( ulEsperado ) ) == ( long ) ( ulEsperado ) )
+#else
+    #define atomicoCOMPARAR_TROCAR( pulValor, ulEsperado, ulNovo ) \
+    __sync_bool_compare_and_swap( ( pulValor ), ( ulEsperado ), ( ulNovo ) )
+#endif
+
+/* Tamanho da linha de cache usado para separar indices escritos por tarefas
+ * diferentes e evitar falso compartilhamento. */
+#define atomicoLINHA_CACHE                64
+
+#endif /* ATOMICO_H */
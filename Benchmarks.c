@@ -0,0 +1,1020 @@
+/*
+ * Benchmarks do gateway.  Ver Benchmarks.h.
+ *
+ * Os tempos sao medidos com ulGetRunTimeCounterValue() e reportados em
+ * microssegundos.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* Gateway includes. */
+#include "Gateway.h"
+#include "AnelAmostras.h"
+#include "EstadoGateway.h"
+#include "ComandosAtuador.h"
+#include "MonitorPrazos.h"
+#include "PerfilTarefas.h"
+#include "Escalonador.h"
+#include "RegistroEventos.h"
+#include "SimuladorSensores.h"
+#include "TempoVirtual.h"
+#include "AlocadorPools.h"
+#include "HeapTarefas.h"
+#include "MonitorPilhas.h"
+#include "SonoOcioso.h"
+#include "AmostragemAdaptativa.h"
+#include "HeapReferencia.h"
+#include "Benchmarks.h"
+
+/* Duracao do soak e intervalo entre relatorios, em ticks. */
+#define benchSOAK_HORAS                 24
+#define benchSOAK_INTERVALO_RELATORIO   pdMS_TO_TICKS( 60UL * 60UL * 1000UL )
+
+/* Publicacoes feitas pelo produtor em cada modo do benchmark do anel, e quantas
+ * publicacoes ele faz antes de ceder a CPU ao consumidor por um tick. */
+#define benchANEL_OPERACOES             200000UL
+#define benchANEL_RAJADA                1000UL
+#define benchANEL_PROFUNDIDADE          8
+
+/* Duracao do benchmark de latencia de decisao. */
+#define benchDECISAO_MINUTOS            10
+
+/* Benchmark RM x EDF: tarefas sinteticas de periodos nao harmonicos, com a
+ * carga dividida igualmente entre elas, na faixa de prioridades 1 a 5 (acima
+ * fica so o controlador do benchmark e a tarefa de temporizadores). */
+#define benchEDF_TAREFAS                5
+#define benchEDF_SEGUNDOS               20
+#define benchEDF_PRIORIDADE_MINIMA      1
+#define benchEDF_PRIORIDADE_MAXIMA      5
+
+/* Benchmark de zonas: cada quantidade de zonas roda por benchZONAS_SEGUNDOS,
+ * depois de benchZONAS_ACOMODACAO_MS para as tarefas passarem a varrer as
+ * novas zonas. */
+#define benchZONAS_SEGUNDOS             10
+#define benchZONAS_ACOMODACAO_MS        3000
+
+/* Benchmark do registro: duracao de cada modo e espera antes de medir. */
+#define benchREGISTRO_SEGUNDOS          30
+#define benchREGISTRO_ACOMODACAO_MS     2000
+
+/* Benchmark do simulador: amostras sorteadas por distribuicao, e quantas
+ * sao comparadas entre dois simuladores de mesma semente. */
+#define benchSIMULACAO_AMOSTRAS         1000000UL
+#define benchSIMULACAO_COMPARADAS       100000UL
+#define benchSIMULACAO_SEMENTE          12345ULL
+
+/* Benchmark de heap: espera o gateway alocar o que aloca na partida, depois
+ * reproduz a sequencia gravada benchHEAP_REPETICOES vezes em cada alocador e
+ * faz benchHEAP_TROCAS liberacoes e alocacoes sorteadas sobre ela. */
+#define benchHEAP_ACOMODACAO_MS         2000
+#define benchHEAP_REPETICOES            2000UL
+#define benchHEAP_TROCAS                200000UL
+#define benchHEAP_SEMENTE               0x2545F491UL
+
+/* Benchmark do sono ocioso: duracao de cada modo e espera antes de medir. */
+#define benchSONO_SEGUNDOS              20
+#define benchSONO_ACOMODACAO_MS         2000
+
+/* Converte unidades do contador de run time para microssegundos. */
+#define benchRUN_TIME_PARA_US( x )      ( ( unsigned long long ) ( x ) * 1000ULL / gatewayRUN_TIME_POR_MS )
+
+static const char* const pcNomeSensor[NUM_SENSORES] = {
+    "Presenca", "Temperatura", "Tensao", "Particulas", "Gas"
+};
+
+/*-----------------------------------------------------------*/
+
+#if ( configSONO_OCIOSO == 1 )
+
+/* Ticks a mais (positivo) ou a menos no contador de ticks em relacao ao
+ * tempo real medido pelo contador de run time. */
+static long long prvDerivaTicks(TickType_t xTicks, configRUN_TIME_COUNTER_TYPE ulDuracao)
+{
+    return (long long)xTicks - (long long)(ulDuracao / (gatewayRUN_TIME_POR_MS * portTICK_PERIOD_MS));
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configSONO_OCIOSO */
+
+static void prvRelatorioSoak(int iHora, configRUN_TIME_COUNTER_TYPE ulInicio, TickType_t xTickInicio)
+{
+    EstatisticaEstado_t xEstado;
+    EstatisticaServidor_t xServidor;
+    EstatisticaComandos_t xComandos;
+    unsigned long long ullMediaEstado = 0, ullMediaResposta = 0;
+
+    printf("[soak] hora %d: heap livre %u bytes, minimo historico %u bytes, %lu tarefas\n",
+           iHora,
+           (unsigned)xPortGetFreeHeapSize(),
+           (unsigned)xPortGetMinimumEverFreeHeapSize(),
+           (unsigned long)uxTaskGetNumberOfTasks());
+    AlocadorImprimir(AlocadorSistema(), "[soak]  ");
+    HeapTarefasExportar();
+
+    /* O contador de run time mede tempo real tambem com o tempo virtual. */
+    printf("[soak]   tempo real decorrido %llu ms\n",
+           (unsigned long long)((ulGetRunTimeCounterValue() - ulInicio) / gatewayRUN_TIME_POR_MS));
+
+#if ( configSONO_OCIOSO == 1 )
+    /* Em horas de sono ocioso o contador de ticks deve seguir o tempo real;
+     * um erro por sono apareceria aqui como deriva crescente. */
+    printf("[soak]   deriva do tick %+lld ticks\n",
+           prvDerivaTicks(xTaskGetTickCount() - xTickInicio, ulGetRunTimeCounterValue() - ulInicio));
+#else
+    (void)xTickInicio;
+#endif
+
+#if ( configTEMPO_VIRTUAL == 1 )
+    {
+        EstatisticaTempoVirtual_t xTempo;
+
+        TempoVirtualObterEstatisticas(&xTempo);
+        printf("[soak]   tempo virtual: %llu ticks em %lu saltos, %lu ticks unitarios, %lu ticks reais ignorados\n",
+               (unsigned long long)xTempo.ullTicksSaltados,
+               (unsigned long)xTempo.ulSaltos,
+               (unsigned long)xTempo.ulTicksUnitarios,
+               (unsigned long)xTempo.ulTicksReaisIgnorados);
+    }
+#endif
+
+    for (int i = 0; i < NUM_SENSORES; i++) {
+        EstatisticaLatencia_t xCopia = xEstatisticaAmostragem[i];
+        unsigned long long ullMedia = 0;
+
+        if (xCopia.ulAmostras > 0)
+            ullMedia = xCopia.ullLatenciaTotal / xCopia.ulAmostras;
+
+        printf("[soak]   %-12s amostras %8lu  latencia media %8llu us  max %8llu us\n",
+               pcNomeSensor[i],
+               (unsigned long)xCopia.ulAmostras,
+               benchRUN_TIME_PARA_US(ullMedia),
+               benchRUN_TIME_PARA_US(xCopia.ullLatenciaMax));
+    }
+    AmostragemExportar();
+
+    EstadoObterEstatisticas(&xEstado);
+    if (xEstado.ulLeituras > 0)
+        ullMediaEstado = xEstado.ullLatenciaTotal / xEstado.ulLeituras;
+
+    printf("[soak]   estado: leituras %lu  repeticoes %lu  latencia media %llu us  max %llu us\n",
+           (unsigned long)xEstado.ulLeituras,
+           (unsigned long)xEstado.ulRepeticoes,
+           benchRUN_TIME_PARA_US(ullMediaEstado),
+           benchRUN_TIME_PARA_US(xEstado.ullLatenciaMax));
+
+    ServidorObterEstatisticas(&xServidorAtuadores, &xServidor);
+    if (xServidor.ulAtendidos > 0)
+        ullMediaResposta = xServidor.ullRespostaTotal / xServidor.ulAtendidos;
+    else
+        xServidor.ullRespostaMin = 0;
+
+    printf("[soak]   servidor: atendidos %lu  rejeitados %lu  esgotamentos %lu  consumido %llu us  resposta min %llu us  media %llu us  max %llu us\n",
+           (unsigned long)xServidor.ulAtendidos,
+           (unsigned long)xServidor.ulRejeitados,
+           (unsigned long)xServidor.ulEsgotamentos,
+           benchRUN_TIME_PARA_US(xServidor.ullConsumido),
+           benchRUN_TIME_PARA_US(xServidor.ullRespostaMin),
+           benchRUN_TIME_PARA_US(ullMediaResposta),
+           benchRUN_TIME_PARA_US(xServidor.ullRespostaMax));
+
+    ComandosObterEstatisticas(&xComandos);
+    printf("[soak]   comandos: enviados %lu  coalescidos %lu  rejeitados %lu  despacho max %llu us\n",
+           (unsigned long)xComandos.ulEnviados,
+           (unsigned long)xComandos.ulCoalescidos,
+           (unsigned long)xComandos.ulRejeitados,
+           benchRUN_TIME_PARA_US(xComandos.ullDespachoMax));
+
+    MonitorExportar();
+    PerfilExportar();
+    printf("\n");
+}
+/*-----------------------------------------------------------*/
+
+void BenchmarkSoakTask(void* pvParameters)
+{
+    TickType_t xProximoRelatorio = xTaskGetTickCount();
+    const TickType_t xTickInicio = xProximoRelatorio;
+    configRUN_TIME_COUNTER_TYPE ulInicio = ulGetRunTimeCounterValue();
+    size_t xHeapInicial;
+
+    (void)pvParameters;
+
+    /* O heap ja deve estar estavel quando o escalonador inicia: nenhuma tarefa
+     * e criada no caminho de amostragem. */
+    xHeapInicial = xPortGetFreeHeapSize();
+    prvRelatorioSoak(0, ulInicio, xTickInicio);
+
+    for (int iHora = 1; iHora <= benchSOAK_HORAS; iHora++) {
+        vTaskDelayUntil(&xProximoRelatorio, benchSOAK_INTERVALO_RELATORIO);
+        prvRelatorioSoak(iHora, ulInicio, xTickInicio);
+    }
+
+    printf("[soak] concluido: variacao do heap livre %ld bytes em %d horas\n\n",
+           (long)xPortGetFreeHeapSize() - (long)xHeapInicial, benchSOAK_HORAS);
+    PilhasExportar();
+
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+/* Estado compartilhado pelas tarefas do benchmark do anel. */
+static AnelAmostras_t xBenchAnel;
+static Amostra_t xBenchAmostras[benchANEL_PROFUNDIDADE];
+
+static SemaphoreHandle_t xBenchMutex;
+static int iBenchJanela[2], iBenchIndice;
+
+static volatile BaseType_t xBenchAtivo;
+static volatile uint32_t ulBenchLeituras;
+static configRUN_TIME_COUNTER_TYPE ulBenchPiorPublicacao, ulBenchPiorLeitura;
+static TaskHandle_t xBenchControlador;
+
+/*-----------------------------------------------------------*/
+
+static void prvPublicarComMutex(int iValor)
+{
+    /* Mesmo padrao usado antes nos modulos de presenca e temperatura. */
+    xSemaphoreTake(xBenchMutex, portMAX_DELAY);
+
+    if (iBenchIndice == 2) {
+        iBenchIndice = 1;
+        iBenchJanela[0] = iBenchJanela[1];
+    }
+
+    iBenchJanela[iBenchIndice] = iValor;
+    iBenchIndice++;
+
+    xSemaphoreGive(xBenchMutex);
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchProdutorTask(void* pvParameters)
+{
+    BaseType_t xUsarMutex = (BaseType_t)pvParameters;
+
+    for (uint32_t i = 0; i < benchANEL_OPERACOES; i++) {
+        configRUN_TIME_COUNTER_TYPE ulInicio = ulGetRunTimeCounterValue();
+        configRUN_TIME_COUNTER_TYPE ulDuracao;
+
+        if (xUsarMutex)
+            prvPublicarComMutex((int)i);
+        else
+            AnelPublicar(&xBenchAnel, (int32_t)i);
+
+        ulDuracao = ulGetRunTimeCounterValue() - ulInicio;
+        if (ulDuracao > ulBenchPiorPublicacao)
+            ulBenchPiorPublicacao = ulDuracao;
+
+        if ((i % benchANEL_RAJADA) == 0)
+            vTaskDelay(1);
+    }
+
+    xBenchAtivo = pdFALSE;
+    xTaskNotifyGive(xBenchControlador);
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchConsumidorTask(void* pvParameters)
+{
+    BaseType_t xUsarMutex = (BaseType_t)pvParameters;
+    Amostra_t xAtual, xAnterior;
+    volatile int iAtual, iAnterior;
+
+    while (xBenchAtivo) {
+        configRUN_TIME_COUNTER_TYPE ulInicio = ulGetRunTimeCounterValue();
+        configRUN_TIME_COUNTER_TYPE ulDuracao;
+
+        if (xUsarMutex) {
+            xSemaphoreTake(xBenchMutex, portMAX_DELAY);
+            iAnterior = iBenchJanela[0];
+            iAtual = iBenchJanela[1];
+            xSemaphoreGive(xBenchMutex);
+        }
+        else {
+            AnelUltimas(&xBenchAnel, &xAtual, &xAnterior);
+            iAtual = xAtual.lValor;
+            iAnterior = xAnterior.lValor;
+        }
+
+        ulDuracao = ulGetRunTimeCounterValue() - ulInicio;
+        if (ulDuracao > ulBenchPiorLeitura)
+            ulBenchPiorLeitura = ulDuracao;
+
+        ulBenchLeituras++;
+    }
+
+    (void)iAtual;
+    (void)iAnterior;
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+static void prvExecutarModoAnel(BaseType_t xUsarMutex, const char* pcNome)
+{
+    configRUN_TIME_COUNTER_TYPE ulInicio, ulDuracao;
+
+    AnelInicializar(&xBenchAnel, xBenchAmostras, benchANEL_PROFUNDIDADE);
+    iBenchIndice = 0;
+    ulBenchLeituras = 0;
+    ulBenchPiorPublicacao = 0;
+    ulBenchPiorLeitura = 0;
+    xBenchAtivo = pdTRUE;
+
+    ulInicio = ulGetRunTimeCounterValue();
+
+    /* Produtor acima do consumidor, como os modulos sensores em relacao ao
+     * PoolingServerTask. */
+    xTaskCreate(prvBenchConsumidorTask, "BenchCons", configMINIMAL_STACK_SIZE, (void*)xUsarMutex, 2, NULL);
+    xTaskCreate(prvBenchProdutorTask, "BenchProd", configMINIMAL_STACK_SIZE, (void*)xUsarMutex, 3, NULL);
+
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    ulDuracao = ulGetRunTimeCounterValue() - ulInicio;
+
+    /* Da tempo para o consumidor perceber o fim e se apagar. */
+    vTaskDelay(2);
+
+    if (ulDuracao == 0)
+        ulDuracao = 1;
+
+    printf("[anel] %-6s publicacoes/s %10llu  leituras/s %10llu  pior publicacao %6llu us  pior leitura %6llu us\n",
+           pcNome,
+           (unsigned long long)benchANEL_OPERACOES * gatewayRUN_TIME_POR_MS * 1000ULL / ulDuracao,
+           (unsigned long long)ulBenchLeituras * gatewayRUN_TIME_POR_MS * 1000ULL / ulDuracao,
+           benchRUN_TIME_PARA_US(ulBenchPiorPublicacao),
+           benchRUN_TIME_PARA_US(ulBenchPiorLeitura));
+}
+/*-----------------------------------------------------------*/
+
+void BenchmarkAnelTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    xBenchControlador = xTaskGetCurrentTaskHandle();
+    xBenchMutex = xSemaphoreCreateMutex();
+
+    prvExecutarModoAnel(pdTRUE, "mutex");
+    prvExecutarModoAnel(pdFALSE, "anel");
+
+    printf("\n");
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+static const TickType_t xPeriodosEDF[benchEDF_TAREFAS] = { 150, 210, 330, 470, 690 };
+
+/* Utilizacao total, em %. */
+static const uint32_t ulCargasEDF[] = { 50, 60, 70, 75, 80, 85, 90, 95, 100 };
+
+static configRUN_TIME_COUNTER_TYPE ulCustoEDF[benchEDF_TAREFAS];
+
+/* Ocupa a CPU ate a propria tarefa acumular ulCusto de run time. */
+static void prvConsumir(configRUN_TIME_COUNTER_TYPE ulCusto)
+{
+    configRUN_TIME_COUNTER_TYPE ulInicio = RunTimeTarefaAtual();
+
+    while (RunTimeTarefaAtual() - ulInicio < ulCusto)
+        ;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchCargaEDFTask(void* pvParameters)
+{
+    UBaseType_t uxIndice = (UBaseType_t)(uintptr_t)pvParameters;
+
+    for (;;) {
+        EscalonadorAguardarLiberacao();
+        prvConsumir(ulCustoEDF[uxIndice]);
+        EscalonadorConcluir();
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvExecutarRodadaEDF(PoliticaEscalonamento_t ePolitica, uint32_t ulCarga, EstatisticaEscalonador_t* pxEstatisticas)
+{
+    TaskHandle_t xTarefas[benchEDF_TAREFAS];
+    UBaseType_t uxPrioridade;
+
+    EscalonadorInicializar(ePolitica, benchEDF_PRIORIDADE_MINIMA, benchEDF_PRIORIDADE_MAXIMA);
+
+    for (UBaseType_t i = 0; i < benchEDF_TAREFAS; i++) {
+        /* Rate monotonic: periodos em ordem crescente, prioridades decrescentes */
+        uxPrioridade = benchEDF_PRIORIDADE_MAXIMA - i;
+        ulCustoEDF[i] = (configRUN_TIME_COUNTER_TYPE)xPeriodosEDF[i] * portTICK_PERIOD_MS * gatewayRUN_TIME_POR_MS *
+                        ulCarga / (100UL * benchEDF_TAREFAS);
+
+        xTaskCreate(prvBenchCargaEDFTask, "BenchCargaEDF", configMINIMAL_STACK_SIZE, (void*)(uintptr_t)i, uxPrioridade, &xTarefas[i]);
+        EscalonadorRegistrar(xTarefas[i], xPeriodosEDF[i], xPeriodosEDF[i], uxPrioridade);
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(benchEDF_SEGUNDOS * 1000UL));
+
+    EscalonadorObterEstatisticas(pxEstatisticas);
+    EscalonadorInicializar(ePolitica, benchEDF_PRIORIDADE_MINIMA, benchEDF_PRIORIDADE_MAXIMA);
+
+    for (UBaseType_t i = 0; i < benchEDF_TAREFAS; i++)
+        vTaskDelete(xTarefas[i]);
+
+    /* A tarefa ociosa libera a memoria das tarefas apagadas. */
+    vTaskDelay(pdMS_TO_TICKS(100));
+}
+/*-----------------------------------------------------------*/
+
+void BenchmarkEDFTask(void* pvParameters)
+{
+    EstatisticaEscalonador_t xRM, xEDF;
+
+    (void)pvParameters;
+
+    for (size_t i = 0; i < sizeof(ulCargasEDF) / sizeof(ulCargasEDF[0]); i++) {
+        prvExecutarRodadaEDF(ESCALONAMENTO_RM, ulCargasEDF[i], &xRM);
+        prvExecutarRodadaEDF(ESCALONAMENTO_EDF, ulCargasEDF[i], &xEDF);
+
+        printf("[edf] carga %3lu%%  RM: perdidos %5lu de %5lu (atraso max %4lu ms)  "
+               "EDF: perdidos %5lu de %5lu (atraso max %4lu ms, %lu trocas de prioridade)\n",
+               (unsigned long)ulCargasEDF[i],
+               (unsigned long)xRM.ulPrazosPerdidos, (unsigned long)xRM.ulLiberacoes,
+               (unsigned long)(xRM.xAtrasoMax * portTICK_PERIOD_MS),
+               (unsigned long)xEDF.ulPrazosPerdidos, (unsigned long)xEDF.ulLiberacoes,
+               (unsigned long)(xEDF.xAtrasoMax * portTICK_PERIOD_MS),
+               (unsigned long)xEDF.ulTrocasPrioridade);
+    }
+
+    printf("\n");
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+static void prvMedirDecisao(BaseType_t xPorEventos, const char* pcNome)
+{
+    TickType_t xInicio = xTaskGetTickCount();
+    EstatisticaLatencia_t xCopia;
+    unsigned long long ullMedia = 0;
+    unsigned long ulSegundos;
+
+    ControleSelecionarPolitica(xPorEventos);
+    vTaskDelay(pdMS_TO_TICKS(benchDECISAO_MINUTOS * 60UL * 1000UL));
+
+    xCopia = xLatenciaDecisao;
+    ulSegundos = (unsigned long)((xTaskGetTickCount() - xInicio) / configTICK_RATE_HZ);
+
+    if (xCopia.ulAmostras > 0)
+        ullMedia = xCopia.ullLatenciaTotal / xCopia.ulAmostras;
+
+    printf("[decisao] %-8s %lu s: decisoes %lu  latencia media %llu us  max %llu us  despertares do controlador %lu\n",
+           pcNome, ulSegundos,
+           (unsigned long)xCopia.ulAmostras,
+           benchRUN_TIME_PARA_US(ullMedia),
+           benchRUN_TIME_PARA_US(xCopia.ullLatenciaMax),
+           (unsigned long)ulDespertaresControle);
+}
+/*-----------------------------------------------------------*/
+
+void BenchmarkDecisaoTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    /* Por eventos por ultimo: o gateway continua na politica padrao. */
+    prvMedirDecisao(pdFALSE, "consulta");
+    prvMedirDecisao(pdTRUE, "eventos");
+    printf("\n");
+    AmostragemExportar();
+
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+/* Periodos dos modulos sensores em main.c, em ms. */
+static const uint32_t ulPeriodoSensorMs[NUM_SENSORES] = { 150, 250, 2000, 2000, 2000 };
+
+static const UBaseType_t uxZonasBenchmark[] = { 1, 100, 1000, 10000 };
+
+static uint32_t prvSomarZonasAmostradas(void)
+{
+    uint32_t ulTotal = 0;
+
+    for (int i = 0; i < NUM_SENSORES; i++)
+        ulTotal += ulZonasAmostradas[i];
+
+    return ulTotal;
+}
+/*-----------------------------------------------------------*/
+
+void BenchmarkZonasTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    for (int iRodada = 0; iRodada < sizeof(uxZonasBenchmark) / sizeof(uxZonasBenchmark[0]); iRodada++) {
+        UBaseType_t uxZonas = uxZonasBenchmark[iRodada];
+        EstatisticaLatencia_t xVarreduraInicio[NUM_SENSORES];
+        EstatisticaComandos_t xComandosInicio, xComandosFim;
+        uint32_t ulAmostrasInicio, ulDecisoesInicio;
+        unsigned long long ullAmostras, ullDecisoes, ullEsperadas = 0;
+        unsigned long long ullPiorVarredura = 0;
+        configRUN_TIME_COUNTER_TYPE ulInicio, ulDuracao;
+        int iPiorSensor = 0;
+
+        /* A nova quantidade vale a partir da proxima varredura de cada tarefa. */
+        uxNumZonas = uxZonas;
+        vTaskDelay(pdMS_TO_TICKS(benchZONAS_ACOMODACAO_MS));
+
+        for (int i = 0; i < NUM_SENSORES; i++)
+            xVarreduraInicio[i] = xEstatisticaAmostragem[i];
+        ComandosObterEstatisticas(&xComandosInicio);
+        ulAmostrasInicio = prvSomarZonasAmostradas();
+        ulDecisoesInicio = ulZonasDecididas;
+        ulInicio = ulGetRunTimeCounterValue();
+
+        vTaskDelay(pdMS_TO_TICKS(benchZONAS_SEGUNDOS * 1000UL));
+
+        ulDuracao = ulGetRunTimeCounterValue() - ulInicio;
+        ullAmostras = prvSomarZonasAmostradas() - ulAmostrasInicio;
+        ullDecisoes = ulZonasDecididas - ulDecisoesInicio;
+        ComandosObterEstatisticas(&xComandosFim);
+
+        /* Pior tempo medio de varredura entre os modulos, nesta rodada. */
+        for (int i = 0; i < NUM_SENSORES; i++) {
+            EstatisticaLatencia_t xCopia = xEstatisticaAmostragem[i];
+            uint32_t ulVarreduras = xCopia.ulAmostras - xVarreduraInicio[i].ulAmostras;
+
+            ullEsperadas += (unsigned long long)uxZonas * 1000ULL * benchZONAS_SEGUNDOS / ulPeriodoSensorMs[i];
+
+            if (ulVarreduras > 0) {
+                unsigned long long ullMedia = (xCopia.ullLatenciaTotal - xVarreduraInicio[i].ullLatenciaTotal) / ulVarreduras;
+                if (ullMedia > ullPiorVarredura) {
+                    ullPiorVarredura = ullMedia;
+                    iPiorSensor = i;
+                }
+            }
+        }
+
+        if (ulDuracao == 0)
+            ulDuracao = 1;
+
+        printf("[zonas] %5lu zonas: amostras/s %9llu (esperado %9llu)  decisoes/s %8llu  comandos aceitos %lu rejeitados %lu  varredura media %llu us (%s)\n",
+               (unsigned long)uxZonas,
+               ullAmostras * gatewayRUN_TIME_POR_MS * 1000ULL / ulDuracao,
+               ullEsperadas / benchZONAS_SEGUNDOS,
+               ullDecisoes * gatewayRUN_TIME_POR_MS * 1000ULL / ulDuracao,
+               (unsigned long)((xComandosFim.ulEnviados - xComandosFim.ulRejeitados) - (xComandosInicio.ulEnviados - xComandosInicio.ulRejeitados)),
+               (unsigned long)(xComandosFim.ulRejeitados - xComandosInicio.ulRejeitados),
+               benchRUN_TIME_PARA_US(ullPiorVarredura),
+               pcNomeSensor[iPiorSensor]);
+    }
+
+    printf("\n");
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+static void prvMedirModoRegistro(ModoRegistro_t eModo, const char* pcNome)
+{
+    static ResumoPerfil_t xAntes[perfilMAX_TAREFAS];
+    ResumoPerfil_t xDepois;
+    EstatisticaRegistro_t xRegistroAntes, xRegistroDepois;
+    configRUN_TIME_COUNTER_TYPE ulInicio, ulDuracao;
+    unsigned long long ullTotal = 0;
+    UBaseType_t uxPerfil;
+
+    RegistroDefinirModo(eModo);
+    vTaskDelay(pdMS_TO_TICKS(benchREGISTRO_ACOMODACAO_MS));
+
+    for (uxPerfil = 0; uxPerfil < perfilMAX_TAREFAS; uxPerfil++)
+        if (PerfilObterResumo(uxPerfil, &xAntes[uxPerfil]) != pdPASS)
+            xAntes[uxPerfil].pcNome = NULL;
+    RegistroObterEstatisticas(&xRegistroAntes);
+    ulInicio = ulGetRunTimeCounterValue();
+
+    vTaskDelay(pdMS_TO_TICKS(benchREGISTRO_SEGUNDOS * 1000UL));
+
+    ulDuracao = ulGetRunTimeCounterValue() - ulInicio;
+    RegistroObterEstatisticas(&xRegistroDepois);
+
+    /* Execucao media por ativacao no intervalo medido, por tarefa. */
+    for (uxPerfil = 0; uxPerfil < perfilMAX_TAREFAS; uxPerfil++) {
+        uint32_t ulAtivacoes;
+        unsigned long long ullExecucao;
+
+        if (xAntes[uxPerfil].pcNome == NULL || PerfilObterResumo(uxPerfil, &xDepois) != pdPASS)
+            continue;
+
+        ulAtivacoes = xDepois.ulAtivacoes - xAntes[uxPerfil].ulAtivacoes;
+        ullExecucao = xDepois.ullExecucaoTotal - xAntes[uxPerfil].ullExecucaoTotal;
+        ullTotal += ullExecucao;
+        if (ulAtivacoes == 0)
+            continue;
+
+        printf("[registro] %-7s %-34s ativacoes %7lu  execucao media %8llu us\n",
+               pcNome, xDepois.pcNome == NULL ? "" : xDepois.pcNome,
+               (unsigned long)ulAtivacoes,
+               benchRUN_TIME_PARA_US(ullExecucao / ulAtivacoes));
+    }
+
+    if (ulDuracao == 0)
+        ulDuracao = 1;
+
+    printf("[registro] %-7s CPU das tarefas perfiladas %llu us por segundo  registros %lu  descartados %lu  ocupacao max %lu\n\n",
+           pcNome,
+           benchRUN_TIME_PARA_US(ullTotal) * gatewayRUN_TIME_POR_MS * 1000ULL / ulDuracao,
+           (unsigned long)(xRegistroDepois.ulEscritos - xRegistroAntes.ulEscritos),
+           (unsigned long)(xRegistroDepois.ulDescartados - xRegistroAntes.ulDescartados),
+           (unsigned long)xRegistroDepois.ulOcupacaoMax);
+}
+/*-----------------------------------------------------------*/
+
+void BenchmarkRegistroTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    prvMedirModoRegistro(REGISTRO_DIRETO, "direto");
+    prvMedirModoRegistro(REGISTRO_ADIADO, "adiado");
+
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+/* Evita que o compilador descarte os sorteios. */
+static volatile int32_t lBenchSumidouro;
+
+/* Nanossegundos por amostra a partir da duracao em unidades do contador. */
+static unsigned long long prvNsPorAmostra(configRUN_TIME_COUNTER_TYPE ulDuracao)
+{
+    return (unsigned long long)ulDuracao * 1000000ULL / gatewayRUN_TIME_POR_MS / benchSIMULACAO_AMOSTRAS;
+}
+/*-----------------------------------------------------------*/
+
+void BenchmarkSimulacaoTask(void* pvParameters)
+{
+    static SimuladorSensores_t xA, xB;
+    static const char* const pcDistribuicoes[] = {
+        "fluxo", "temperatura", "tensao", "particulas", "gas"
+    };
+    configRUN_TIME_COUNTER_TYPE ulInicio;
+    int32_t lAcumulado;
+    uint32_t ulDiferencas = 0;
+    int iDistribuicao;
+
+    (void)pvParameters;
+
+    SimuladorInicializar(&xA, benchSIMULACAO_SEMENTE, &xCenarioPadrao);
+
+    for (iDistribuicao = 0; iDistribuicao < sizeof(pcDistribuicoes) / sizeof(pcDistribuicoes[0]); iDistribuicao++) {
+        lAcumulado = 0;
+        ulInicio = ulGetRunTimeCounterValue();
+
+        for (uint32_t i = 0; i < benchSIMULACAO_AMOSTRAS; i++) {
+            switch (iDistribuicao) {
+            case 0: lAcumulado += SimularFluxo(&xA, 1); break;
+            case 1: lAcumulado += SimularTemperatura(&xA); break;
+            case 2: lAcumulado += SimularTensao(&xA, TENSAO_COMPRESSOR); break;
+            case 3: lAcumulado += SimularParticulas(&xA); break;
+            default: lAcumulado += SimularGas(&xA); break;
+            }
+        }
+
+        printf("[simulacao] %-12s %6llu ns por amostra\n", pcDistribuicoes[iDistribuicao],
+               prvNsPorAmostra(ulGetRunTimeCounterValue() - ulInicio));
+        lBenchSumidouro = lAcumulado;
+    }
+
+    /* Como os geradores faziam antes: srand(time(NULL)) e rand() a cada
+     * amostra. */
+    lAcumulado = 0;
+    ulInicio = ulGetRunTimeCounterValue();
+    for (uint32_t i = 0; i < benchSIMULACAO_AMOSTRAS; i++) {
+        srand((unsigned)time(NULL));
+        lAcumulado += rand() % 11;
+    }
+    printf("[simulacao] %-12s %6llu ns por amostra\n", "srand+rand",
+           prvNsPorAmostra(ulGetRunTimeCounterValue() - ulInicio));
+    lBenchSumidouro = lAcumulado;
+
+    /* Mesma semente, mesma sequencia em todos os sensores. */
+    SimuladorInicializar(&xA, benchSIMULACAO_SEMENTE, &xCenarioDegradado);
+    SimuladorInicializar(&xB, benchSIMULACAO_SEMENTE, &xCenarioDegradado);
+    for (uint32_t i = 0; i < benchSIMULACAO_COMPARADAS; i++) {
+        if (SimularFluxo(&xA, 1) != SimularFluxo(&xB, 1) ||
+            SimularTemperatura(&xA) != SimularTemperatura(&xB) ||
+            SimularTensao(&xA, TENSAO_VENTOINHA) != SimularTensao(&xB, TENSAO_VENTOINHA) ||
+            SimularParticulas(&xA) != SimularParticulas(&xB) ||
+            SimularGas(&xA) != SimularGas(&xB))
+            ulDiferencas++;
+    }
+    printf("[simulacao] mesma semente: %lu de %lu amostras diferentes\n\n",
+           (unsigned long)ulDiferencas, (unsigned long)benchSIMULACAO_COMPARADAS);
+
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+/* Os tres alocadores comparados, pela mesma interface.  O pool do benchmark
+ * e uma instancia propria com as classes do sistema; como o heap_4 e o
+ * heap_5, suspende o escalonador em cada operacao. */
+typedef struct {
+    const char* pcNome;
+    void* (*pvAlocar)(size_t xTamanho);
+    void (*vLiberar)(void* pv);
+    size_t (*xLivres)(void);
+    size_t (*xMaiorLivre)(void);
+} HeapBench_t;
+
+static Alocador_t xBenchPool;
+static uint64_t ullBenchArena[configTOTAL_HEAP_SIZE / sizeof(uint64_t)];
+
+static OperacaoAlocador_t xBenchSequencia[alocadorMAX_OPERACOES];
+static void* pvBenchBlocos[alocadorMAX_OPERACOES];
+
+/* Reservada mesmo quando nenhum benchmark e criado. */
+const size_t xRamBenchmarks = sizeof(xBenchAmostras) + sizeof(ulCustoEDF) + sizeof(ullBenchArena) +
+                              sizeof(xBenchSequencia) + sizeof(pvBenchBlocos);
+
+/*-----------------------------------------------------------*/
+
+static void* prvPoolAlocar(size_t xTamanho)
+{
+    void* pv;
+
+    vTaskSuspendAll();
+    {
+        pv = pvAlocadorAlocar(&xBenchPool, xTamanho);
+    }
+    (void)xTaskResumeAll();
+
+    return pv;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPoolLiberar(void* pv)
+{
+    vTaskSuspendAll();
+    {
+        vAlocadorLiberar(&xBenchPool, pv);
+    }
+    (void)xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvPoolLivres(void)
+{
+    return xBenchPool.xLivres;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvPoolMaiorLivre(void)
+{
+    return xAlocadorMaiorLivre(&xBenchPool);
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvHeap4MaiorLivre(void)
+{
+    HeapStats_t xEstatisticas;
+
+    vHeap4Estatisticas(&xEstatisticas);
+    return xEstatisticas.xSizeOfLargestFreeBlockInBytes;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvHeap5MaiorLivre(void)
+{
+    HeapStats_t xEstatisticas;
+
+    vHeap5Estatisticas(&xEstatisticas);
+    return xEstatisticas.xSizeOfLargestFreeBlockInBytes;
+}
+/*-----------------------------------------------------------*/
+
+static const HeapBench_t xHeapsBench[] = {
+    { "heap_4", pvHeap4Alocar, vHeap4Liberar, xHeap4Livres, prvHeap4MaiorLivre },
+    { "heap_5", pvHeap5Alocar, vHeap5Liberar, xHeap5Livres, prvHeap5MaiorLivre },
+    { "pools",  prvPoolAlocar, prvPoolLiberar, prvPoolLivres, prvPoolMaiorLivre },
+};
+
+/* Reproduz a sequencia uma vez; retorna as alocacoes que falharam.  Os blocos
+ * ainda vivos no fim ficam em pvBenchBlocos. */
+static uint32_t prvReproduzirSequencia(const HeapBench_t* pxHeap, UBaseType_t uxOperacoes)
+{
+    uint32_t ulFalhas = 0;
+
+    for (UBaseType_t ux = 0; ux < uxOperacoes; ux++) {
+        const OperacaoAlocador_t* pxOperacao = &xBenchSequencia[ux];
+
+        if (pxOperacao->ulTamanho == 0) {
+            pxHeap->vLiberar(pvBenchBlocos[pxOperacao->usAlocacao]);
+            pvBenchBlocos[pxOperacao->usAlocacao] = NULL;
+        }
+        else {
+            pvBenchBlocos[pxOperacao->usAlocacao] = pxHeap->pvAlocar(pxOperacao->ulTamanho);
+            if (pvBenchBlocos[pxOperacao->usAlocacao] == NULL)
+                ulFalhas++;
+        }
+    }
+
+    return ulFalhas;
+}
+/*-----------------------------------------------------------*/
+
+static void prvLiberarTudo(const HeapBench_t* pxHeap, UBaseType_t uxAlocacoes)
+{
+    for (UBaseType_t ux = 0; ux < uxAlocacoes; ux++) {
+        pxHeap->vLiberar(pvBenchBlocos[ux]);
+        pvBenchBlocos[ux] = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvMedirHeap(const HeapBench_t* pxHeap, UBaseType_t uxOperacoes, UBaseType_t uxAlocacoes)
+{
+    configRUN_TIME_COUNTER_TYPE ulInicio, ulDuracao;
+    uint32_t ulFalhasSequencia = 0, ulFalhasTrocas = 0;
+    uint32_t ulSorteio = benchHEAP_SEMENTE;
+    size_t xLivres, xMaiorLivre;
+
+    /* Sequencia real, liberando no fim de cada repeticao o que ficou vivo
+     * (tarefas e grupo de eventos do gateway). */
+    ulInicio = ulGetRunTimeCounterValue();
+    for (uint32_t ulRepeticao = 0; ulRepeticao < benchHEAP_REPETICOES; ulRepeticao++) {
+        ulFalhasSequencia += prvReproduzirSequencia(pxHeap, uxOperacoes);
+        prvLiberarTudo(pxHeap, uxAlocacoes);
+    }
+    ulDuracao = ulGetRunTimeCounterValue() - ulInicio;
+
+    /* A partir do estado final da sequencia, cada troca sorteia uma alocacao:
+     * se esta viva e liberada, senao e refeita com o tamanho de uma alocacao
+     * sorteada da sequencia.  Os tamanhos se misturam no heap. */
+    ulFalhasSequencia += prvReproduzirSequencia(pxHeap, uxOperacoes);
+    for (uint32_t ulTroca = 0; ulTroca < benchHEAP_TROCAS; ulTroca++) {
+        UBaseType_t uxAlvo, uxModelo;
+
+        ulSorteio ^= ulSorteio << 13;
+        ulSorteio ^= ulSorteio >> 17;
+        ulSorteio ^= ulSorteio << 5;
+        uxAlvo = (UBaseType_t)(ulSorteio % uxAlocacoes);
+
+        if (pvBenchBlocos[uxAlvo] != NULL) {
+            pxHeap->vLiberar(pvBenchBlocos[uxAlvo]);
+            pvBenchBlocos[uxAlvo] = NULL;
+            continue;
+        }
+
+        uxModelo = (UBaseType_t)((ulSorteio >> 8) % uxOperacoes);
+        while (xBenchSequencia[uxModelo].ulTamanho == 0)
+            uxModelo = (uxModelo + 1) % uxOperacoes;
+
+        pvBenchBlocos[uxAlvo] = pxHeap->pvAlocar(xBenchSequencia[uxModelo].ulTamanho);
+        if (pvBenchBlocos[uxAlvo] == NULL)
+            ulFalhasTrocas++;
+    }
+    xLivres = pxHeap->xLivres();
+    xMaiorLivre = pxHeap->xMaiorLivre();
+    prvLiberarTudo(pxHeap, uxAlocacoes);
+
+    if (ulDuracao == 0)
+        ulDuracao = 1;
+
+    printf("[heap] %-6s %6llu ns por operacao, falhas %lu | trocas: falhas %lu, livre %6u bytes, maior bloco livre %6u bytes\n",
+           pxHeap->pcNome,
+           (unsigned long long)ulDuracao * 1000000ULL / gatewayRUN_TIME_POR_MS /
+               ((unsigned long long)benchHEAP_REPETICOES * (uxOperacoes + uxAlocacoes)),
+           (unsigned long)ulFalhasSequencia,
+           (unsigned long)ulFalhasTrocas,
+           (unsigned)xLivres,
+           (unsigned)xMaiorLivre);
+}
+/*-----------------------------------------------------------*/
+
+void BenchmarkHeapTask(void* pvParameters)
+{
+    UBaseType_t uxOperacoes, uxAlocacoes = 0;
+
+    (void)pvParameters;
+
+    vTaskDelay(pdMS_TO_TICKS(benchHEAP_ACOMODACAO_MS));
+
+    uxOperacoes = AlocadorCopiarSequencia(xBenchSequencia, alocadorMAX_OPERACOES);
+    for (UBaseType_t ux = 0; ux < uxOperacoes; ux++) {
+        if (xBenchSequencia[ux].ulTamanho != 0)
+            uxAlocacoes++;
+    }
+
+    printf("[heap] sequencia gravada: %u operacoes, %u alocacoes\n", (unsigned)uxOperacoes, (unsigned)uxAlocacoes);
+
+    if (uxAlocacoes > 0) {
+        Heap5Inicializar();
+        (void)AlocadorInicializar(&xBenchPool, ullBenchArena, sizeof(ullBenchArena),
+                                  xClassesSistema, uxNumClassesSistema);
+
+        for (int i = 0; i < sizeof(xHeapsBench) / sizeof(xHeapsBench[0]); i++)
+            prvMedirHeap(&xHeapsBench[i], uxOperacoes, uxAlocacoes);
+
+        AlocadorImprimir(&xBenchPool, "[heap] pools ");
+    }
+
+    AlocadorImprimir(AlocadorSistema(), "[heap] sistema");
+    printf("\n");
+
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+#if ( configSONO_OCIOSO == 1 )
+
+/* Tempo de CPU de todas as threads do simulador, em ns. */
+static uint64_t prvCpuProcessoNs(void)
+{
+    FILETIME xCriacao, xSaida, xNucleo, xUsuario;
+    ULARGE_INTEGER xTotalNucleo, xTotalUsuario;
+
+    taskENTER_CRITICAL();
+    {
+        (void)GetProcessTimes(GetCurrentProcess(), &xCriacao, &xSaida, &xNucleo, &xUsuario);
+    }
+    taskEXIT_CRITICAL();
+
+    xTotalNucleo.LowPart = xNucleo.dwLowDateTime;
+    xTotalNucleo.HighPart = xNucleo.dwHighDateTime;
+    xTotalUsuario.LowPart = xUsuario.dwLowDateTime;
+    xTotalUsuario.HighPart = xUsuario.dwHighDateTime;
+
+    /* Em unidades de 100 ns. */
+    return (xTotalNucleo.QuadPart + xTotalUsuario.QuadPart) * 100ULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMedirModoSono(BaseType_t xSono, const char* pcNome)
+{
+    EstatisticaSonoOcioso_t xAntes, xDepois;
+    configRUN_TIME_COUNTER_TYPE ulInicio, ulDuracao;
+    uint64_t ullCpuInicio, ullCpu;
+    TickType_t xTickInicio, xTicks;
+    uint64_t ullTicksTratados;
+    uint32_t ulEsperas;
+    long long llDeriva;
+
+    SonoOciosoHabilitar(xSono);
+    vTaskDelay(pdMS_TO_TICKS(benchSONO_ACOMODACAO_MS));
+
+    SonoOciosoObterEstatisticas(&xAntes);
+    xTickInicio = xTaskGetTickCount();
+    ullCpuInicio = prvCpuProcessoNs();
+    ulInicio = ulGetRunTimeCounterValue();
+
+    vTaskDelay(pdMS_TO_TICKS(benchSONO_SEGUNDOS * 1000UL));
+
+    ulDuracao = ulGetRunTimeCounterValue() - ulInicio;
+    ullCpu = prvCpuProcessoNs() - ullCpuInicio;
+    xTicks = xTaskGetTickCount() - xTickInicio;
+    SonoOciosoObterEstatisticas(&xDepois);
+
+    /* O host acorda para cada tick tratado (gancho do tick) e para cada
+     * retorno da espera do sono; os ticks passados com vTaskStepTick() nao
+     * acordam ninguem. */
+    ullTicksTratados = xDepois.ullTicksTratados - xAntes.ullTicksTratados;
+    ulEsperas = xDepois.ulRetornosEspera - xAntes.ulRetornosEspera;
+    llDeriva = prvDerivaTicks(xTicks, ulDuracao);
+
+    if (ulDuracao == 0)
+        ulDuracao = 1;
+
+    printf("[sono] %-8s ticks do port %6llu/s  esperas %5llu/s  acordadas do host %6llu/s  CPU do processo %3llu.%01llu%%\n",
+           pcNome,
+           ullTicksTratados * 1000ULL * gatewayRUN_TIME_POR_MS / ulDuracao,
+           (unsigned long long)ulEsperas * 1000ULL * gatewayRUN_TIME_POR_MS / ulDuracao,
+           (ullTicksTratados + ulEsperas) * 1000ULL * gatewayRUN_TIME_POR_MS / ulDuracao,
+           ullCpu * 100ULL / ulDuracao, ullCpu * 1000ULL / ulDuracao % 10ULL);
+    printf("[sono] %-8s sonos interrompidos %lu  abortados %lu  sono medio %llu us  ticks corrigidos %llu\n",
+           pcNome,
+           (unsigned long)(xDepois.ulSonosInterrompidos - xAntes.ulSonosInterrompidos),
+           (unsigned long)(xDepois.ulSonosAbortados - xAntes.ulSonosAbortados),
+           ulEsperas == 0 ? 0ULL : benchRUN_TIME_PARA_US((xDepois.ullNsDormidos - xAntes.ullNsDormidos) / ulEsperas),
+           (unsigned long long)(xDepois.ullTicksCorrigidos - xAntes.ullTicksCorrigidos));
+
+    /* Com tick a deriva e a do proprio port (atraso do Sleep() da thread do
+     * tick); o sono nao deve somar nada a ela. */
+    printf("[sono] %-8s deriva do tick %+lld ticks em %llu ms (%+lld ppm)\n\n",
+           pcNome, llDeriva,
+           (unsigned long long)(ulDuracao / gatewayRUN_TIME_POR_MS),
+           llDeriva * 1000000LL * (long long)(gatewayRUN_TIME_POR_MS * portTICK_PERIOD_MS) / (long long)ulDuracao);
+}
+/*-----------------------------------------------------------*/
+
+void BenchmarkSonoTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    prvMedirModoSono(pdFALSE, "com tick");
+    prvMedirModoSono(pdTRUE, "sem tick");
+
+    vTaskDelete(NULL);
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configSONO_OCIOSO */
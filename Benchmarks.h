@@ -0,0 +1,66 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+/*
+ * Benchmarks do gateway.  Cada um e selecionado por mainBENCHMARK em main.c e
+ * roda como uma tarefa de baixa prioridade junto com as tarefas normais.
+ */
+
+/* Soak: roda por benchSOAK_HORAS horas simuladas e reporta, a cada hora, o uso
+ * do heap, a latencia por amostra de cada modulo sensor e o tempo real gasto.
+ * Com configTEMPO_VIRTUAL em 1 as 24 horas rodam em tempo de CPU. */
+void BenchmarkSoakTask(void* pvParameters);
+
+/* Compara o anel SPSC de AnelAmostras.c com a janela de duas posicoes protegida
+ * por mutex usada antes nos modulos: vazao de publicacoes e leituras e pior
+ * latencia de cada operacao. */
+void BenchmarkAnelTask(void* pvParameters);
+
+/* Mede a latencia entre uma mudanca nos sensores e a decisao do
+ * PoolingServerTask, e quantas vezes ele acordou: benchDECISAO_MINUTOS com a
+ * consulta a cada 200 ticks e depois benchDECISAO_MINUTOS por eventos, no
+ * mesmo binario.  Para comparar mainAMOSTRAGEM_ADAPTATIVA, que tambem imprime
+ * a taxa efetiva de cada sensor, rodar uma vez com ela em 0 e outra em 1. */
+void BenchmarkDecisaoTask(void* pvParameters);
+
+/* Roda o mesmo conjunto de tarefas sinteticas com prioridade fixa (RM) e com
+ * EDF (Escalonador.h), com utilizacao crescente, e compara os prazos perdidos.
+ * As tarefas do gateway continuam rodando e entram como interferencia nos dois
+ * modos.  Exige mainESCALONAMENTO_EDF em 0. */
+void BenchmarkEDFTask(void* pvParameters);
+
+/* Varre 1, 100, 1000 e 10000 zonas com o mesmo conjunto de tarefas e mede a
+ * vazao sustentada de amostras por zona (contra a esperada pelos periodos dos
+ * modulos) e de decisoes por zona do controlador.  Quando as varreduras nao
+ * cabem nos periodos a vazao de amostras fica abaixo da esperada. */
+void BenchmarkZonasTask(void* pvParameters);
+
+/* Mede o tempo de execucao por ativacao de cada tarefa perfilada (por
+ * amostra, nos modulos sensores) com as mensagens impressas na hora
+ * (REGISTRO_DIRETO) e com o registro adiado (REGISTRO_ADIADO).  No modo
+ * adiado a tarefa de drenagem aparece na lista com o custo da formatacao. */
+void BenchmarkRegistroTask(void* pvParameters);
+
+/* Custo por amostra de cada distribuicao de SimuladorSensores.h, comparado
+ * com o srand(time(NULL)) + rand() usado antes pelos geradores, e conferencia
+ * de que dois simuladores com a mesma semente geram as mesmas sequencias. */
+void BenchmarkSimulacaoTask(void* pvParameters);
+
+/* Reproduz a sequencia real de alocacoes e liberacoes do gateway (gravada por
+ * AlocadorPools.c) no heap_4, no heap_5 e no alocador por classes: tempo por
+ * operacao e falhas; depois, apos muitas liberacoes e alocacoes sorteadas,
+ * bytes livres e maior bloco livre, que mostram a fragmentacao.  Imprime
+ * tambem as estatisticas por classe do alocador do sistema. */
+void BenchmarkHeapTask(void* pvParameters);
+
+/* Roda o gateway benchSONO_SEGUNDOS com a tarefa ociosa girando com tick e
+ * outros tantos com o sono ocioso (SonoOcioso.h), e compara ticks tratados
+ * pelo port, retornos da espera do sono e o total de acordadas do host por
+ * segundo, o tempo de CPU do processo e a deriva do contador de ticks em
+ * relacao ao tempo real.  Exige configSONO_OCIOSO em 1. */
+void BenchmarkSonoTask(void* pvParameters);
+
+/* Bytes dos vetores dos benchmarks, para o orcamento de RAM. */
+extern const size_t xRamBenchmarks;
+
+#endif /* BENCHMARKS_H */
@@ -0,0 +1,147 @@
+/*
+ * Despacho de comandos tipados para o ar condicionado.  Ver ComandosAtuador.h.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "EstadoGateway.h"
+#include "ComandosAtuador.h"
+#include "MonitorPrazos.h"
+
+static ServidorAperiodico_t* pxServidorComandos;
+static TrabalhoAperiodico_t pxAcoesComandos[NUM_COMANDOS];
+
+/* Um bit por comando enfileirado e ainda nao iniciado, por zona. */
+static volatile uint8_t ucPendentes[estadoMAX_ZONAS];
+
+/* Pedidos aceitos e ainda nao iniciados.  As liberacoes ficam no monitor de
+ * prazos, na ordem da fila do servidor: so ComandoEnviar submete a esse
+ * servidor, e so a tarefa de decisao chama ComandoEnviar.  A posicao a mais
+ * cobre o pedido que o servidor ja tirou da fila e ainda nao comecou. */
+#define comandosMAX_LIBERACOES    ( servidorMAX_FILA + 1 )
+
+static UBaseType_t uxNumLiberacoes;
+
+static EstatisticaComandos_t xEstatisticas;
+
+const size_t xRamComandos = sizeof(ucPendentes);
+
+/* O parametro do trabalho leva a zona e o comando. */
+#define comandosPARAMETRO( uxZona, eComando )    ( ( void * ) ( uintptr_t ) ( ( uxZona ) * NUM_COMANDOS + ( eComando ) ) )
+
+/*-----------------------------------------------------------*/
+
+/* Roda na tarefa do servidor. */
+static void prvExecutarComando(void* pvParametro)
+{
+    UBaseType_t uxZona = (UBaseType_t)((uintptr_t)pvParametro / NUM_COMANDOS);
+    ComandoAtuador_t eComando = (ComandoAtuador_t)((uintptr_t)pvParametro % NUM_COMANDOS);
+
+    /* Limpa antes de executar: um pedido que chegue durante a execucao e um
+     * novo pedido e precisa ser enfileirado. */
+    taskENTER_CRITICAL();
+    {
+        ucPendentes[uxZona] &= ~(1U << eComando);
+        xEstatisticas.ulExecutados[eComando]++;
+
+        configASSERT(uxNumLiberacoes > 0);
+        uxNumLiberacoes--;
+    }
+    taskEXIT_CRITICAL();
+
+    MonitorIniciar(eComando);
+    pxAcoesComandos[eComando]((void*)(uintptr_t)uxZona);
+    MonitorConcluir(eComando);
+}
+/*-----------------------------------------------------------*/
+
+void ComandosInicializar(ServidorAperiodico_t* pxServidor, const TrabalhoAperiodico_t pxAcoes[NUM_COMANDOS])
+{
+    configASSERT(pxServidor->xConfig.uxTamanhoFila >= NUM_COMANDOS);
+    configASSERT(comandosMAX_LIBERACOES <= monitorMAX_PENDENTES);
+
+    pxServidorComandos = pxServidor;
+    memcpy(pxAcoesComandos, pxAcoes, sizeof(pxAcoesComandos));
+    memset((void*)ucPendentes, 0, sizeof(ucPendentes));
+    uxNumLiberacoes = 0;
+    memset(&xEstatisticas, 0, sizeof(xEstatisticas));
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t ComandoEnviar(UBaseType_t uxZona, ComandoAtuador_t eComando)
+{
+    configRUN_TIME_COUNTER_TYPE ulInicio = ulGetRunTimeCounterValue();
+    configRUN_TIME_COUNTER_TYPE ulDespacho;
+    uint8_t ucBit = (uint8_t)(1U << eComando);
+    BaseType_t xCoalescido;
+    BaseType_t xResultado = pdPASS;
+
+    configASSERT(uxZona < estadoMAX_ZONAS && eComando < NUM_COMANDOS);
+
+    taskENTER_CRITICAL();
+    {
+        xCoalescido = (ucPendentes[uxZona] & ucBit) != 0;
+        xEstatisticas.ulEnviados++;
+        if (xCoalescido)
+            xEstatisticas.ulCoalescidos++;
+        else if (uxNumLiberacoes == comandosMAX_LIBERACOES) {
+            xEstatisticas.ulRejeitados++;
+            xResultado = pdFAIL;
+        }
+        else {
+            /* Antes de submeter: o servidor tem prioridade maior e pode
+             * executar o trabalho dentro de ServidorSubmeter. */
+            ucPendentes[uxZona] |= ucBit;
+            uxNumLiberacoes++;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (!xCoalescido && xResultado == pdPASS) {
+        /* Tambem antes de submeter, pelo mesmo motivo: arma o prazo. */
+        MonitorLiberar(eComando, ulInicio);
+
+        if (ServidorSubmeter(pxServidorComandos, prvExecutarComando, comandosPARAMETRO(uxZona, eComando)) != pdPASS) {
+            /* Com a fila cheia nenhum pedido novo pode ter sido iniciado desde
+             * o registro acima, entao a ultima liberacao e a deste pedido. */
+            MonitorDescartar(eComando);
+            taskENTER_CRITICAL();
+            {
+                ucPendentes[uxZona] &= ~ucBit;
+                uxNumLiberacoes--;
+                xEstatisticas.ulRejeitados++;
+            }
+            taskEXIT_CRITICAL();
+
+            xResultado = pdFAIL;
+        }
+    }
+
+    /* 64 bits: a comparacao e a escrita precisam ser atomicas para quem le
+     * com ComandosObterEstatisticas(). */
+    ulDespacho = ulGetRunTimeCounterValue() - ulInicio;
+    taskENTER_CRITICAL();
+    {
+        if (ulDespacho > xEstatisticas.ullDespachoMax)
+            xEstatisticas.ullDespachoMax = ulDespacho;
+    }
+    taskEXIT_CRITICAL();
+
+    return xResultado;
+}
+/*-----------------------------------------------------------*/
+
+void ComandosObterEstatisticas(EstatisticaComandos_t* pxEstatisticas)
+{
+    taskENTER_CRITICAL();
+    {
+        *pxEstatisticas = xEstatisticas;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
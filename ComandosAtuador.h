@@ -0,0 +1,51 @@
+#ifndef COMANDOS_ATUADOR_H
+#define COMANDOS_ATUADOR_H
+
+/*
+ * Despacho de comandos tipados para o ar condicionado.
+ *
+ * O PoolingServerTask envia um ComandoAtuador_t para uma zona em vez de criar
+ * uma tarefa por acao.  O comando vira um trabalho na fila limitada do
+ * servidor aperiodico, cuja tarefa estatica e o trabalhador que executa as
+ * acoes.  Um comando que ja esta pendente na fila para a mesma zona nao e
+ * enfileirado de novo (coalescencia).  Com muitas zonas a fila pode encher; o
+ * envio entao falha na hora e cabe a quem enviou tentar de novo.
+ */
+
+#include "FreeRTOS.h"
+
+#include "ServidorAperiodico.h"
+
+typedef enum {
+    COMANDO_LIGAR = 0,          /* T6 */
+    COMANDO_CONTROLAR,          /* T7 */
+    COMANDO_DESLIGAR,           /* T8 */
+    COMANDO_NOTIFICAR,          /* T9 */
+    NUM_COMANDOS
+} ComandoAtuador_t;
+
+/* Tempos em unidades do contador de run time. */
+typedef struct {
+    uint32_t ulEnviados;
+    uint32_t ulCoalescidos;
+    uint32_t ulRejeitados;
+    uint32_t ulExecutados[NUM_COMANDOS];
+    uint64_t ullDespachoMax;
+} EstatisticaComandos_t;
+
+/* pxAcoes[i] e executada para o comando i e recebe a zona como parametro
+ * ((void*)(uintptr_t)uxZona).  Cada comando e monitorado como a tarefa de
+ * mesmo indice em MonitorPrazos.h, que precisa ser inicializado antes.  O
+ * servidor precisa ter fila para ao menos NUM_COMANDOS pedidos. */
+void ComandosInicializar(ServidorAperiodico_t* pxServidor, const TrabalhoAperiodico_t pxAcoes[NUM_COMANDOS]);
+
+/* Nao bloqueia e nao aloca.  Retorna pdPASS se o comando foi enfileirado ou
+ * coalescido com um pendente e pdFAIL se a fila estava cheia. */
+BaseType_t ComandoEnviar(UBaseType_t uxZona, ComandoAtuador_t eComando);
+
+void ComandosObterEstatisticas(EstatisticaComandos_t* pxEstatisticas);
+
+/* Bytes das marcas por zona, para o orcamento de RAM. */
+extern const size_t xRamComandos;
+
+#endif /* COMANDOS_ATUADOR_H */
@@ -0,0 +1,267 @@
+/*
+ * Gravacao do rastreio em blocos.  Ver DespejoRastreio.h.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Gateway.h"
+#include "DespejoRastreio.h"
+#include "RastreioContinuo.h"
+
+static char cArquivo[despejoMAX_NOME];
+static char cArquivoTemporario[despejoMAX_NOME + 4];
+
+static EstatisticaDespejo_t xEstatisticas;
+
+static TaskHandle_t xTarefaDespejo;
+static StaticTask_t xTCBDespejo;
+static StackType_t uxPilhaDespejo[despejoTAMANHO_PILHA];
+
+/*-----------------------------------------------------------*/
+
+#if ( TRC_USE_TRACEALYZER_RECORDER == 1 ) && ( TRC_CFG_RECORDER_MODE == TRC_RECORDER_MODE_SNAPSHOT )
+
+/* Tudo o que vem antes do anel de eventos: indices, tabela de objetos e
+ * tabela de simbolos, que mudam mesmo com o recorder parado quando um objeto
+ * e criado. */
+#define despejoTAMANHO_CABECALHO        offsetof( RecorderDataType, eventData )
+
+static uint8_t ucCabecalho[despejoTAMANHO_CABECALHO];
+
+const size_t xRamDespejo = sizeof(ucCabecalho);
+
+static BaseType_t prvGravarBloco(FILE* pxArquivo, const void* pvDados, size_t xTamanho)
+{
+    configRUN_TIME_COUNTER_TYPE ulInicio;
+    configRUN_TIME_COUNTER_TYPE ulDuracao;
+    size_t xGravados;
+
+    taskENTER_CRITICAL();
+    {
+        ulInicio = portGET_RUN_TIME_COUNTER_VALUE();
+        xGravados = fwrite(pvDados, 1, xTamanho, pxArquivo);
+        ulDuracao = portGET_RUN_TIME_COUNTER_VALUE() - ulInicio;
+
+        xEstatisticas.ulBlocos++;
+        xEstatisticas.ullBytes += xGravados;
+        if (ulDuracao > xEstatisticas.ulMaiorBloco)
+            xEstatisticas.ulMaiorBloco = ulDuracao;
+    }
+    taskEXIT_CRITICAL();
+
+    return xGravados == xTamanho ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvGravarEmBlocos(FILE* pxArquivo, const uint8_t* pucDados, size_t xTamanho)
+{
+    size_t xBloco;
+
+    while (xTamanho > 0) {
+        xBloco = xTamanho < despejoTAMANHO_BLOCO ? xTamanho : despejoTAMANHO_BLOCO;
+        if (prvGravarBloco(pxArquivo, pucDados, xBloco) != pdPASS)
+            return pdFAIL;
+        pucDados += xBloco;
+        xTamanho -= xBloco;
+    }
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCongelar(void)
+{
+    taskENTER_CRITICAL();
+    {
+        (void)xTraceDisable();
+        if (RecorderDataPtr != NULL)
+            memcpy(ucCabecalho, RecorderDataPtr, sizeof(ucCabecalho));
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvGravar(void)
+{
+    const uint8_t* pucDados = (const uint8_t*)RecorderDataPtr;
+    uint32_t ulBlocosInicio = xEstatisticas.ulBlocos;
+    BaseType_t xOk;
+    FILE* pxArquivo;
+    int iResultado;
+
+    if (RecorderDataPtr == NULL || cArquivo[0] == '\0')
+        return;
+
+    taskENTER_CRITICAL();
+    {
+        pxArquivo = fopen(cArquivoTemporario, "wb");
+    }
+    taskEXIT_CRITICAL();
+
+    xOk = pxArquivo != NULL;
+
+    /* Cabecalho copiado em prvCongelar(); anel e marcadores finais direto do
+     * recorder, parado desde entao. */
+    if (xOk)
+        xOk = prvGravarBloco(pxArquivo, ucCabecalho, sizeof(ucCabecalho));
+    if (xOk)
+        xOk = prvGravarEmBlocos(pxArquivo, pucDados + sizeof(ucCabecalho),
+                                sizeof(RecorderDataType) - sizeof(ucCabecalho));
+
+    taskENTER_CRITICAL();
+    {
+        if (pxArquivo != NULL && fclose(pxArquivo) != 0)
+            xOk = pdFALSE;
+
+        if (xOk) {
+            /* rename() do Windows nao substitui um arquivo existente. */
+            remove(cArquivo);
+            iResultado = rename(cArquivoTemporario, cArquivo);
+            xOk = iResultado == 0;
+        }
+
+        if (xOk) {
+            xEstatisticas.ulDespejos++;
+            printf("\r\nTrace output saved to %s (%lu blocos, maior secao critica %llu us)\r\n\r\n", cArquivo,
+                   (unsigned long)(xEstatisticas.ulBlocos - ulBlocosInicio),
+                   (unsigned long long)(xEstatisticas.ulMaiorBloco * 1000ULL / gatewayRUN_TIME_POR_MS));
+        }
+        else {
+            xEstatisticas.ulFalhas++;
+            printf("\r\nFailed to create trace dump file\r\n\r\n");
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvRetomar(void)
+{
+    taskENTER_CRITICAL();
+    {
+        (void)xTraceEnable(TRC_START);
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvImediato(void)
+{
+    /* Dentro da secao critica do chamador as secoes de cada bloco so
+     * aninham: o despejo inteiro roda sem ceder o processador. */
+    prvCongelar();
+    prvGravar();
+}
+/*-----------------------------------------------------------*/
+
+#else
+
+const size_t xRamDespejo = 0;
+
+static void prvCongelar(void)
+{
+}
+/*-----------------------------------------------------------*/
+
+static void prvGravar(void)
+{
+    /* Streaming: fecha o segmento corrente, ja com o buffer interno, e o
+     * recorder segue no seguinte. */
+    EstatisticaRastreio_t xRastreio;
+
+    RastreioObterEstatisticas(&xRastreio);
+    RastreioTrocarSegmento();
+
+    taskENTER_CRITICAL();
+    {
+        xEstatisticas.ulDespejos++;
+        printf("\r\nTrace segment " rastreioARQUIVO_FORMATO " closed, %llu bytes streamed\r\n\r\n",
+               (unsigned)xRastreio.ulSegmento, (unsigned long long)xRastreio.ullBytesGravados);
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvRetomar(void)
+{
+}
+/*-----------------------------------------------------------*/
+
+static void prvImediato(void)
+{
+    /* Sem RastreioTrocarSegmento(), que cede o processador: o segmento e
+     * fechado aqui e o proximo xTraceEnable() abre o seguinte. */
+    (void)xTraceDisable();
+    RastreioFecharPendente();
+
+    xEstatisticas.ulDespejos++;
+    printf("\r\nTrace segment closed\r\n\r\n");
+}
+/*-----------------------------------------------------------*/
+
+#endif /* TRC_CFG_RECORDER_MODE == TRC_RECORDER_MODE_SNAPSHOT */
+
+static void prvDespejoTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    for (;;) {
+        /* Teclas apertadas durante um despejo geram um unico despejo novo. */
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        prvCongelar();
+        prvGravar();
+        prvRetomar();
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t DespejoIniciar(const char* pcArquivo, UBaseType_t uxPrioridade)
+{
+    configASSERT(xTarefaDespejo == NULL);
+    configASSERT(strlen(pcArquivo) < sizeof(cArquivo));
+
+    snprintf(cArquivo, sizeof(cArquivo), "%s", pcArquivo);
+    snprintf(cArquivoTemporario, sizeof(cArquivoTemporario), "%s.tmp", pcArquivo);
+    memset(&xEstatisticas, 0, sizeof(xEstatisticas));
+
+    xTarefaDespejo = xTaskCreateStatic(prvDespejoTask, "Despejo", despejoTAMANHO_PILHA, NULL,
+                                       uxPrioridade, uxPilhaDespejo, &xTCBDespejo);
+
+    return xTarefaDespejo != NULL ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t DespejoSolicitarDeISR(void)
+{
+    BaseType_t xTrocar = pdFALSE;
+
+    if (xTarefaDespejo != NULL)
+        vTaskNotifyGiveFromISR(xTarefaDespejo, &xTrocar);
+
+    return xTrocar;
+}
+/*-----------------------------------------------------------*/
+
+void DespejoImediato(void)
+{
+    prvImediato();
+}
+/*-----------------------------------------------------------*/
+
+void DespejoObterEstatisticas(EstatisticaDespejo_t* pxEstatisticas)
+{
+    taskENTER_CRITICAL();
+    {
+        *pxEstatisticas = xEstatisticas;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
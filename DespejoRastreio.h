@@ -0,0 +1,57 @@
+#ifndef DESPEJO_RASTREIO_H
+#define DESPEJO_RASTREIO_H
+
+/*
+ * Gravacao do rastreio do Tracealyzer sem congelar o escalonador.
+ *
+ * A tecla de rastreio so acorda uma tarefa de baixa prioridade.  A tarefa para
+ * o recorder e copia o cabecalho do RecorderDataType (indices do anel de
+ * eventos, tabela de objetos e tabela de simbolos) numa unica secao critica
+ * curta.  Com o recorder parado o anel de eventos nao muda, entao ele e
+ * gravado direto da memoria do recorder, em blocos de despejoTAMANHO_BLOCO.
+ * Cada bloco tem sua propria secao critica, por causa das chamadas ao Windows.
+ * Entre blocos as interrupcoes e as outras tarefas rodam normalmente, e uma
+ * preempcao no meio do despejo nao muda o que ja foi copiado nem o anel.  O
+ * arquivo e escrito com outro nome e renomeado no fim: um despejo
+ * interrompido nao deixa um Trace.dump pela metade.
+ *
+ * Os eventos gerados durante o despejo se perdem, como antes, porque o
+ * recorder fica parado ate o fim da gravacao.
+ *
+ * No modo streaming a tarefa so passa para o segmento seguinte, com
+ * RastreioTrocarSegmento() (ver RastreioContinuo.h).
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define despejoTAMANHO_BLOCO            ( 16 * 1024 )
+#define despejoMAX_NOME                 64
+#define despejoTAMANHO_PILHA            configMINIMAL_STACK_SIZE
+
+typedef struct {
+    uint32_t ulDespejos;
+    uint32_t ulFalhas;
+    uint32_t ulBlocos;
+    uint64_t ullBytes;
+    configRUN_TIME_COUNTER_TYPE ulMaiorBloco;   /* Maior secao critica de um bloco */
+} EstatisticaDespejo_t;
+
+/* Guarda o nome do arquivo e cria a tarefa de despejo. */
+BaseType_t DespejoIniciar(const char* pcArquivo, UBaseType_t uxPrioridade);
+
+/* Chamada pelo tratador do teclado (interrupcao simulada).  Retorna pdTRUE
+ * se a tarefa de despejo deve rodar em seguida. */
+BaseType_t DespejoSolicitarDeISR(void);
+
+/* Para o recorder e grava o rastreio antes de retornar, sem ceder o
+ * processador se o chamador estiver em secao critica.  Para vAssertCalled();
+ * o recorder fica parado e o chamador decide quando religa-lo. */
+void DespejoImediato(void);
+
+void DespejoObterEstatisticas(EstatisticaDespejo_t* pxEstatisticas);
+
+/* Bytes da copia do cabecalho do recorder (so no modo snapshot). */
+extern const size_t xRamDespejo;
+
+#endif /* DESPEJO_RASTREIO_H */
@@ -0,0 +1,281 @@
+/*
+ * Escalonamento RM/EDF das tarefas periodicas da aplicacao.  Ver Escalonador.h.
+ *
+ * O estado das tarefas e alterado pela tarefa de temporizadores (liberacoes) e
+ * pelas tarefas registradas (conclusoes), nunca por interrupcoes, entao
+ * suspender o escalonador basta para a exclusao mutua.  Com o escalonador
+ * suspenso as trocas de prioridade de uma reatribuicao acontecem todas antes
+ * da proxima troca de contexto.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "Escalonador.h"
+
+typedef struct {
+    TaskHandle_t xTarefa;
+    TickType_t xPeriodo;
+    TickType_t xPrazoRelativo;
+    UBaseType_t uxPrioridadeFixa;
+    UBaseType_t uxPrioridadeAtual;
+
+    BaseType_t xAtivo;
+    TickType_t xPrazo;              /* Prazo absoluto do trabalho ativo */
+    BaseType_t xPendente;
+    TickType_t xPrazoPendente;
+
+    EstatisticaEscalonador_t xEstatisticas;
+} TarefaEscalonada_t;
+
+static TarefaEscalonada_t xTarefas[escalonadorMAX_TAREFAS];
+static UBaseType_t uxNumTarefas;
+static PoliticaEscalonamento_t ePoliticaAtual;
+static UBaseType_t uxFaixaMinima;
+static UBaseType_t uxFaixaMaxima;
+
+/* Os temporizadores sobrevivem a EscalonadorInicializar e sao reaproveitados
+ * pela tarefa registrada na mesma posicao. */
+static TimerHandle_t xTemporizadores[escalonadorMAX_TAREFAS];
+static StaticTimer_t xTemporizadoresEstaticos[escalonadorMAX_TAREFAS];
+
+/*-----------------------------------------------------------*/
+
+/* a vem antes de b, com o contador de ticks dando a volta. */
+static BaseType_t prvAntes(TickType_t a, TickType_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDefinirPrioridade(TarefaEscalonada_t* pxTarefa, UBaseType_t uxPrioridade)
+{
+    if (pxTarefa->uxPrioridadeAtual != uxPrioridade) {
+        pxTarefa->uxPrioridadeAtual = uxPrioridade;
+        pxTarefa->xEstatisticas.ulTrocasPrioridade++;
+        vTaskPrioritySet(pxTarefa->xTarefa, uxPrioridade);
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Chamado com o escalonador suspenso. */
+static void prvReatribuir(void)
+{
+    UBaseType_t uxOrdem[escalonadorMAX_TAREFAS];
+    UBaseType_t uxAtivos = 0;
+    UBaseType_t uxPrioridade = uxFaixaMaxima;
+    UBaseType_t i, j;
+
+    if (ePoliticaAtual != ESCALONAMENTO_EDF)
+        return;
+
+    /* Insercao ordenada por prazo absoluto; poucas tarefas. */
+    for (i = 0; i < uxNumTarefas; i++) {
+        if (!xTarefas[i].xAtivo) {
+            prvDefinirPrioridade(&xTarefas[i], uxFaixaMinima);
+            continue;
+        }
+        for (j = uxAtivos; j > 0 && prvAntes(xTarefas[i].xPrazo, xTarefas[uxOrdem[j - 1]].xPrazo); j--)
+            uxOrdem[j] = uxOrdem[j - 1];
+        uxOrdem[j] = i;
+        uxAtivos++;
+    }
+
+    for (i = 0; i < uxAtivos; i++) {
+        prvDefinirPrioridade(&xTarefas[uxOrdem[i]], uxPrioridade);
+        if (uxPrioridade > uxFaixaMinima)
+            uxPrioridade--;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static TarefaEscalonada_t* prvTarefaCorrente(void)
+{
+    TaskHandle_t xCorrente = xTaskGetCurrentTaskHandle();
+    UBaseType_t i;
+
+    for (i = 0; i < uxNumTarefas; i++)
+        if (xTarefas[i].xTarefa == xCorrente)
+            return &xTarefas[i];
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+/* Roda na tarefa de temporizadores. */
+static void prvLiberar(TimerHandle_t xTemporizador)
+{
+    UBaseType_t uxIndice = (UBaseType_t)(uintptr_t)pvTimerGetTimerID(xTemporizador);
+    TarefaEscalonada_t* pxTarefa = &xTarefas[uxIndice];
+    TaskHandle_t xNotificar = NULL;
+    TickType_t xAgora;
+
+    vTaskSuspendAll();
+    {
+        if (uxIndice < uxNumTarefas) {
+            xAgora = xTaskGetTickCount();
+            pxTarefa->xEstatisticas.ulLiberacoes++;
+
+            if (!pxTarefa->xAtivo) {
+                pxTarefa->xAtivo = pdTRUE;
+                pxTarefa->xPrazo = xAgora + pxTarefa->xPrazoRelativo;
+                xNotificar = pxTarefa->xTarefa;
+            }
+            else if (!pxTarefa->xPendente) {
+                pxTarefa->xPendente = pdTRUE;
+                pxTarefa->xPrazoPendente = xAgora + pxTarefa->xPrazoRelativo;
+                xNotificar = pxTarefa->xTarefa;
+            }
+            else
+                pxTarefa->xEstatisticas.ulDescartadas++;
+
+            prvReatribuir();
+        }
+    }
+    (void)xTaskResumeAll();
+
+    if (xNotificar != NULL)
+        xTaskNotifyGive(xNotificar);
+}
+/*-----------------------------------------------------------*/
+
+void EscalonadorInicializar(PoliticaEscalonamento_t ePolitica, UBaseType_t uxPrioridadeMinima, UBaseType_t uxPrioridadeMaxima)
+{
+    UBaseType_t i;
+
+    configASSERT(uxPrioridadeMinima <= uxPrioridadeMaxima && uxPrioridadeMaxima < configMAX_PRIORITIES);
+
+    /* A tarefa de temporizadores tem prioridade maior que quem chama, entao
+     * cada parada ja foi processada quando xTimerStop retorna. */
+    for (i = 0; i < uxNumTarefas; i++)
+        xTimerStop(xTemporizadores[i], portMAX_DELAY);
+
+    vTaskSuspendAll();
+    {
+        memset(xTarefas, 0, sizeof(xTarefas));
+        uxNumTarefas = 0;
+        ePoliticaAtual = ePolitica;
+        uxFaixaMinima = uxPrioridadeMinima;
+        uxFaixaMaxima = uxPrioridadeMaxima;
+    }
+    (void)xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t EscalonadorRegistrar(TaskHandle_t xTarefa, TickType_t xPeriodo, TickType_t xPrazo, UBaseType_t uxPrioridadeFixa)
+{
+    TarefaEscalonada_t* pxTarefa;
+    UBaseType_t uxIndice;
+
+    configASSERT(xTarefa != NULL && xPeriodo > 0 && xPrazo > 0);
+
+    if (uxNumTarefas == escalonadorMAX_TAREFAS)
+        return pdFAIL;
+
+    uxIndice = uxNumTarefas;
+    pxTarefa = &xTarefas[uxIndice];
+    pxTarefa->xTarefa = xTarefa;
+    pxTarefa->xPeriodo = xPeriodo;
+    pxTarefa->xPrazoRelativo = xPrazo;
+    pxTarefa->uxPrioridadeFixa = uxPrioridadeFixa;
+
+    if (xTemporizadores[uxIndice] == NULL) {
+        xTemporizadores[uxIndice] = xTimerCreateStatic("Liberacao", xPeriodo, pdTRUE, (void*)(uintptr_t)uxIndice,
+                                                       prvLiberar, &xTemporizadoresEstaticos[uxIndice]);
+        configASSERT(xTemporizadores[uxIndice] != NULL);
+    }
+
+    /* Sem trabalho ativo a tarefa comeca na prioridade minima da faixa.  Antes
+     * do escalonador iniciar a prioridade de criacao fica ate a primeira
+     * reatribuicao, porque vTaskPrioritySet pode pedir uma troca de contexto. */
+    pxTarefa->uxPrioridadeAtual = ePoliticaAtual == ESCALONAMENTO_EDF ? uxFaixaMinima : uxPrioridadeFixa;
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+        vTaskPrioritySet(xTarefa, pxTarefa->uxPrioridadeAtual);
+    else
+        pxTarefa->uxPrioridadeAtual = uxTaskPriorityGet(xTarefa);
+
+    vTaskSuspendAll();
+    {
+        uxNumTarefas++;
+    }
+    (void)xTaskResumeAll();
+
+    /* Tambem inicia o temporizador. */
+    xTimerChangePeriod(xTemporizadores[uxIndice], xPeriodo, portMAX_DELAY);
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void EscalonadorAguardarLiberacao(void)
+{
+    /* Uma notificacao por liberacao (a ativa e a pendente): toma uma de cada
+     * vez, como um semaforo contador, para o trabalho pendente nao se perder
+     * quando as duas chegam antes de a tarefa acordar. */
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+}
+/*-----------------------------------------------------------*/
+
+void EscalonadorConcluir(void)
+{
+    TarefaEscalonada_t* pxTarefa;
+    TickType_t xAgora;
+    TickType_t xAtraso;
+
+    vTaskSuspendAll();
+    {
+        pxTarefa = prvTarefaCorrente();
+
+        /* Trabalho feito antes da primeira liberacao nao conta. */
+        if (pxTarefa != NULL && pxTarefa->xAtivo) {
+            xAgora = xTaskGetTickCount();
+            xAtraso = xAgora - pxTarefa->xPrazo;
+            if (prvAntes(pxTarefa->xPrazo, xAgora)) {
+                pxTarefa->xEstatisticas.ulPrazosPerdidos++;
+                if (xAtraso > pxTarefa->xEstatisticas.xAtrasoMax)
+                    pxTarefa->xEstatisticas.xAtrasoMax = xAtraso;
+            }
+            pxTarefa->xEstatisticas.ulConcluidos++;
+
+            if (pxTarefa->xPendente) {
+                pxTarefa->xPrazo = pxTarefa->xPrazoPendente;
+                pxTarefa->xPendente = pdFALSE;
+            }
+            else
+                pxTarefa->xAtivo = pdFALSE;
+
+            prvReatribuir();
+        }
+    }
+    (void)xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void EscalonadorObterEstatisticas(EstatisticaEscalonador_t* pxEstatisticas)
+{
+    UBaseType_t i;
+
+    memset(pxEstatisticas, 0, sizeof(*pxEstatisticas));
+
+    vTaskSuspendAll();
+    {
+        for (i = 0; i < uxNumTarefas; i++) {
+            const EstatisticaEscalonador_t* pxTarefa = &xTarefas[i].xEstatisticas;
+
+            pxEstatisticas->ulLiberacoes += pxTarefa->ulLiberacoes;
+            pxEstatisticas->ulConcluidos += pxTarefa->ulConcluidos;
+            pxEstatisticas->ulPrazosPerdidos += pxTarefa->ulPrazosPerdidos;
+            pxEstatisticas->ulDescartadas += pxTarefa->ulDescartadas;
+            pxEstatisticas->ulTrocasPrioridade += pxTarefa->ulTrocasPrioridade;
+            if (pxTarefa->xAtrasoMax > pxEstatisticas->xAtrasoMax)
+                pxEstatisticas->xAtrasoMax = pxTarefa->xAtrasoMax;
+        }
+    }
+    (void)xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
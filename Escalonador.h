@@ -0,0 +1,63 @@
+#ifndef ESCALONADOR_H
+#define ESCALONADOR_H
+
+/*
+ * Camada de escalonamento para tarefas periodicas da aplicacao, com prioridade
+ * fixa (rate monotonic) ou Earliest Deadline First.
+ *
+ * Cada tarefa registrada tem um temporizador auto-recarregavel que marca as
+ * liberacoes.  O callback roda na tarefa de temporizadores, que tem a maior
+ * prioridade do sistema, calcula o prazo absoluto do trabalho e notifica a
+ * tarefa; assim a liberacao nao depende de a propria tarefa conseguir
+ * executar.  A tarefa espera a liberacao com EscalonadorAguardarLiberacao() e
+ * avisa o fim do trabalho com EscalonadorConcluir().
+ *
+ * Com ESCALONAMENTO_EDF as prioridades da faixa [uxPrioridadeMinima,
+ * uxPrioridadeMaxima] sao reatribuidas a cada liberacao e a cada conclusao: o
+ * trabalho ativo de prazo mais proximo fica com a prioridade maxima, o
+ * seguinte com a de baixo, e assim por diante.  Trabalhos que sobram alem da
+ * faixa e tarefas sem trabalho ativo ficam na prioridade minima.  Com
+ * ESCALONAMENTO_RM cada tarefa fica na prioridade dada no registro.
+ *
+ * Se uma liberacao chega com o trabalho anterior ainda ativo ela fica pendente
+ * e comeca logo que o anterior termina; uma terceira liberacao nesse meio
+ * tempo e descartada.  Prazos perdidos sao contados na conclusao.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#define escalonadorMAX_TAREFAS      8
+
+typedef enum {
+    ESCALONAMENTO_RM = 0,
+    ESCALONAMENTO_EDF
+} PoliticaEscalonamento_t;
+
+/* Tempos em ticks. */
+typedef struct {
+    uint32_t ulLiberacoes;
+    uint32_t ulConcluidos;
+    uint32_t ulPrazosPerdidos;
+    uint32_t ulDescartadas;         /* Liberacoes perdidas por acumulo */
+    uint32_t ulTrocasPrioridade;
+    TickType_t xAtrasoMax;          /* Maior atraso alem do prazo */
+} EstatisticaEscalonador_t;
+
+/* Remove as tarefas registradas, para os seus temporizadores e zera as
+ * estatisticas.  As tarefas em si nao sao apagadas. */
+void EscalonadorInicializar(PoliticaEscalonamento_t ePolitica, UBaseType_t uxPrioridadeMinima, UBaseType_t uxPrioridadeMaxima);
+
+/* A primeira liberacao acontece xPeriodo depois do registro.  uxPrioridadeFixa
+ * so e usada com ESCALONAMENTO_RM.  Retorna pdFAIL se nao houver espaco. */
+BaseType_t EscalonadorRegistrar(TaskHandle_t xTarefa, TickType_t xPeriodo, TickType_t xPrazo, UBaseType_t uxPrioridadeFixa);
+
+/* Chamadas pela tarefa registrada. */
+void EscalonadorAguardarLiberacao(void);
+void EscalonadorConcluir(void);
+
+/* Soma das estatisticas de todas as tarefas registradas. */
+void EscalonadorObterEstatisticas(EstatisticaEscalonador_t* pxEstatisticas);
+
+#endif /* ESCALONADOR_H */
@@ -0,0 +1,139 @@
+/*
+ * Estado consolidado do gateway com seqlock por bloco de zonas.  Ver
+ * EstadoGateway.h.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Atomico.h"
+#include "EstadoGateway.h"
+
+static volatile uint32_t ulSequencia[estadoNUM_BLOCOS];
+static volatile uint32_t ulMudancas[estadoNUM_BLOCOS];
+static BlocoEstado_t xBlocos[estadoNUM_BLOCOS];
+static EstatisticaEstado_t xEstatisticas;
+
+const size_t xRamEstado = sizeof(ulSequencia) + sizeof(ulMudancas) + sizeof(xBlocos);
+
+/*-----------------------------------------------------------*/
+
+void EstadoInicializar(void)
+{
+    memset((void*)ulSequencia, 0, sizeof(ulSequencia));
+    memset((void*)ulMudancas, 0, sizeof(ulMudancas));
+    memset(xBlocos, 0, sizeof(xBlocos));
+    memset(&xEstatisticas, 0, sizeof(xEstatisticas));
+}
+/*-----------------------------------------------------------*/
+
+BlocoEstado_t* EstadoIniciarEscrita(UBaseType_t uxBloco)
+{
+    configASSERT(uxBloco < estadoNUM_BLOCOS);
+
+    taskENTER_CRITICAL();
+
+    ulSequencia[uxBloco]++;
+
+    /* A sequencia impar precisa ficar visivel antes de qualquer dado. */
+    atomicoBARREIRA_LIBERAR();
+
+    return &xBlocos[uxBloco];
+}
+/*-----------------------------------------------------------*/
+
+void EstadoConcluirEscrita(UBaseType_t uxBloco, uint32_t ulMudancasBloco)
+{
+    xBlocos[uxBloco].xAtualizacao = xTaskGetTickCount();
+
+    atomicoBARREIRA_LIBERAR();
+    ulSequencia[uxBloco]++;
+
+    /* Ainda dentro da secao critica, entao nao disputa com EstadoTomarMudancas. */
+    ulMudancas[uxBloco] |= ulMudancasBloco;
+
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+uint32_t EstadoTomarMudancas(UBaseType_t uxBloco)
+{
+    uint32_t ulTomadas;
+
+    configASSERT(uxBloco < estadoNUM_BLOCOS);
+
+    /* Leitura sem trava para pular rapido os blocos sem mudanca.  Uma marca
+     * que chegue logo depois vem acompanhada de um evento, e o controlador
+     * passa de novo. */
+    if (ulMudancas[uxBloco] == 0)
+        return 0;
+
+    taskENTER_CRITICAL();
+    {
+        ulTomadas = ulMudancas[uxBloco];
+        ulMudancas[uxBloco] = 0;
+    }
+    taskEXIT_CRITICAL();
+
+    return ulTomadas;
+}
+/*-----------------------------------------------------------*/
+
+void EstadoLerBloco(UBaseType_t uxBloco, BlocoEstado_t* pxCopia)
+{
+    configRUN_TIME_COUNTER_TYPE ulInicio = ulGetRunTimeCounterValue();
+    configRUN_TIME_COUNTER_TYPE ulLatencia;
+    uint32_t ulAntes, ulDepois;
+    uint32_t ulRepeticoes = 0;
+
+    configASSERT(uxBloco < estadoNUM_BLOCOS);
+
+    for (;;) {
+        ulAntes = ulSequencia[uxBloco];
+        atomicoBARREIRA_ADQUIRIR();
+
+        if ((ulAntes & 1) == 0) {
+            memcpy(pxCopia, &xBlocos[uxBloco], sizeof(BlocoEstado_t));
+
+            atomicoBARREIRA_ADQUIRIR();
+            ulDepois = ulSequencia[uxBloco];
+
+            if (ulAntes == ulDepois)
+                break;
+        }
+
+        /* Escrita em andamento ou leitura rasgada. */
+        ulRepeticoes++;
+    }
+
+    ulLatencia = ulGetRunTimeCounterValue() - ulInicio;
+
+    /* As estatisticas sao atualizadas apenas pelos leitores; com um unico
+     * controlador nao ha disputa por elas.  A secao critica protege quem as
+     * copia: os campos de 64 bits nao sao escritos atomicamente. */
+    taskENTER_CRITICAL();
+    {
+        xEstatisticas.ulLeituras++;
+        xEstatisticas.ulRepeticoes += ulRepeticoes;
+        xEstatisticas.ullLatenciaTotal += ulLatencia;
+
+        if (ulLatencia > xEstatisticas.ullLatenciaMax)
+            xEstatisticas.ullLatenciaMax = ulLatencia;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void EstadoObterEstatisticas(EstatisticaEstado_t* pxEstatisticas)
+{
+    taskENTER_CRITICAL();
+    {
+        *pxEstatisticas = xEstatisticas;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
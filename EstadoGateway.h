@@ -0,0 +1,79 @@
+#ifndef ESTADO_GATEWAY_H
+#define ESTADO_GATEWAY_H
+
+/*
+ * Estado consolidado dos sensores de todas as zonas do gateway, publicado com
+ * um seqlock por bloco de zonas.
+ *
+ * As zonas sao agrupadas em blocos de estadoZONAS_POR_BLOCO, e dentro de um
+ * bloco cada campo e um vetor (estrutura de vetores), entao uma varredura das
+ * zonas percorre a memoria em sequencia campo a campo.  Os modulos sensores
+ * atualizam um bloco inteiro entre EstadoIniciarEscrita() e
+ * EstadoConcluirEscrita(); o contador de sequencia do bloco fica impar durante
+ * a escrita.  EstadoLerBloco() copia o bloco sem bloquear os escritores e
+ * repete a copia apenas se a sequencia mudou durante a leitura, de modo que
+ * todas as decisoes do controlador sobre uma zona usam leituras de um mesmo
+ * instante.
+ *
+ * O escritor fica numa secao critica de EstadoIniciarEscrita() ate
+ * EstadoConcluirEscrita().  Neste port de um so nucleo nenhum leitor roda
+ * durante uma escrita, entao a copia nunca e repetida e ulRepeticoes fica
+ * sempre em 0; o seqlock so faz diferenca com leitores em outro nucleo.
+ *
+ * Cada escrita informa quais zonas do bloco mudaram de forma relevante para o
+ * controle.  Essas marcas se acumulam num mapa de bits por bloco que o
+ * controlador consome com EstadoTomarMudancas(), e assim so olha as zonas que
+ * mudaram.
+ */
+
+#include "FreeRTOS.h"
+
+#define estadoMAX_ZONAS             10000
+#define estadoZONAS_POR_BLOCO       32
+#define estadoNUM_BLOCOS            ( ( estadoMAX_ZONAS + estadoZONAS_POR_BLOCO - 1 ) / estadoZONAS_POR_BLOCO )
+
+/* Bits de ucDefeitos */
+#define estadoDEFEITO_VENTOINHA     ( 1 << 0 )
+#define estadoDEFEITO_COMPRESSOR    ( 1 << 1 )
+#define estadoDEFEITO_PARTICULAS    ( 1 << 2 )
+#define estadoPRESENCA_GAS          ( 1 << 3 )
+
+typedef struct {
+    int32_t lPessoasAnterior[estadoZONAS_POR_BLOCO];
+    int32_t lPessoas[estadoZONAS_POR_BLOCO];
+    int32_t lTemperaturaAnterior[estadoZONAS_POR_BLOCO];
+    int32_t lTemperatura[estadoZONAS_POR_BLOCO];
+    uint32_t ulDefeitos[estadoZONAS_POR_BLOCO];     /* Amostras com defeito desde o inicio */
+    configRUN_TIME_COUNTER_TYPE ulMudanca[estadoZONAS_POR_BLOCO];  /* Instante da ultima mudanca relevante para o controle */
+    uint8_t ucDefeitos[estadoZONAS_POR_BLOCO];      /* estadoDEFEITO_* das amostras mais recentes */
+    TickType_t xAtualizacao;                        /* Tick da ultima escrita no bloco */
+} BlocoEstado_t;
+
+/* Contadores do lado leitor.  Latencias em unidades do contador de run time. */
+typedef struct {
+    uint32_t ulLeituras;
+    uint32_t ulRepeticoes;
+    uint64_t ullLatenciaTotal;
+    uint64_t ullLatenciaMax;
+} EstatisticaEstado_t;
+
+void EstadoInicializar(void);
+
+/* Escritores: a escrita inteira, do inicio a conclusao, e uma secao critica,
+ * entao deve ser curta e nao pode bloquear.  ulMudancas tem um bit por zona do
+ * bloco (bit 0 = primeira zona do bloco). */
+BlocoEstado_t* EstadoIniciarEscrita(UBaseType_t uxBloco);
+void EstadoConcluirEscrita(UBaseType_t uxBloco, uint32_t ulMudancas);
+
+/* Controlador: retorna e zera as marcas de mudanca acumuladas no bloco. */
+uint32_t EstadoTomarMudancas(UBaseType_t uxBloco);
+
+/* Leitores: copia consistente de um bloco. */
+void EstadoLerBloco(UBaseType_t uxBloco, BlocoEstado_t* pxCopia);
+
+void EstadoObterEstatisticas(EstatisticaEstado_t* pxEstatisticas);
+
+/* Bytes dos blocos e contadores, para o orcamento de RAM de main.c. */
+extern const size_t xRamEstado;
+
+#endif /* ESTADO_GATEWAY_H */
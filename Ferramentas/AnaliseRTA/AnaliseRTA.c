@@ -0,0 +1,473 @@
+/*
+ * Analise de escalonabilidade do gateway, executada no host.
+ *
+ * Le a tabela de tarefas (TarefasGateway.txt por padrao) e calcula:
+ * - utilizacao e os limites de Liu & Layland e hiperbolico do rate monotonic;
+ * - o tempo de resposta exato de cada tarefa periodica por analise de tempo de
+ *   resposta (RTA), com bloqueio por mutex (heranca de prioridade, como nos
+ *   mutexes do FreeRTOS) e o jitter de liberacao do Deferrable Server;
+ * - um limite do tempo de resposta das tarefas aperiodicas executadas pelo
+ *   servidor, com o trabalho sozinho e com a fila cheia.  A fila do servidor e
+ *   FIFO e a tabela admite todas as aperiodicas enfileiradas juntas, entao as
+ *   duas precisam cumprir o prazo;
+ * - a folga: fator pelo qual todos os wcet podem crescer, quantas zonas o
+ *   gateway comporta (os wcet das tarefas de varredura crescem com as zonas) e
+ *   quanto o wcet de cada tarefa de varredura pode crescer sozinho antes de
+ *   algum prazo ser perdido.
+ *
+ * Tarefas de mesma prioridade interferem umas nas outras (round robin).
+ *
+ * Uso: AnaliseRTA [tabela]
+ * Fora do MSVC: gcc -O2 -o AnaliseRTA AnaliseRTA.c -lm
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define rtaMAX_TAREFAS      64
+#define rtaMAX_APERIODICAS  16
+#define rtaMAX_NOME         32
+#define rtaMAX_ZONAS        10000   /* estadoMAX_ZONAS do gateway */
+
+#define rtaTABELA_PADRAO    "TarefasGateway.txt"
+
+typedef enum {
+    TAREFA_VARREDURA = 0,
+    TAREFA_PERIODICA,
+    TAREFA_SERVIDOR
+} TipoTarefa_t;
+
+typedef struct {
+    char cNome[rtaMAX_NOME];
+    TipoTarefa_t eTipo;
+    int iPrioridade;
+    double dPeriodo;
+    double dPrazo;
+    double dWcet;
+    double dJitter;                 /* Liberacao atrasada ate dJitter apos o periodo */
+    char cRecurso[rtaMAX_NOME];     /* Vazio: nao usa mutex */
+    double dSecao;
+} Tarefa_t;
+
+typedef struct {
+    char cNome[rtaMAX_NOME];
+    double dWcet;
+    double dPrazo;
+} Aperiodica_t;
+
+typedef struct {
+    Tarefa_t xTarefas[rtaMAX_TAREFAS];
+    int iNumTarefas;
+    Aperiodica_t xAperiodicas[rtaMAX_APERIODICAS];
+    int iNumAperiodicas;
+    int iServidor;                  /* Indice em xTarefas, -1 sem servidor */
+    int iDeferrable;
+    int iZonas;                     /* Zonas com que os wcet de varredura foram medidos */
+} Conjunto_t;
+
+typedef struct {
+    double dBloqueio;
+    double dResposta;
+    int iCumpre;
+} ResultadoTarefa_t;
+
+typedef struct {
+    double dSozinha;
+    double dFilaCheia;
+} ResultadoAperiodica_t;
+
+static Conjunto_t xBase;
+static Conjunto_t xTrabalho;
+static ResultadoTarefa_t xResultados[rtaMAX_TAREFAS];
+
+/* Mutexes do conjunto em analise */
+static int iGrupo[rtaMAX_TAREFAS];
+static int iTeto[rtaMAX_TAREFAS];
+static double dMaiorSecao[rtaMAX_TAREFAS];
+static int iNumGrupos;
+
+/*-----------------------------------------------------------*/
+
+static int prvLerTabela(const char* pcArquivo, Conjunto_t* pxConjunto)
+{
+    FILE* pxArquivo = fopen(pcArquivo, "r");
+    char cLinha[256];
+    char cTipo[16];
+    char cPolitica[16];
+    int iLinha = 0;
+    int iCampos;
+    Tarefa_t* pxTarefa;
+    Aperiodica_t* pxAperiodica;
+
+    if (pxArquivo == NULL) {
+        fprintf(stderr, "Nao foi possivel abrir %s\n", pcArquivo);
+        return 0;
+    }
+
+    memset(pxConjunto, 0, sizeof(*pxConjunto));
+    pxConjunto->iServidor = -1;
+    pxConjunto->iZonas = 1;
+
+    while (fgets(cLinha, sizeof(cLinha), pxArquivo) != NULL) {
+        iLinha++;
+        if (sscanf(cLinha, "%15s", cTipo) != 1 || cTipo[0] == '#')
+            continue;
+
+        if (strcmp(cTipo, "zonas") == 0) {
+            if (sscanf(cLinha, "%*s %d", &pxConjunto->iZonas) != 1 || pxConjunto->iZonas < 1)
+                goto erro;
+            continue;
+        }
+
+        if (strcmp(cTipo, "aperiodica") == 0) {
+            if (pxConjunto->iNumAperiodicas == rtaMAX_APERIODICAS)
+                goto erro;
+            pxAperiodica = &pxConjunto->xAperiodicas[pxConjunto->iNumAperiodicas];
+            if (sscanf(cLinha, "%*s %31s %lf %lf", pxAperiodica->cNome, &pxAperiodica->dWcet, &pxAperiodica->dPrazo) != 3)
+                goto erro;
+            pxConjunto->iNumAperiodicas++;
+            continue;
+        }
+
+        if (pxConjunto->iNumTarefas == rtaMAX_TAREFAS)
+            goto erro;
+        pxTarefa = &pxConjunto->xTarefas[pxConjunto->iNumTarefas];
+        memset(pxTarefa, 0, sizeof(*pxTarefa));
+
+        if (strcmp(cTipo, "servidor") == 0) {
+            if (pxConjunto->iServidor >= 0)
+                goto erro;
+            if (sscanf(cLinha, "%*s %31s %d %lf %lf %15s", pxTarefa->cNome, &pxTarefa->iPrioridade,
+                       &pxTarefa->dPeriodo, &pxTarefa->dWcet, cPolitica) != 5)
+                goto erro;
+            pxTarefa->eTipo = TAREFA_SERVIDOR;
+            pxTarefa->dPrazo = pxTarefa->dPeriodo;
+            pxConjunto->iDeferrable = strcmp(cPolitica, "deferrable") == 0;
+            if (!pxConjunto->iDeferrable && strcmp(cPolitica, "esporadico") != 0)
+                goto erro;
+            /* O Deferrable Server pode usar a capacidade no fim de um periodo
+             * e de novo no inicio do seguinte: para as tarefas abaixo dele e
+             * uma tarefa periodica com jitter de T - C. */
+            if (pxConjunto->iDeferrable)
+                pxTarefa->dJitter = pxTarefa->dPeriodo - pxTarefa->dWcet;
+            pxConjunto->iServidor = pxConjunto->iNumTarefas;
+        }
+        else if (strcmp(cTipo, "varredura") == 0 || strcmp(cTipo, "periodica") == 0) {
+            iCampos = sscanf(cLinha, "%*s %31s %d %lf %lf %lf %31s %lf", pxTarefa->cNome, &pxTarefa->iPrioridade,
+                             &pxTarefa->dPeriodo, &pxTarefa->dPrazo, &pxTarefa->dWcet,
+                             pxTarefa->cRecurso, &pxTarefa->dSecao);
+            if (iCampos != 5 && iCampos != 7)
+                goto erro;
+            if (iCampos == 5)
+                pxTarefa->cRecurso[0] = '\0';
+            pxTarefa->eTipo = cTipo[0] == 'v' ? TAREFA_VARREDURA : TAREFA_PERIODICA;
+        }
+        else
+            goto erro;
+
+        if (pxTarefa->dPeriodo <= 0 || pxTarefa->dWcet < 0 || pxTarefa->dSecao > pxTarefa->dWcet)
+            goto erro;
+        pxConjunto->iNumTarefas++;
+    }
+
+    fclose(pxArquivo);
+    return 1;
+
+erro:
+    fprintf(stderr, "%s:%d: linha invalida\n", pcArquivo, iLinha);
+    fclose(pxArquivo);
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+/* Agrupa as tarefas que usam o mesmo mutex e calcula o teto de cada grupo (a
+ * maior prioridade entre as tarefas que o usam). */
+static void prvAgruparRecursos(const Conjunto_t* pxConjunto)
+{
+    int i, k;
+
+    iNumGrupos = 0;
+    for (i = 0; i < pxConjunto->iNumTarefas; i++) {
+        const Tarefa_t* pxI = &pxConjunto->xTarefas[i];
+
+        iGrupo[i] = -1;
+        if (pxI->cRecurso[0] == '\0')
+            continue;
+
+        for (k = 0; k < i; k++) {
+            if (iGrupo[k] >= 0 && strcmp(pxI->cRecurso, pxConjunto->xTarefas[k].cRecurso) == 0) {
+                iGrupo[i] = iGrupo[k];
+                break;
+            }
+        }
+        if (iGrupo[i] < 0) {
+            iGrupo[i] = iNumGrupos;
+            iTeto[iNumGrupos++] = pxI->iPrioridade;
+        }
+        else if (pxI->iPrioridade > iTeto[iGrupo[i]])
+            iTeto[iGrupo[i]] = pxI->iPrioridade;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Com heranca de prioridade a tarefa i e bloqueada no maximo uma vez por
+ * mutex, pela maior secao critica de uma tarefa de prioridade menor, e so por
+ * mutexes cujo teto e >= prioridade de i (bloqueio direto ou por heranca). */
+static double prvBloqueio(const Conjunto_t* pxConjunto, int i)
+{
+    int iPrioridade = pxConjunto->xTarefas[i].iPrioridade;
+    double dBloqueio = 0;
+    int g, k;
+
+    for (g = 0; g < iNumGrupos; g++)
+        dMaiorSecao[g] = 0;
+
+    for (k = 0; k < pxConjunto->iNumTarefas; k++) {
+        const Tarefa_t* pxK = &pxConjunto->xTarefas[k];
+
+        g = iGrupo[k];
+        if (g >= 0 && pxK->iPrioridade < iPrioridade && iTeto[g] >= iPrioridade && pxK->dSecao > dMaiorSecao[g])
+            dMaiorSecao[g] = pxK->dSecao;
+    }
+
+    for (g = 0; g < iNumGrupos; g++)
+        dBloqueio += dMaiorSecao[g];
+
+    return dBloqueio;
+}
+/*-----------------------------------------------------------*/
+
+/* R = C + B + soma, para j de prioridade >= i, de ceil((R + Jj) / Tj) * Cj.
+ * Retorna o tempo de resposta a partir da liberacao ou HUGE_VAL se passar do
+ * prazo. */
+static double prvTempoResposta(const Conjunto_t* pxConjunto, int i, double dBloqueio)
+{
+    const Tarefa_t* pxI = &pxConjunto->xTarefas[i];
+    double dResposta = pxI->dWcet + dBloqueio;
+    double dProxima;
+    int j;
+
+    for (;;) {
+        dProxima = pxI->dWcet + dBloqueio;
+        for (j = 0; j < pxConjunto->iNumTarefas; j++) {
+            const Tarefa_t* pxJ = &pxConjunto->xTarefas[j];
+
+            if (j != i && pxJ->iPrioridade >= pxI->iPrioridade)
+                dProxima += ceil((dResposta + pxJ->dJitter) / pxJ->dPeriodo - 1e-9) * pxJ->dWcet;
+        }
+
+        if (dProxima > pxI->dPrazo)
+            return HUGE_VAL;
+        if (dProxima <= dResposta + 1e-9)
+            return dProxima;
+        dResposta = dProxima;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Trabalho de custo dTrabalho na fila do servidor: no pior caso chega quando a
+ * capacidade acabou de esgotar e espera T - C pela recarga; cada recarga
+ * seguinte entrega C, e a ultima termina ate Rs apos a recarga. */
+static double prvRespostaAperiodica(const Conjunto_t* pxConjunto, double dTrabalho)
+{
+    const Tarefa_t* pxServidor = &pxConjunto->xTarefas[pxConjunto->iServidor];
+    double dRecargas = ceil(dTrabalho / pxServidor->dWcet - 1e-9);
+
+    if (xResultados[pxConjunto->iServidor].dResposta == HUGE_VAL)
+        return HUGE_VAL;
+
+    return (pxServidor->dPeriodo - pxServidor->dWcet) + (dRecargas - 1) * pxServidor->dPeriodo +
+           xResultados[pxConjunto->iServidor].dResposta;
+}
+/*-----------------------------------------------------------*/
+
+/* Preenche xResultados e retorna 1 se todas as tarefas periodicas e o servidor
+ * cumprem o prazo, e cada aperiodica tambem atras de todas as outras na fila. */
+static int prvAnalisar(const Conjunto_t* pxConjunto, ResultadoAperiodica_t* pxAperiodicas)
+{
+    double dFila = 0;
+    int iCumpre = 1;
+    int i;
+
+    prvAgruparRecursos(pxConjunto);
+
+    for (i = 0; i < pxConjunto->iNumTarefas; i++) {
+        xResultados[i].dBloqueio = prvBloqueio(pxConjunto, i);
+        xResultados[i].dResposta = prvTempoResposta(pxConjunto, i, xResultados[i].dBloqueio);
+        xResultados[i].iCumpre = xResultados[i].dResposta != HUGE_VAL;
+        iCumpre = iCumpre && xResultados[i].iCumpre;
+    }
+
+    if (pxConjunto->iServidor < 0)
+        return iCumpre;
+
+    for (i = 0; i < pxConjunto->iNumAperiodicas; i++)
+        dFila += pxConjunto->xAperiodicas[i].dWcet;
+
+    for (i = 0; i < pxConjunto->iNumAperiodicas; i++) {
+        double dSozinha = prvRespostaAperiodica(pxConjunto, pxConjunto->xAperiodicas[i].dWcet);
+        double dFilaCheia = prvRespostaAperiodica(pxConjunto, dFila);
+
+        if (pxAperiodicas != NULL) {
+            pxAperiodicas[i].dSozinha = dSozinha;
+            pxAperiodicas[i].dFilaCheia = dFilaCheia;
+        }
+        iCumpre = iCumpre && dFilaCheia <= pxConjunto->xAperiodicas[i].dPrazo;
+    }
+
+    return iCumpre;
+}
+/*-----------------------------------------------------------*/
+
+/* Copia a base multiplicando por dFator o wcet (e a secao critica) da tarefa
+ * iTarefa, ou de todas as tarefas de varredura com iTarefa < 0.  Com iTodas
+ * multiplica todas as tarefas e aperiodicas. */
+static void prvEscalar(const Conjunto_t* pxBase, Conjunto_t* pxConjunto, int iTarefa, int iTodas, double dFator)
+{
+    int i;
+
+    *pxConjunto = *pxBase;
+
+    for (i = 0; i < pxConjunto->iNumTarefas; i++) {
+        Tarefa_t* pxTarefa = &pxConjunto->xTarefas[i];
+
+        /* A capacidade do servidor e reservada, nao medida. */
+        if (pxTarefa->eTipo == TAREFA_SERVIDOR)
+            continue;
+        if (!iTodas && (iTarefa >= 0 ? i != iTarefa : pxTarefa->eTipo != TAREFA_VARREDURA))
+            continue;
+        pxTarefa->dWcet *= dFator;
+        pxTarefa->dSecao *= dFator;
+    }
+
+    for (i = 0; iTodas && i < pxConjunto->iNumAperiodicas; i++)
+        pxConjunto->xAperiodicas[i].dWcet *= dFator;
+}
+/*-----------------------------------------------------------*/
+
+/* Maior fator (>= 1, ate dLimite, com 0,1%) com que o conjunto escalado por
+ * prvEscalar() continua cumprindo os prazos.  Wcet maiores so aumentam os
+ * tempos de resposta, entao a busca binaria vale. */
+static double prvMaiorFator(int iTarefa, int iTodas, double dLimite)
+{
+    double dMenor = 1;
+    double dMaior = 1;
+    double dMeio;
+
+    do {
+        dMaior *= 2;
+        if (dMaior >= dLimite) {
+            dMaior = dLimite;
+            prvEscalar(&xBase, &xTrabalho, iTarefa, iTodas, dMaior);
+            if (prvAnalisar(&xTrabalho, NULL))
+                return dLimite;
+            break;
+        }
+        prvEscalar(&xBase, &xTrabalho, iTarefa, iTodas, dMaior);
+    } while (prvAnalisar(&xTrabalho, NULL));
+
+    while (dMaior - dMenor > dMenor * 1e-3) {
+        dMeio = (dMenor + dMaior) / 2;
+        prvEscalar(&xBase, &xTrabalho, iTarefa, iTodas, dMeio);
+        if (prvAnalisar(&xTrabalho, NULL))
+            dMenor = dMeio;
+        else
+            dMaior = dMeio;
+    }
+
+    return dMenor;
+}
+/*-----------------------------------------------------------*/
+
+static void prvImprimirTempo(double dTempo)
+{
+    if (dTempo == HUGE_VAL)
+        printf("%10s", "> prazo");
+    else
+        printf("%10.2f", dTempo);
+}
+/*-----------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    const char* pcTabela = argc > 1 ? argv[1] : rtaTABELA_PADRAO;
+    ResultadoAperiodica_t xAperiodicas[rtaMAX_APERIODICAS];
+    double dUtilizacao = 0;
+    double dHiperbolico = 1;
+    double dLiuLayland;
+    double dFator;
+    int iZonas;
+    int iCumpre;
+    int i;
+
+    if (!prvLerTabela(pcTabela, &xBase))
+        return 2;
+
+    /* Utilizacao e limites do rate monotonic */
+    for (i = 0; i < xBase.iNumTarefas; i++) {
+        double dU = xBase.xTarefas[i].dWcet / xBase.xTarefas[i].dPeriodo;
+        dUtilizacao += dU;
+        dHiperbolico *= dU + 1;
+    }
+    dLiuLayland = xBase.iNumTarefas * (pow(2.0, 1.0 / xBase.iNumTarefas) - 1);
+
+    printf("Tabela: %s (%d tarefas periodicas, %d aperiodicas)\n\n", pcTabela, xBase.iNumTarefas, xBase.iNumAperiodicas);
+    printf("Utilizacao total             %.4f\n", dUtilizacao);
+    printf("Limite de Liu & Layland      %.4f  %s\n", dLiuLayland,
+           dUtilizacao <= dLiuLayland ? "cumpre" : "inconclusivo");
+    printf("Limite hiperbolico (<= 2)    %.4f  %s\n", dHiperbolico,
+           dHiperbolico <= 2 ? "cumpre" : "inconclusivo");
+    printf("Os limites supoem prioridades rate monotonic distintas e sem bloqueio;\n"
+           "a analise de tempo de resposta abaixo e exata para esta tabela.\n\n");
+
+    iCumpre = prvAnalisar(&xBase, xAperiodicas);
+
+    printf("%-16s %4s %8s %8s %8s %8s %8s %10s  %s\n",
+           "tarefa", "prio", "T", "D", "C", "J", "B", "R", "");
+    for (i = 0; i < xBase.iNumTarefas; i++) {
+        const Tarefa_t* pxTarefa = &xBase.xTarefas[i];
+
+        printf("%-16s %4d %8.2f %8.2f %8.2f %8.2f %8.2f ", pxTarefa->cNome, pxTarefa->iPrioridade,
+               pxTarefa->dPeriodo, pxTarefa->dPrazo, pxTarefa->dWcet, pxTarefa->dJitter, xResultados[i].dBloqueio);
+        prvImprimirTempo(xResultados[i].dResposta);
+        printf("  %s\n", xResultados[i].iCumpre ? "ok" : "PERDE O PRAZO");
+    }
+
+    if (xBase.iServidor >= 0 && xBase.iNumAperiodicas > 0) {
+        printf("\nAperiodicas no servidor %s (%s)\n", xBase.xTarefas[xBase.iServidor].cNome,
+               xBase.iDeferrable ? "deferrable" : "esporadico");
+        printf("%-16s %8s %8s %10s %10s  %s\n", "tarefa", "C", "D", "R sozinha", "R fila", "");
+        for (i = 0; i < xBase.iNumAperiodicas; i++) {
+            const Aperiodica_t* pxAperiodica = &xBase.xAperiodicas[i];
+
+            printf("%-16s %8.2f %8.2f ", pxAperiodica->cNome, pxAperiodica->dWcet, pxAperiodica->dPrazo);
+            prvImprimirTempo(xAperiodicas[i].dSozinha);
+            printf(" ");
+            prvImprimirTempo(xAperiodicas[i].dFilaCheia);
+            printf("  %s\n",
+                   xAperiodicas[i].dSozinha > pxAperiodica->dPrazo ? "PERDE O PRAZO" :
+                   xAperiodicas[i].dFilaCheia > pxAperiodica->dPrazo ? "PERDE O PRAZO com a fila cheia" : "ok");
+        }
+    }
+
+    printf("\nConjunto %s\n", iCumpre ? "ESCALONAVEL" : "NAO ESCALONAVEL");
+    if (!iCumpre)
+        return 1;
+
+    /* Folga.  Acima de rtaMAX_ZONAS o gateway nao vai, entao a busca para ai. */
+    dFator = prvMaiorFator(-1, 0, (double)rtaMAX_ZONAS / xBase.iZonas);
+    iZonas = (int)(xBase.iZonas * dFator + 1e-9);
+
+    printf("\nFolga\n");
+    printf("Todos os wcet podem crescer ate %.2fx\n", prvMaiorFator(-1, 1, 1e6));
+    printf("Zonas (wcet de varredura medidos com %d): ate %d%s\n", xBase.iZonas, iZonas,
+           iZonas >= rtaMAX_ZONAS ? ", o maximo do gateway" : "");
+    for (i = 0; i < xBase.iNumTarefas; i++) {
+        if (xBase.xTarefas[i].eTipo == TAREFA_VARREDURA)
+            printf("Wcet de %-16s ate %.2fx\n", xBase.xTarefas[i].cNome, prvMaiorFator(i, 0, 1e6));
+    }
+
+    return 0;
+}
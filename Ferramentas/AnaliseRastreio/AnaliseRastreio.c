@@ -0,0 +1,813 @@
+/*
+ * Analise do rastreio do gateway, executada no host.
+ *
+ * Le o Trace.dump gravado pela tecla de rastreio (RecorderDataType do
+ * TraceRecorder em modo snapshot, ver DespejoRastreio.c) e calcula:
+ * - a fatia de CPU de cada tarefa e de cada ISR rastreada;
+ * - as trocas de contexto: entradas de uma tarefa vindas de outra tarefa;
+ * - a distribuicao do tempo de resposta de cada tarefa, da liberacao (evento
+ *   de pronta) ate a ultima saida de execucao antes da instancia seguinte.  O
+ *   recorder marca o inicio de instancia (TS_TASK_BEGIN) pelas regras
+ *   implicitas de fim de instancia (bloqueio em delay, fila, semaforo);
+ * - o jitter de liberacao: desvio de cada intervalo entre liberacoes em
+ *   relacao ao intervalo mediano da tarefa;
+ * - o tempo bloqueado em cada mutex (os registrados com vQueueAddToRegistry()
+ *   aparecem pelo nome);
+ * - as alocacoes e liberacoes do heap (TRC_CFG_INCLUDE_MEMMANG_EVENTS), por
+ *   tarefa.
+ *
+ * O anel de eventos e lido do mais antigo para o mais novo.  Os tempos sao
+ * relativos ao primeiro evento com carimbo de tempo, na base de tempo do
+ * recorder (campo frequency).  Os codigos de evento e o formato de cada
+ * registro de 4 bytes seguem trcSnapshotRecorder.h e trcKernelPort.h da
+ * versao 4 do TraceRecorder; handles de objeto reutilizados depois de um
+ * delete somam na mesma linha.
+ *
+ * Uso: AnaliseRastreio [Trace.dump]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define arARQUIVO_PADRAO        "Trace.dump"
+#define arMAX_OBJETOS           256         /* Handles de 8 bits */
+#define arMAX_NOME              32
+#define arSEM_TEMPO             UINT64_MAX
+#define arSEM_OBJETO            -1
+
+/* Classes de objeto do port do FreeRTOS */
+#define arCLASSE_MUTEX          2
+#define arCLASSE_TAREFA         3
+#define arCLASSE_ISR            4
+
+/* Codigos de evento do modo snapshot */
+#define arEVT_NULO              0x00
+#define arEVT_XPS               0x01
+#define arEVT_PRONTA            0x02
+#define arEVT_ISR_INICIO        0x04
+#define arEVT_ISR_RETORNO       0x05
+#define arEVT_TAREFA_INICIO     0x06
+#define arEVT_TAREFA_RETORNO    0x07
+#define arEVT_RECEBE_OK         0x28        /* + classe do objeto */
+#define arEVT_RECEBE_FALHA      0x50
+#define arEVT_RECEBE_BLOQUEIO   0x68
+#define arEVT_MALLOC            0x94
+#define arEVT_FREE              0x96
+#define arEVT_USUARIO           0x98
+#define arEVT_USUARIO_ULTIMO    0xA7
+#define arEVT_XTS8              0xA8
+#define arEVT_XTS16             0xA9
+#define arEVT_MALLOC_FALHA      0xEB
+
+static const uint8_t ucMarcadorInicio[12] = { 0x01, 0x02, 0x03, 0x04, 0x71, 0x72, 0x73, 0x74, 0xF1, 0xF2, 0xF3, 0xF4 };
+
+typedef enum {
+    DTS_NENHUM = 0,
+    DTS8_BYTE1,
+    DTS8_BYTE2,
+    DTS8_BYTE3,
+    DTS16
+} FormatoDts_t;
+
+typedef struct {
+    uint64_t* pullValores;
+    size_t xNum;
+    size_t xCapacidade;
+} Amostras_t;
+
+typedef struct {
+    char cNome[arMAX_NOME];
+    int iVista;
+    uint64_t ullExecucao;
+    uint32_t ulTrocas;
+    uint32_t ulRetornos;            /* Voltas de preempcao ou de ISR */
+
+    /* Instancia corrente */
+    uint64_t ullLiberacao;          /* Pronta desde a ultima entrada */
+    uint64_t ullInicioInstancia;
+    uint64_t ullUltimaLiberacao;
+    uint64_t ullFimExecucao;
+    int iEmInstancia;
+    Amostras_t xRespostas;
+    Amostras_t xIntervalos;
+
+    /* Mutex */
+    int iMutexEsperado;
+    uint64_t ullInicioEspera;
+
+    /* Heap */
+    uint32_t ulMallocs;
+    uint32_t ulFrees;
+    uint32_t ulMallocsFalhos;
+    uint64_t ullBytesAlocados;
+    uint64_t ullBytesLiberados;
+} Tarefa_t;
+
+typedef struct {
+    char cNome[arMAX_NOME];
+    int iVista;
+    uint64_t ullExecucao;
+    uint32_t ulEntradas;
+} Isr_t;
+
+typedef struct {
+    char cNome[arMAX_NOME];
+    int iVisto;
+    uint32_t ulTomadas;
+    uint32_t ulBloqueios;
+    uint32_t ulFalhas;
+    uint64_t ullEspera;
+    uint64_t ullMaiorEspera;
+} Mutex_t;
+
+typedef struct {
+    uint32_t ulVersao;
+    uint32_t ulEventos;
+    uint32_t ulMaxEventos;
+    uint32_t ulProximo;
+    uint32_t ulCheio;
+    uint32_t ulFrequencia;
+    uint32_t ulUsoHeap;
+    uint32_t ulErroInterno;
+    char cInfo[81];
+
+    /* Tabela de objetos */
+    uint32_t ulNumClasses;
+    const uint8_t* pucObjetosPorClasse;
+    const uint8_t* pucTamanhoNome;
+    const uint8_t* pucTamanhoPropriedades;
+    const uint8_t* pucInicioClasse;     /* uint16_t */
+    const uint8_t* pucObjetos;
+    uint32_t ulTamanhoObjetos;
+
+    const uint8_t* pucEventos;
+} Rastreio_t;
+
+static Rastreio_t xRastreio;
+static Tarefa_t xTarefas[arMAX_OBJETOS];
+static Isr_t xIsrs[arMAX_OBJETOS];
+static Mutex_t xMutexes[arMAX_OBJETOS];
+
+/* Estado da varredura */
+static int iClasseCorrente = arSEM_OBJETO;
+static int iObjetoCorrente = arSEM_OBJETO;
+static int iTarefaCorrente = arSEM_OBJETO;
+static uint64_t ullDesde;
+static uint64_t ullPrimeiro = arSEM_TEMPO;
+static int64_t llHeapCorrente;
+static int64_t llHeapMaximo;
+static int64_t llHeapMinimo;
+
+/*-----------------------------------------------------------*/
+
+static uint16_t prvLer16(const uint8_t* puc)
+{
+    return (uint16_t)(puc[0] | (puc[1] << 8));
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvLer32(const uint8_t* puc)
+{
+    return (uint32_t)puc[0] | ((uint32_t)puc[1] << 8) | ((uint32_t)puc[2] << 16) | ((uint32_t)puc[3] << 24);
+}
+/*-----------------------------------------------------------*/
+
+static void prvAdicionar(Amostras_t* pxAmostras, uint64_t ullValor)
+{
+    if (pxAmostras->xNum == pxAmostras->xCapacidade) {
+        size_t xNova = pxAmostras->xCapacidade ? pxAmostras->xCapacidade * 2 : 256;
+        uint64_t* pullNovos = realloc(pxAmostras->pullValores, xNova * sizeof(uint64_t));
+
+        if (pullNovos == NULL) {
+            fprintf(stderr, "Sem memoria\n");
+            exit(2);
+        }
+        pxAmostras->pullValores = pullNovos;
+        pxAmostras->xCapacidade = xNova;
+    }
+    pxAmostras->pullValores[pxAmostras->xNum++] = ullValor;
+}
+/*-----------------------------------------------------------*/
+
+static int prvComparar(const void* pvA, const void* pvB)
+{
+    uint64_t ullA = *(const uint64_t*)pvA;
+    uint64_t ullB = *(const uint64_t*)pvB;
+
+    return ullA < ullB ? -1 : ullA > ullB;
+}
+/*-----------------------------------------------------------*/
+
+/* Amostras ordenadas */
+static uint64_t prvPercentil(const Amostras_t* pxAmostras, double dFracao)
+{
+    return pxAmostras->pullValores[(size_t)(dFracao * (double)(pxAmostras->xNum - 1) + 0.5)];
+}
+/*-----------------------------------------------------------*/
+
+static double prvMs(uint64_t ullTempo)
+{
+    return (double)ullTempo * 1000.0 / (double)xRastreio.ulFrequencia;
+}
+/*-----------------------------------------------------------*/
+
+/* Procura o marcador de 32 bits alinhado a partir de xInicio. */
+static long prvProcurarMarcador(const uint8_t* pucDados, size_t xTamanho, size_t xInicio, uint32_t ulMarcador)
+{
+    size_t x;
+
+    for (x = xInicio; x + 4 <= xTamanho; x += 4) {
+        if (prvLer32(pucDados + x) == ulMarcador)
+            return (long)x;
+    }
+
+    return -1;
+}
+/*-----------------------------------------------------------*/
+
+static int prvLerCabecalho(const uint8_t* pucArquivo, size_t xTamanho)
+{
+    const uint8_t* pucDados = NULL;
+    uint32_t ulArredondado;
+    size_t xOffset;
+    long lMarcador;
+    size_t x;
+
+    /* O arquivo gravado pelo gateway comeca no RecorderDataType, mas um
+     * despejo de memoria qualquer tambem serve. */
+    for (x = 0; x + sizeof(ucMarcadorInicio) <= xTamanho; x += 4) {
+        if (memcmp(pucArquivo + x, ucMarcadorInicio, sizeof(ucMarcadorInicio)) == 0) {
+            pucDados = pucArquivo + x;
+            xTamanho -= x;
+            break;
+        }
+    }
+    if (pucDados == NULL || xTamanho < 256) {
+        fprintf(stderr, "Marcadores do recorder nao encontrados: nao e um despejo em modo snapshot\n");
+        return 0;
+    }
+
+    xRastreio.ulVersao = prvLer16(pucDados + 12);
+    xRastreio.ulEventos = prvLer32(pucDados + 20);
+    xRastreio.ulMaxEventos = prvLer32(pucDados + 24);
+    xRastreio.ulProximo = prvLer32(pucDados + 28);
+    xRastreio.ulCheio = prvLer32(pucDados + 32);
+    xRastreio.ulFrequencia = prvLer32(pucDados + 36);
+
+    /* debugMarker0 fecha os campos de cabecalho, que variam um pouco entre
+     * versoes; a tabela de objetos vem logo depois de isUsing16bitHandles. */
+    lMarcador = prvProcurarMarcador(pucDados, 256, 56, 0xF0F0F0F0UL);
+    if (lMarcador < 0) {
+        fprintf(stderr, "debugMarker0 nao encontrado\n");
+        return 0;
+    }
+    xRastreio.ulUsoHeap = prvLer32(pucDados + lMarcador - 4);
+    if (prvLer32(pucDados + lMarcador + 4) != 0) {
+        fprintf(stderr, "Handles de 16 bits (TRC_CFG_USE_16BIT_OBJECT_HANDLES) nao sao suportados\n");
+        return 0;
+    }
+
+    xOffset = (size_t)lMarcador + 8;
+    xRastreio.ulNumClasses = prvLer32(pucDados + xOffset);
+    xRastreio.ulTamanhoObjetos = prvLer32(pucDados + xOffset + 4);
+    xOffset += 8;
+    if (xRastreio.ulNumClasses <= arCLASSE_ISR || xRastreio.ulNumClasses > 64) {
+        fprintf(stderr, "Tabela de objetos invalida (%u classes)\n", (unsigned)xRastreio.ulNumClasses);
+        return 0;
+    }
+
+    ulArredondado = 4 * ((xRastreio.ulNumClasses + 3) / 4);
+    xRastreio.pucObjetosPorClasse = pucDados + xOffset;
+    xOffset += ulArredondado;
+    xRastreio.pucTamanhoNome = pucDados + xOffset;
+    xOffset += ulArredondado;
+    xRastreio.pucTamanhoPropriedades = pucDados + xOffset;
+    xOffset += ulArredondado;
+    xRastreio.pucInicioClasse = pucDados + xOffset;
+    xOffset += 2 * (2 * ((xRastreio.ulNumClasses + 1) / 2));
+    xRastreio.pucObjetos = pucDados + xOffset;
+    xOffset += 4 * ((xRastreio.ulTamanhoObjetos + 3) / 4);
+
+    if (xOffset + 4 > xTamanho || prvLer32(pucDados + xOffset) != 0xF1F1F1F1UL) {
+        fprintf(stderr, "debugMarker1 fora do lugar: tabela de objetos mal lida\n");
+        return 0;
+    }
+
+    /* Depois da tabela de simbolos: debugMarker2, systemInfo[80],
+     * debugMarker3 e o anel de eventos. */
+    lMarcador = (long)xOffset;
+    do {
+        lMarcador = prvProcurarMarcador(pucDados, xTamanho, (size_t)lMarcador + 4, 0xF2F2F2F2UL);
+    } while (lMarcador >= 0 && ((size_t)lMarcador + 88 > xTamanho || prvLer32(pucDados + lMarcador + 84) != 0xF3F3F3F3UL));
+    if (lMarcador < 0) {
+        fprintf(stderr, "debugMarker2/3 nao encontrados\n");
+        return 0;
+    }
+
+    xRastreio.ulErroInterno = prvLer32(pucDados + lMarcador - 4);
+    memcpy(xRastreio.cInfo, pucDados + lMarcador + 4, 80);
+    xRastreio.cInfo[80] = '\0';
+
+    xOffset = (size_t)lMarcador + 88;
+    if (xRastreio.ulMaxEventos == 0 || xOffset + (size_t)xRastreio.ulMaxEventos * 4 > xTamanho ||
+        xRastreio.ulProximo >= xRastreio.ulMaxEventos) {
+        fprintf(stderr, "Anel de eventos truncado ou invalido\n");
+        return 0;
+    }
+    xRastreio.pucEventos = pucDados + xOffset;
+
+    if (xRastreio.ulFrequencia == 0) {
+        fprintf(stderr, "Frequencia da base de tempo zerada: o recorder foi iniciado?\n");
+        return 0;
+    }
+
+    return 1;
+}
+/*-----------------------------------------------------------*/
+
+static void prvNomeObjeto(uint32_t ulClasse, uint32_t ulHandle, char* pcNome)
+{
+    uint32_t ulTamanhoNome;
+    uint32_t ulIndice;
+    uint32_t i;
+
+    pcNome[0] = '\0';
+    if (ulClasse >= xRastreio.ulNumClasses || ulHandle == 0 || ulHandle > xRastreio.pucObjetosPorClasse[ulClasse])
+        return;
+
+    ulTamanhoNome = xRastreio.pucTamanhoNome[ulClasse];
+    ulIndice = prvLer16(xRastreio.pucInicioClasse + 2 * ulClasse) +
+               (ulHandle - 1) * xRastreio.pucTamanhoPropriedades[ulClasse];
+    if (ulIndice + ulTamanhoNome > xRastreio.ulTamanhoObjetos)
+        return;
+
+    for (i = 0; i < ulTamanhoNome && i < arMAX_NOME - 1; i++) {
+        char c = (char)xRastreio.pucObjetos[ulIndice + i];
+        if (c == '\0')
+            break;
+        pcNome[i] = (c >= ' ' && c <= '~') ? c : '?';
+    }
+    pcNome[i] = '\0';
+}
+/*-----------------------------------------------------------*/
+
+static FormatoDts_t prvFormato(uint8_t ucTipo)
+{
+    if (ucTipo == arEVT_PRONTA || (ucTipo >= arEVT_ISR_INICIO && ucTipo <= arEVT_TAREFA_RETORNO))
+        return DTS16;                       /* TSEvent, TREvent */
+    if (ucTipo == 0xAC || ucTipo == 0xAD)
+        return DTS16;                       /* LOW_POWER_BEGIN/END */
+    if (ucTipo < 0x18)
+        return DTS_NENHUM;                  /* Nulo, XPS, fechamento de objeto */
+    if (ucTipo < 0x88)
+        return DTS8_BYTE2;                  /* KernelCall: criar, enviar, receber, bloquear, peek, delete */
+    if (ucTipo <= 0x89)
+        return DTS8_BYTE1;                  /* TASK_DELAY_UNTIL, TASK_DELAY: KernelCallWithParam16 */
+    if (ucTipo <= 0x8C)
+        return DTS8_BYTE2;                  /* Suspend, resume */
+    if (ucTipo <= 0x93)
+        return DTS8_BYTE3;                  /* Prioridade, pend func call: KernelCallWithParamAndHandle */
+    if (ucTipo == arEVT_MALLOC || ucTipo == arEVT_FREE || ucTipo == arEVT_MALLOC_FALHA)
+        return DTS8_BYTE1;                  /* MemEventSize */
+    if (ucTipo == arEVT_MALLOC + 1 || ucTipo == arEVT_FREE + 1 || ucTipo == arEVT_MALLOC_FALHA + 1)
+        return DTS_NENHUM;                  /* MemEventAddr */
+    if (ucTipo <= arEVT_USUARIO_ULTIMO)
+        return DTS8_BYTE1;                  /* UserEvent */
+    if (ucTipo <= 0xAF)
+        return DTS_NENHUM;                  /* XTS, XID, reservados */
+    if ((ucTipo >= 0xC4 && ucTipo <= 0xCA) || (ucTipo >= 0xCC && ucTipo <= 0xD1) || (ucTipo >= 0xD3 && ucTipo <= 0xD8))
+        return DTS8_BYTE3;                  /* Grupos de eventos, fim de instancia, notify take/wait */
+    return DTS8_BYTE2;
+}
+/*-----------------------------------------------------------*/
+
+/* Soma o trecho desde o ultimo evento de troca ao objeto em execucao. */
+static void prvContabilizar(uint64_t ullAgora)
+{
+    if (iClasseCorrente == arCLASSE_TAREFA) {
+        xTarefas[iObjetoCorrente].ullExecucao += ullAgora - ullDesde;
+        xTarefas[iObjetoCorrente].ullFimExecucao = ullAgora;
+    }
+    else if (iClasseCorrente == arCLASSE_ISR) {
+        xIsrs[iObjetoCorrente].ullExecucao += ullAgora - ullDesde;
+    }
+    ullDesde = ullAgora;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEntradaTarefa(uint8_t ucHandle, int iInicioInstancia, uint64_t ullAgora)
+{
+    Tarefa_t* pxTarefa = &xTarefas[ucHandle];
+    uint64_t ullLiberacao;
+
+    if (ullPrimeiro == arSEM_TEMPO)
+        ullPrimeiro = ullAgora;
+    else
+        prvContabilizar(ullAgora);
+
+    pxTarefa->iVista = 1;
+    if (iTarefaCorrente != ucHandle)
+        pxTarefa->ulTrocas++;
+    if (!iInicioInstancia)
+        pxTarefa->ulRetornos++;
+
+    if (iInicioInstancia) {
+        if (pxTarefa->iEmInstancia)
+            prvAdicionar(&pxTarefa->xRespostas, pxTarefa->ullFimExecucao - pxTarefa->ullInicioInstancia);
+
+        ullLiberacao = pxTarefa->ullLiberacao != arSEM_TEMPO ? pxTarefa->ullLiberacao : ullAgora;
+        if (pxTarefa->ullUltimaLiberacao != arSEM_TEMPO)
+            prvAdicionar(&pxTarefa->xIntervalos, ullLiberacao - pxTarefa->ullUltimaLiberacao);
+
+        pxTarefa->ullUltimaLiberacao = ullLiberacao;
+        pxTarefa->ullInicioInstancia = ullLiberacao;
+        pxTarefa->iEmInstancia = 1;
+    }
+
+    /* Uma pronta registrada antes de um retorno nao libera instancia nova. */
+    pxTarefa->ullLiberacao = arSEM_TEMPO;
+    iTarefaCorrente = ucHandle;
+    iClasseCorrente = arCLASSE_TAREFA;
+    iObjetoCorrente = ucHandle;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEntradaIsr(uint8_t ucHandle, uint64_t ullAgora)
+{
+    if (ullPrimeiro == arSEM_TEMPO)
+        ullPrimeiro = ullAgora;
+    else
+        prvContabilizar(ullAgora);
+
+    xIsrs[ucHandle].iVista = 1;
+    xIsrs[ucHandle].ulEntradas++;
+    iClasseCorrente = arCLASSE_ISR;
+    iObjetoCorrente = ucHandle;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventoMutex(uint8_t ucTipo, uint8_t ucMutex, uint64_t ullAgora)
+{
+    Mutex_t* pxMutex = &xMutexes[ucMutex];
+    Tarefa_t* pxTarefa;
+    uint64_t ullEspera;
+
+    pxMutex->iVisto = 1;
+    if (iTarefaCorrente == arSEM_OBJETO)
+        return;
+    pxTarefa = &xTarefas[iTarefaCorrente];
+
+    if (ucTipo == arEVT_RECEBE_BLOQUEIO + arCLASSE_MUTEX) {
+        pxMutex->ulBloqueios++;
+        pxTarefa->iMutexEsperado = ucMutex;
+        pxTarefa->ullInicioEspera = ullAgora;
+        return;
+    }
+
+    if (ucTipo == arEVT_RECEBE_OK + arCLASSE_MUTEX)
+        pxMutex->ulTomadas++;
+    else
+        pxMutex->ulFalhas++;
+
+    if (pxTarefa->iMutexEsperado == ucMutex) {
+        ullEspera = ullAgora - pxTarefa->ullInicioEspera;
+        pxMutex->ullEspera += ullEspera;
+        if (ullEspera > pxMutex->ullMaiorEspera)
+            pxMutex->ullMaiorEspera = ullEspera;
+        pxTarefa->iMutexEsperado = arSEM_OBJETO;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventoHeap(uint8_t ucTipo, uint32_t ulTamanho)
+{
+    Tarefa_t* pxTarefa = iTarefaCorrente != arSEM_OBJETO ? &xTarefas[iTarefaCorrente] : NULL;
+
+    if (ucTipo == arEVT_MALLOC_FALHA) {
+        if (pxTarefa != NULL)
+            pxTarefa->ulMallocsFalhos++;
+        return;
+    }
+
+    if (ucTipo == arEVT_MALLOC) {
+        llHeapCorrente += ulTamanho;
+        if (pxTarefa != NULL) {
+            pxTarefa->ulMallocs++;
+            pxTarefa->ullBytesAlocados += ulTamanho;
+        }
+    }
+    else {
+        llHeapCorrente -= ulTamanho;
+        if (pxTarefa != NULL) {
+            pxTarefa->ulFrees++;
+            pxTarefa->ullBytesLiberados += ulTamanho;
+        }
+    }
+
+    if (llHeapCorrente > llHeapMaximo)
+        llHeapMaximo = llHeapCorrente;
+    if (llHeapCorrente < llHeapMinimo)
+        llHeapMinimo = llHeapCorrente;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvVarrer(uint32_t* pulProcessados)
+{
+    uint32_t ulTotal = xRastreio.ulCheio ? xRastreio.ulMaxEventos : xRastreio.ulProximo;
+    uint32_t ulPrimeiro = xRastreio.ulCheio ? xRastreio.ulProximo : 0;
+    uint64_t ullAgora = 0;
+    uint64_t ullXts = 0;
+    uint32_t ulXps = 0;
+    uint32_t ulDts;
+    uint32_t i;
+    int iXts = 0;
+
+    for (i = 0; i < ulTotal; i++) {
+        const uint8_t* pucEvento = xRastreio.pucEventos + 4 * ((ulPrimeiro + i) % xRastreio.ulMaxEventos);
+        uint8_t ucTipo = pucEvento[0];
+
+        /* Extensoes do proximo evento */
+        if (ucTipo == arEVT_XTS8) {
+            ullXts = ((uint64_t)pucEvento[1] << 24) | ((uint64_t)prvLer16(pucEvento + 2) << 8);
+            iXts = 1;
+            continue;
+        }
+        if (ucTipo == arEVT_XTS16) {
+            ullXts = ((uint64_t)pucEvento[1] << 32) | ((uint64_t)prvLer16(pucEvento + 2) << 16);
+            iXts = 1;
+            continue;
+        }
+        if (ucTipo == arEVT_XPS) {
+            ulXps = ((uint32_t)prvLer16(pucEvento + 2) << 16) | ((uint32_t)pucEvento[1] << 8);
+            continue;
+        }
+
+        switch (prvFormato(ucTipo)) {
+        case DTS16:
+            ulDts = prvLer16(pucEvento + 2);
+            break;
+        case DTS8_BYTE1:
+            ulDts = pucEvento[1];
+            break;
+        case DTS8_BYTE2:
+            ulDts = pucEvento[2];
+            break;
+        case DTS8_BYTE3:
+            ulDts = pucEvento[3];
+            break;
+        default:
+            continue;
+        }
+
+        ullAgora += iXts ? (ullXts | ulDts) : ulDts;
+        iXts = 0;
+        (*pulProcessados)++;
+
+        switch (ucTipo) {
+        case arEVT_TAREFA_INICIO:
+        case arEVT_TAREFA_RETORNO:
+            prvEntradaTarefa(pucEvento[1], ucTipo == arEVT_TAREFA_INICIO, ullAgora);
+            break;
+        case arEVT_ISR_INICIO:
+        case arEVT_ISR_RETORNO:
+            prvEntradaIsr(pucEvento[1], ullAgora);
+            break;
+        case arEVT_PRONTA:
+            if (pucEvento[1] != iTarefaCorrente || iClasseCorrente != arCLASSE_TAREFA) {
+                if (xTarefas[pucEvento[1]].ullLiberacao == arSEM_TEMPO)
+                    xTarefas[pucEvento[1]].ullLiberacao = ullAgora;
+            }
+            break;
+        case arEVT_RECEBE_OK + arCLASSE_MUTEX:
+        case arEVT_RECEBE_FALHA + arCLASSE_MUTEX:
+        case arEVT_RECEBE_BLOQUEIO + arCLASSE_MUTEX:
+            prvEventoMutex(ucTipo, pucEvento[1], ullAgora);
+            break;
+        case arEVT_MALLOC:
+        case arEVT_FREE:
+        case arEVT_MALLOC_FALHA:
+            prvEventoHeap(ucTipo, ulXps | prvLer16(pucEvento + 2));
+            break;
+        default:
+            /* Argumentos do evento de usuario ocupam os registros seguintes */
+            if (ucTipo >= arEVT_USUARIO && ucTipo <= arEVT_USUARIO_ULTIMO)
+                i += ucTipo - arEVT_USUARIO;
+            break;
+        }
+        ulXps = 0;
+    }
+
+    if (ullPrimeiro != arSEM_TEMPO)
+        prvContabilizar(ullAgora);
+
+    return ullPrimeiro != arSEM_TEMPO ? ullAgora - ullPrimeiro : 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvImprimirTarefas(uint64_t ullDuracao)
+{
+    Amostras_t xDesvios = { NULL, 0, 0 };
+    int i;
+
+    printf("%-20s %6s %7s %7s %6s %9s %9s %9s %9s %9s %9s %9s\n", "tarefa", "%CPU", "trocas", "retorn", "inst",
+           "R min", "R media", "R p95", "R p99", "R max", "J p95", "J max");
+
+    for (i = 0; i < arMAX_OBJETOS; i++) {
+        Tarefa_t* pxTarefa = &xTarefas[i];
+        uint64_t ullSoma = 0;
+        uint64_t ullMediana;
+        size_t x;
+
+        if (!pxTarefa->iVista)
+            continue;
+
+        prvNomeObjeto(arCLASSE_TAREFA, (uint32_t)i, pxTarefa->cNome);
+        if (pxTarefa->cNome[0] == '\0')
+            snprintf(pxTarefa->cNome, sizeof(pxTarefa->cNome), "tarefa #%d", i);
+
+        printf("%-20s %6.2f %7lu %7lu %6lu ", pxTarefa->cNome,
+               ullDuracao ? 100.0 * (double)pxTarefa->ullExecucao / (double)ullDuracao : 0.0,
+               (unsigned long)pxTarefa->ulTrocas, (unsigned long)pxTarefa->ulRetornos,
+               (unsigned long)pxTarefa->xRespostas.xNum);
+
+        if (pxTarefa->xRespostas.xNum > 0) {
+            qsort(pxTarefa->xRespostas.pullValores, pxTarefa->xRespostas.xNum, sizeof(uint64_t), prvComparar);
+            for (x = 0; x < pxTarefa->xRespostas.xNum; x++)
+                ullSoma += pxTarefa->xRespostas.pullValores[x];
+            printf("%9.3f %9.3f %9.3f %9.3f %9.3f ", prvMs(pxTarefa->xRespostas.pullValores[0]),
+                   prvMs(ullSoma) / (double)pxTarefa->xRespostas.xNum, prvMs(prvPercentil(&pxTarefa->xRespostas, 0.95)),
+                   prvMs(prvPercentil(&pxTarefa->xRespostas, 0.99)),
+                   prvMs(pxTarefa->xRespostas.pullValores[pxTarefa->xRespostas.xNum - 1]));
+        }
+        else {
+            printf("%9s %9s %9s %9s %9s ", "-", "-", "-", "-", "-");
+        }
+
+        if (pxTarefa->xIntervalos.xNum > 0) {
+            qsort(pxTarefa->xIntervalos.pullValores, pxTarefa->xIntervalos.xNum, sizeof(uint64_t), prvComparar);
+            ullMediana = prvPercentil(&pxTarefa->xIntervalos, 0.5);
+            xDesvios.xNum = 0;
+            for (x = 0; x < pxTarefa->xIntervalos.xNum; x++) {
+                uint64_t ullIntervalo = pxTarefa->xIntervalos.pullValores[x];
+                prvAdicionar(&xDesvios, ullIntervalo > ullMediana ? ullIntervalo - ullMediana : ullMediana - ullIntervalo);
+            }
+            qsort(xDesvios.pullValores, xDesvios.xNum, sizeof(uint64_t), prvComparar);
+            printf("%9.3f %9.3f\n", prvMs(prvPercentil(&xDesvios, 0.95)), prvMs(xDesvios.pullValores[xDesvios.xNum - 1]));
+        }
+        else {
+            printf("%9s %9s\n", "-", "-");
+        }
+    }
+
+    free(xDesvios.pullValores);
+}
+/*-----------------------------------------------------------*/
+
+static void prvImprimirIsrs(uint64_t ullDuracao)
+{
+    int iCabecalho = 0;
+    int i;
+
+    for (i = 0; i < arMAX_OBJETOS; i++) {
+        Isr_t* pxIsr = &xIsrs[i];
+
+        if (!pxIsr->iVista)
+            continue;
+        if (!iCabecalho) {
+            printf("\n%-20s %6s %9s\n", "ISR", "%CPU", "entradas");
+            iCabecalho = 1;
+        }
+
+        prvNomeObjeto(arCLASSE_ISR, (uint32_t)i, pxIsr->cNome);
+        if (pxIsr->cNome[0] == '\0')
+            snprintf(pxIsr->cNome, sizeof(pxIsr->cNome), "isr #%d", i);
+        printf("%-20s %6.2f %9lu\n", pxIsr->cNome,
+               ullDuracao ? 100.0 * (double)pxIsr->ullExecucao / (double)ullDuracao : 0.0,
+               (unsigned long)pxIsr->ulEntradas);
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvImprimirMutexes(void)
+{
+    int iCabecalho = 0;
+    int i;
+
+    for (i = 0; i < arMAX_OBJETOS; i++) {
+        Mutex_t* pxMutex = &xMutexes[i];
+
+        if (!pxMutex->iVisto)
+            continue;
+        if (!iCabecalho) {
+            printf("\n%-20s %8s %9s %7s %11s %9s %9s\n", "mutex", "tomadas", "bloqueios", "falhas",
+                   "espera ms", "media", "max");
+            iCabecalho = 1;
+        }
+
+        prvNomeObjeto(arCLASSE_MUTEX, (uint32_t)i, pxMutex->cNome);
+        if (pxMutex->cNome[0] == '\0')
+            snprintf(pxMutex->cNome, sizeof(pxMutex->cNome), "mutex #%d", i);
+        printf("%-20s %8lu %9lu %7lu %11.3f %9.3f %9.3f\n", pxMutex->cNome, (unsigned long)pxMutex->ulTomadas,
+               (unsigned long)pxMutex->ulBloqueios, (unsigned long)pxMutex->ulFalhas, prvMs(pxMutex->ullEspera),
+               pxMutex->ulBloqueios ? prvMs(pxMutex->ullEspera) / pxMutex->ulBloqueios : 0.0,
+               prvMs(pxMutex->ullMaiorEspera));
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvImprimirHeap(void)
+{
+    uint32_t ulMallocs = 0;
+    uint32_t ulFrees = 0;
+    uint32_t ulFalhos = 0;
+    int i;
+
+    for (i = 0; i < arMAX_OBJETOS; i++) {
+        ulMallocs += xTarefas[i].ulMallocs;
+        ulFrees += xTarefas[i].ulFrees;
+        ulFalhos += xTarefas[i].ulMallocsFalhos;
+    }
+
+    printf("\nHeap: %lu alocacoes, %lu liberacoes, %lu falhas; saldo no intervalo %+lld bytes, "
+           "variacao maxima %lld bytes; em uso no fim %lu bytes\n",
+           (unsigned long)ulMallocs, (unsigned long)ulFrees, (unsigned long)ulFalhos, (long long)llHeapCorrente,
+           (long long)(llHeapMaximo - llHeapMinimo), (unsigned long)xRastreio.ulUsoHeap);
+    if (ulMallocs + ulFrees + ulFalhos == 0)
+        return;
+
+    printf("%-20s %8s %11s %8s %11s %7s\n", "tarefa", "mallocs", "bytes", "frees", "bytes", "falhas");
+    for (i = 0; i < arMAX_OBJETOS; i++) {
+        Tarefa_t* pxTarefa = &xTarefas[i];
+
+        if (pxTarefa->ulMallocs + pxTarefa->ulFrees + pxTarefa->ulMallocsFalhos == 0)
+            continue;
+        if (pxTarefa->cNome[0] == '\0')
+            prvNomeObjeto(arCLASSE_TAREFA, (uint32_t)i, pxTarefa->cNome);
+        printf("%-20s %8lu %11llu %8lu %11llu %7lu\n", pxTarefa->cNome, (unsigned long)pxTarefa->ulMallocs,
+               (unsigned long long)pxTarefa->ullBytesAlocados, (unsigned long)pxTarefa->ulFrees,
+               (unsigned long long)pxTarefa->ullBytesLiberados, (unsigned long)pxTarefa->ulMallocsFalhos);
+    }
+}
+/*-----------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    const char* pcArquivo = argc > 1 ? argv[1] : arARQUIVO_PADRAO;
+    uint32_t ulProcessados = 0;
+    uint64_t ullDuracao;
+    uint8_t* pucArquivo;
+    clock_t xInicio;
+    FILE* pxArquivo;
+    long lTamanho;
+    int i;
+
+    xInicio = clock();
+
+    pxArquivo = fopen(pcArquivo, "rb");
+    if (pxArquivo == NULL) {
+        fprintf(stderr, "Nao foi possivel abrir %s\n", pcArquivo);
+        return 2;
+    }
+    fseek(pxArquivo, 0, SEEK_END);
+    lTamanho = ftell(pxArquivo);
+    fseek(pxArquivo, 0, SEEK_SET);
+    pucArquivo = malloc(lTamanho > 0 ? (size_t)lTamanho : 1);
+    if (pucArquivo == NULL || lTamanho <= 0 || fread(pucArquivo, 1, (size_t)lTamanho, pxArquivo) != (size_t)lTamanho) {
+        fprintf(stderr, "Falha lendo %s\n", pcArquivo);
+        fclose(pxArquivo);
+        return 2;
+    }
+    fclose(pxArquivo);
+
+    if (!prvLerCabecalho(pucArquivo, (size_t)lTamanho))
+        return 2;
+
+    for (i = 0; i < arMAX_OBJETOS; i++) {
+        xTarefas[i].ullLiberacao = arSEM_TEMPO;
+        xTarefas[i].ullUltimaLiberacao = arSEM_TEMPO;
+        xTarefas[i].iMutexEsperado = arSEM_OBJETO;
+    }
+
+    ullDuracao = prvVarrer(&ulProcessados);
+
+    printf("Rastreio: %s (versao %lu, %lu de %lu eventos%s, base de tempo %lu Hz)\n", pcArquivo,
+           (unsigned long)xRastreio.ulVersao, (unsigned long)xRastreio.ulEventos, (unsigned long)xRastreio.ulMaxEventos,
+           xRastreio.ulCheio ? ", anel cheio" : "", (unsigned long)xRastreio.ulFrequencia);
+    printf("Intervalo analisado: %.3f ms, %lu eventos com tempo\n", prvMs(ullDuracao), (unsigned long)ulProcessados);
+    if (xRastreio.ulErroInterno)
+        printf("ERRO INTERNO DO RECORDER: %s\n", xRastreio.cInfo);
+    printf("Tempos em ms.  R: liberacao ate o fim da instancia.  J: desvio do intervalo entre liberacoes\n"
+           "em relacao a mediana.  retorn: voltas a execucao apos preempcao ou ISR.\n\n");
+
+    prvImprimirTarefas(ullDuracao);
+    prvImprimirIsrs(ullDuracao);
+    prvImprimirMutexes();
+    prvImprimirHeap();
+
+    printf("\nAnalise em %.1f ms\n", 1000.0 * (double)(clock() - xInicio) / CLOCKS_PER_SEC);
+
+    return 0;
+}
@@ -46,7 +46,7 @@
 #define configUSE_DAEMON_TASK_STARTUP_HOOK		1
 #define configTICK_RATE_HZ						( 1000 ) /* In this non-real time simulated environment the tick frequency has to be at least a multiple of the Win32 tick frequency, and therefore very slow. */
 #define configMINIMAL_STACK_SIZE				( ( unsigned short ) 70 ) /* In this simulated case, the stack only has to hold one small structure as the real stack is part of the win32 thread. */
-#define configTOTAL_HEAP_SIZE					( ( size_t ) ( 49 * 1024 ) ) /* This demo tests heap_5 so places multiple blocks within this total heap size.  See mainREGION_1_SIZE to mainREGION_3_SIZE definitions in main.c. */
+#define configTOTAL_HEAP_SIZE					( ( size_t ) ( 49 * 1024 ) ) /* Arena do alocador por classes (AlocadorPools.c) e de cada heap do benchmark de heap. */
 #define configMAX_TASK_NAME_LEN					( 12 )
 #define configUSE_TRACE_FACILITY				1
 #define configUSE_16_BIT_TICKS					0
@@ -74,6 +74,43 @@
 
 #define configMAX_PRIORITIES					( 7 )
 
+/* Tempo virtual (TempoVirtual.h): em 1 o tick do Windows e ignorado e o
+contador de ticks salta para o proximo desbloqueio sempre que todas as tarefas
+estao bloqueadas, entao horas de gateway rodam em segundos, na mesma ordem de
+escalonamento.  O salto usa a supressao de ticks definida pela aplicacao. */
+#define configTEMPO_VIRTUAL					0
+
+/* Sono ocioso sem tick (SonoOcioso.h): em 1, com todas as tarefas bloqueadas
+a tarefa ociosa dorme ate o proximo desbloqueio em vez de receber um tick por
+milissegundo, e o contador de ticks e corrigido ao acordar.  Ignorado com
+configTEMPO_VIRTUAL em 1, que usa a mesma supressao de ticks. */
+#define configSONO_OCIOSO					1
+
+#if ( configTEMPO_VIRTUAL == 1 )
+	#undef configSONO_OCIOSO
+	#define configSONO_OCIOSO					0
+	#define configUSE_TICKLESS_IDLE				2
+	#define configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H	1
+	void TempoVirtualSaltar( uint32_t ulTicksOciosos );
+	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) TempoVirtualSaltar( xExpectedIdleTime )
+#elif ( configSONO_OCIOSO == 1 )
+	#define configUSE_TICKLESS_IDLE				2
+	void SonoOciosoDormir( uint32_t ulTicksOciosos );
+	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) SonoOciosoDormir( xExpectedIdleTime )
+#endif
+
+/* Contabilidade do heap por tarefa (HeapTarefas.h), pelos ganchos traceMALLOC()
+e traceFREE() redefinidos no fim deste arquivo. */
+#define configHEAP_POR_TAREFA				1
+
+/* Fonte do contador de run time (Run-time-stats-utils.c), sempre convertido
+para nanossegundos: o relogio do sistema (QueryPerformanceCounter() ou
+clock_gettime( CLOCK_MONOTONIC_RAW )) ou o TSC calibrado contra ele, que volta
+para o relogio se nao for invariante. */
+#define configRUN_TIME_RELOGIO				0
+#define configRUN_TIME_TSC					1
+#define configFONTE_RUN_TIME				configRUN_TIME_TSC
+
 /* Run time stats gathering configuration options. */
 #define configRUN_TIME_COUNTER_TYPE				uint64_t
 configRUN_TIME_COUNTER_TYPE ulGetRunTimeCounterValue( void ); /* Prototype of function that returns run time counter. */
@@ -126,4 +163,15 @@ extern void vAssertCalled( unsigned long ulLine, const char * const pcFileName )
 /* Include the FreeRTOS+Trace FreeRTOS trace macro definitions. */
 #include "trcRecorder.h"
 
+/* Os ganchos de memoria passam pela contabilidade por tarefa, que repassa ao
+recorder.  Em HeapTarefas.c eles continuam sendo os do recorder. */
+#if ( configHEAP_POR_TAREFA == 1 ) && !defined( heapTAREFAS_IMPLEMENTACAO )
+	void HeapTarefasAlocacao( void * pvEndereco, size_t xTamanho );
+	void HeapTarefasLiberacao( void * pvEndereco, size_t xTamanho );
+	#undef traceMALLOC
+	#define traceMALLOC( pvAddress, uiSize )	HeapTarefasAlocacao( ( pvAddress ), ( uiSize ) )
+	#undef traceFREE
+	#define traceFREE( pvAddress, uiSize )		HeapTarefasLiberacao( ( pvAddress ), ( uiSize ) )
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,84 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+/*
+ * Declaracoes compartilhadas entre main.c e os demais modulos do gateway.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "ServidorAperiodico.h"
+
+/* Modulos sensores do gateway, na ordem de prioridade em que sao criados. */
+typedef enum {
+    SENSOR_PRESENCA = 0,
+    SENSOR_TEMPERATURA,
+    SENSOR_TENSAO,
+    SENSOR_PARTICULAS,
+    SENSOR_GAS,
+    NUM_SENSORES
+} Sensor_t;
+
+/* Unidades do contador de run time (Run-time-stats-utils.c) por milissegundo:
+ * nanossegundos, qualquer que seja a fonte. */
+#define gatewayRUN_TIME_POR_MS     1000000ULL
+
+/* Fonte do contador escolhida por vConfigureTimerForRunTimeStats(). */
+typedef struct {
+    const char* pcNome;
+    uint64_t ullFrequenciaHz;       /* Da fonte, antes da conversao */
+    uint32_t ulCustoLeituraNs;      /* Media de ulGetRunTimeCounterValue() */
+} FonteRunTime_t;
+
+void RunTimeObterFonte(FonteRunTime_t* pxFonte);
+
+/* Contador de run time da tarefa que chama, atualizado ate agora.  Em
+ * freertos_tasks_c_additions.h, com acesso ao TCB corrente. */
+configRUN_TIME_COUNTER_TYPE RunTimeTarefaAtual(void);
+
+/* Latencias medidas com o contador de run time (ns): tempo gasto por
+ * varredura das zonas em cada modulo sensor e tempo entre uma mudanca e a
+ * decisao do controlador. */
+typedef struct {
+    uint32_t ulAmostras;
+    uint64_t ullLatenciaTotal;
+    uint64_t ullLatenciaMax;
+} EstatisticaLatencia_t;
+
+extern EstatisticaLatencia_t xEstatisticaAmostragem[NUM_SENSORES];
+extern EstatisticaLatencia_t xLatenciaDecisao;
+
+/* Servidor das tarefas aperiodicas T6 a T9, criado em main(). */
+extern ServidorAperiodico_t xServidorAtuadores;
+
+/* Vezes que o controlador acordou, com ou sem mudanca a tratar. */
+extern volatile uint32_t ulDespertaresControle;
+
+/* Zonas atendidas pelas tarefas do gateway.  As uxNumZonas primeiras zonas
+ * (ate estadoMAX_ZONAS) sao varridas a cada ativacao; o valor pode mudar com
+ * o gateway rodando e vale a partir da varredura seguinte. */
+extern volatile UBaseType_t uxNumZonas;
+
+/* Amostras por zona tiradas por cada modulo sensor e zonas avaliadas pelo
+ * controlador, desde o inicio.  Cada contador tem um unico escritor. */
+extern volatile uint32_t ulZonasAmostradas[NUM_SENSORES];
+extern volatile uint32_t ulZonasDecididas;
+
+void RegistrarLatencia(EstatisticaLatencia_t* pxEstatistica, configRUN_TIME_COUNTER_TYPE ulInicio);
+void RegistrarAmostra(Sensor_t xSensor, configRUN_TIME_COUNTER_TYPE ulInicio);
+
+/* Bits do grupo de eventos com que os modulos sensores acordam o controlador. */
+#define EVENTO_TEMPERATURA      ( 1UL << 0 )
+#define EVENTO_PRESENCA         ( 1UL << 1 )
+#define EVENTO_DEFEITO          ( 1UL << 2 )
+#define EVENTOS_CONTROLE        ( EVENTO_TEMPERATURA | EVENTO_PRESENCA | EVENTO_DEFEITO )
+#define EVENTO_POLITICA         ( 1UL << 3 )
+
+/* Troca a politica do controlador com o gateway rodando (pdTRUE: por eventos,
+ * pdFALSE: consulta a cada 200 ticks).  O controlador aplica a troca na
+ * ativacao seguinte e nesse momento zera xLatenciaDecisao e
+ * ulDespertaresControle, dos quais e o unico escritor. */
+void ControleSelecionarPolitica(BaseType_t xPorEventos);
+
+#endif /* GATEWAY_H */
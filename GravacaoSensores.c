@@ -0,0 +1,217 @@
+/*
+ * Gravacao e reproducao das leituras dos sensores.  Ver GravacaoSensores.h.
+ *
+ * Os geradores disputam o buffer corrente por um mutex; eles ja rodam na
+ * prioridade mais baixa das tarefas do gateway e seguram o mutex so durante a
+ * copia.  A tarefa de escrita troca os buffers dentro do mesmo mutex e grava o
+ * buffer cheio fora dele.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "GravacaoSensores.h"
+
+static uint8_t ucBuffers[2][gravacaoTAMANHO_BUFFER];
+static size_t xOcupado[2];
+
+const size_t xRamGravacao = sizeof(ucBuffers);
+static UBaseType_t uxBufferCorrente;    /* Recebe os registros */
+static BaseType_t xOutroPendente;       /* O outro buffer aguarda ou esta em escrita */
+
+static FILE* pxArquivoGravacao;
+static SemaphoreHandle_t xMutexGravacao;
+static StaticSemaphore_t xMutexGravacaoEstatico;
+static EstatisticaGravacao_t xEstatisticas;
+
+static TaskHandle_t xTarefaEscrita;
+static StaticTask_t xTCBEscrita;
+static StackType_t uxPilhaEscrita[gravacaoTAMANHO_PILHA];
+
+static FILE* pxArquivoReproducao;
+
+/*-----------------------------------------------------------*/
+
+static void prvEscritaTask(void* pvParameters)
+{
+    UBaseType_t uxPendente;
+
+    (void)pvParameters;
+
+    for (;;) {
+        /* Acorda quando um buffer enche ou a cada intervalo. */
+        ulTaskNotifyTake(pdTRUE, gravacaoINTERVALO_ESCRITA);
+
+        xSemaphoreTake(xMutexGravacao, portMAX_DELAY);
+        {
+            /* Intervalo vencido com buffer parcial: troca para grava-lo. */
+            if (!xOutroPendente && xOcupado[uxBufferCorrente] > 0) {
+                uxBufferCorrente = 1 - uxBufferCorrente;
+                xOutroPendente = pdTRUE;
+            }
+            uxPendente = 1 - uxBufferCorrente;
+        }
+        xSemaphoreGive(xMutexGravacao);
+
+        if (!xOutroPendente)
+            continue;
+
+        /* So esta tarefa mexe no buffer pendente ate liberar xOutroPendente. */
+        fwrite(ucBuffers[uxPendente], 1, xOcupado[uxPendente], pxArquivoGravacao);
+        fflush(pxArquivoGravacao);
+
+        xSemaphoreTake(xMutexGravacao, portMAX_DELAY);
+        {
+            xEstatisticas.ullBytes += xOcupado[uxPendente];
+            xOcupado[uxPendente] = 0;
+            xOutroPendente = pdFALSE;
+        }
+        xSemaphoreGive(xMutexGravacao);
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t GravacaoIniciar(const char* pcArquivo, UBaseType_t uxPrioridadeEscrita)
+{
+    CabecalhoArquivoGravacao_t xCabecalho = { gravacaoMAGICO, configTICK_RATE_HZ };
+
+    configASSERT(xTarefaEscrita == NULL);
+
+    pxArquivoGravacao = fopen(pcArquivo, "wb");
+    if (pxArquivoGravacao == NULL)
+        return pdFAIL;
+
+    fwrite(&xCabecalho, sizeof(xCabecalho), 1, pxArquivoGravacao);
+
+    memset(xOcupado, 0, sizeof(xOcupado));
+    memset(&xEstatisticas, 0, sizeof(xEstatisticas));
+    uxBufferCorrente = 0;
+    xOutroPendente = pdFALSE;
+
+    xMutexGravacao = xSemaphoreCreateMutexStatic(&xMutexGravacaoEstatico);
+    xTarefaEscrita = xTaskCreateStatic(prvEscritaTask, "Gravacao", gravacaoTAMANHO_PILHA, NULL,
+                                       uxPrioridadeEscrita, uxPilhaEscrita, &xTCBEscrita);
+
+    return xTarefaEscrita != NULL ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+void GravacaoRegistrar(Sensor_t eSensor, UBaseType_t uxZonas, const int32_t* plCanal0, const int32_t* plCanal1)
+{
+    CabecalhoRegistroGravacao_t xCabecalho;
+    UBaseType_t uxCanais = plCanal1 != NULL ? 2 : 1;
+    size_t xTamanho = sizeof(xCabecalho) + uxZonas * uxCanais * sizeof(int16_t);
+    BaseType_t xAvisar = pdFALSE;
+    int16_t* psValores;
+    uint8_t* pucDestino;
+
+    configASSERT(xTamanho <= gravacaoTAMANHO_BUFFER && uxZonas <= UINT16_MAX);
+
+    xCabecalho.ulTick = (uint32_t)xTaskGetTickCount();
+    xCabecalho.ucSensor = (uint8_t)eSensor;
+    xCabecalho.ucCanais = (uint8_t)uxCanais;
+    xCabecalho.usZonas = (uint16_t)uxZonas;
+
+    xSemaphoreTake(xMutexGravacao, portMAX_DELAY);
+    {
+        /* Sem espaco: passa a usar o outro buffer se ele ja foi gravado,
+         * senao descarta. */
+        if (xOcupado[uxBufferCorrente] + xTamanho > gravacaoTAMANHO_BUFFER) {
+            if (xOutroPendente) {
+                xEstatisticas.ulDescartados++;
+                xSemaphoreGive(xMutexGravacao);
+                return;
+            }
+
+            uxBufferCorrente = 1 - uxBufferCorrente;
+            xOutroPendente = pdTRUE;
+            xAvisar = pdTRUE;
+        }
+
+        pucDestino = &ucBuffers[uxBufferCorrente][xOcupado[uxBufferCorrente]];
+        memcpy(pucDestino, &xCabecalho, sizeof(xCabecalho));
+        psValores = (int16_t*)(pucDestino + sizeof(xCabecalho));
+        for (UBaseType_t uxZona = 0; uxZona < uxZonas; uxZona++) {
+            *psValores++ = (int16_t)plCanal0[uxZona];
+            if (plCanal1 != NULL)
+                *psValores++ = (int16_t)plCanal1[uxZona];
+        }
+
+        xOcupado[uxBufferCorrente] += xTamanho;
+        xEstatisticas.ulRegistros++;
+    }
+    xSemaphoreGive(xMutexGravacao);
+
+    if (xAvisar)
+        xTaskNotifyGive(xTarefaEscrita);
+}
+/*-----------------------------------------------------------*/
+
+void GravacaoObterEstatisticas(EstatisticaGravacao_t* pxEstatisticas)
+{
+    xSemaphoreTake(xMutexGravacao, portMAX_DELAY);
+    {
+        *pxEstatisticas = xEstatisticas;
+    }
+    xSemaphoreGive(xMutexGravacao);
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t ReproducaoAbrir(const char* pcArquivo)
+{
+    CabecalhoArquivoGravacao_t xCabecalho;
+
+    pxArquivoReproducao = fopen(pcArquivo, "rb");
+    if (pxArquivoReproducao == NULL)
+        return pdFAIL;
+
+    if (fread(&xCabecalho, sizeof(xCabecalho), 1, pxArquivoReproducao) != 1 ||
+        xCabecalho.ulMagico != gravacaoMAGICO ||
+        xCabecalho.ulTicksPorSegundo != configTICK_RATE_HZ) {
+        ReproducaoFechar();
+        return pdFAIL;
+    }
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t ReproducaoLer(CabecalhoRegistroGravacao_t* pxCabecalho, int32_t* plCanal0, int32_t* plCanal1, UBaseType_t uxMaxZonas)
+{
+    int16_t sValores[gravacaoMAX_CANAIS];
+
+    if (pxArquivoReproducao == NULL ||
+        fread(pxCabecalho, sizeof(*pxCabecalho), 1, pxArquivoReproducao) != 1)
+        return pdFALSE;
+
+    if (pxCabecalho->ucSensor >= NUM_SENSORES || pxCabecalho->ucCanais == 0 ||
+        pxCabecalho->ucCanais > gravacaoMAX_CANAIS || pxCabecalho->usZonas > uxMaxZonas)
+        return pdFALSE;
+
+    for (UBaseType_t uxZona = 0; uxZona < pxCabecalho->usZonas; uxZona++) {
+        if (fread(sValores, sizeof(int16_t), pxCabecalho->ucCanais, pxArquivoReproducao) != pxCabecalho->ucCanais)
+            return pdFALSE;
+
+        plCanal0[uxZona] = sValores[0];
+        if (pxCabecalho->ucCanais > 1 && plCanal1 != NULL)
+            plCanal1[uxZona] = sValores[1];
+    }
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void ReproducaoFechar(void)
+{
+    if (pxArquivoReproducao != NULL) {
+        fclose(pxArquivoReproducao);
+        pxArquivoReproducao = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,78 @@
+#ifndef GRAVACAO_SENSORES_H
+#define GRAVACAO_SENSORES_H
+
+/*
+ * Gravacao e reproducao das leituras dos sensores.
+ *
+ * Na gravacao cada gerador entrega as leituras de todas as zonas depois de
+ * produzi-las.  Os registros sao acumulados em dois buffers estaticos; quando
+ * um enche, uma tarefa de escrita de baixa prioridade grava o buffer no
+ * arquivo enquanto o outro continua recebendo registros.  Se os dois
+ * estiverem cheios o registro e descartado e contado, sem bloquear o gerador.
+ * Um buffer parcial e gravado a cada gravacaoINTERVALO_ESCRITA, entao uma
+ * parada abrupta perde no maximo esse intervalo.
+ *
+ * Formato do arquivo (little-endian, como gravado pelo simulador):
+ *   CabecalhoArquivoGravacao_t
+ *   repetido: CabecalhoRegistroGravacao_t + usZonas * ucCanais valores
+ *             int16_t, zona a zona (canal 0, canal 1, ...)
+ * Todas as leituras dos sensores cabem em 16 bits.
+ *
+ * A leitura do arquivo (Reproducao*) e sequencial e deve ser feita por uma
+ * unica tarefa.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Gateway.h"
+
+#define gravacaoMAGICO                  0x31535747UL    /* "GWS1" */
+#define gravacaoMAX_CANAIS              2
+#define gravacaoTAMANHO_BUFFER          ( 64 * 1024 )
+#define gravacaoINTERVALO_ESCRITA       pdMS_TO_TICKS( 1000 )
+#define gravacaoTAMANHO_PILHA           configMINIMAL_STACK_SIZE
+
+typedef struct {
+    uint32_t ulMagico;
+    uint32_t ulTicksPorSegundo;
+} CabecalhoArquivoGravacao_t;
+
+typedef struct {
+    uint32_t ulTick;
+    uint8_t ucSensor;               /* Sensor_t */
+    uint8_t ucCanais;
+    uint16_t usZonas;
+} CabecalhoRegistroGravacao_t;
+
+typedef struct {
+    uint32_t ulRegistros;
+    uint32_t ulDescartados;         /* Os dois buffers estavam cheios */
+    uint64_t ullBytes;
+} EstatisticaGravacao_t;
+
+/* Cria o arquivo e a tarefa de escrita.  Retorna pdFAIL se o arquivo nao
+ * puder ser criado. */
+BaseType_t GravacaoIniciar(const char* pcArquivo, UBaseType_t uxPrioridadeEscrita);
+
+/* Chamada pelo gerador do sensor.  plCanal1 e NULL para sensores de um
+ * canal.  Nao bloqueia. */
+void GravacaoRegistrar(Sensor_t eSensor, UBaseType_t uxZonas, const int32_t* plCanal0, const int32_t* plCanal1);
+
+void GravacaoObterEstatisticas(EstatisticaGravacao_t* pxEstatisticas);
+
+/* Abre uma gravacao para leitura.  Retorna pdFAIL se o arquivo nao existir
+ * ou nao for uma gravacao. */
+BaseType_t ReproducaoAbrir(const char* pcArquivo);
+
+/* Le o proximo registro.  Os vetores precisam ter uxMaxZonas posicoes;
+ * plCanal1 so e preenchido para registros de dois canais.  Retorna pdFALSE
+ * no fim do arquivo ou num registro invalido. */
+BaseType_t ReproducaoLer(CabecalhoRegistroGravacao_t* pxCabecalho, int32_t* plCanal0, int32_t* plCanal1, UBaseType_t uxMaxZonas);
+
+void ReproducaoFechar(void);
+
+/* Bytes dos dois buffers, reservados mesmo sem gravacao. */
+extern const size_t xRamGravacao;
+
+#endif /* GRAVACAO_SENSORES_H */
@@ -0,0 +1,34 @@
+#ifndef HEAP_REFERENCIA_H
+#define HEAP_REFERENCIA_H
+
+/*
+ * heap_4 e heap_5 do kernel, compilados com os simbolos renomeados ao lado do
+ * alocador do sistema (AlocadorPools.h), so para o benchmark de heap.  Cada um
+ * tem sua propria arena de configTOTAL_HEAP_SIZE bytes; sem traceMALLOC(),
+ * traceFREE() e sem o gancho de falha de alocacao.
+ */
+
+#include "FreeRTOS.h"
+
+void* pvHeap4Alocar(size_t xWantedSize);
+void vHeap4Liberar(void* pv);
+void* pvHeap4Calloc(size_t xNum, size_t xSize);
+size_t xHeap4Livres(void);
+size_t xHeap4MinimoLivres(void);
+void vHeap4InicializarBlocos(void);
+void vHeap4Estatisticas(HeapStats_t* pxHeapStats);
+
+void* pvHeap5Alocar(size_t xWantedSize);
+void vHeap5Liberar(void* pv);
+void* pvHeap5Calloc(size_t xNum, size_t xSize);
+size_t xHeap5Livres(void);
+size_t xHeap5MinimoLivres(void);
+void vHeap5InicializarBlocos(void);
+void vHeap5Estatisticas(HeapStats_t* pxHeapStats);
+void vHeap5DefinirRegioes(const HeapRegion_t* const pxHeapRegions);
+
+/* Define as regioes do heap_5, como o main.c fazia quando o heap_5 era o
+ * alocador do sistema.  Chamar uma vez, antes da primeira alocacao. */
+void Heap5Inicializar(void);
+
+#endif /* HEAP_REFERENCIA_H */
@@ -0,0 +1,28 @@
+/*
+ * heap_4 do kernel com os simbolos renomeados.  Ver HeapReferencia.h.
+ */
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "HeapReferencia.h"
+
+/* O benchmark conta as falhas; o rastreio e o gancho sao do alocador do
+ * sistema. */
+#undef traceMALLOC
+#define traceMALLOC( pvAddress, uiSize )
+#undef traceFREE
+#define traceFREE( pvAddress, uiSize )
+#undef configUSE_MALLOC_FAILED_HOOK
+#define configUSE_MALLOC_FAILED_HOOK            0
+
+#define pvPortMalloc                            pvHeap4Alocar
+#define vPortFree                               vHeap4Liberar
+#define pvPortCalloc                            pvHeap4Calloc
+#define xPortGetFreeHeapSize                    xHeap4Livres
+#define xPortGetMinimumEverFreeHeapSize         xHeap4MinimoLivres
+#define vPortInitialiseBlocks                   vHeap4InicializarBlocos
+#define vPortGetHeapStats                       vHeap4Estatisticas
+
+#include "../../Source/portable/MemMang/heap_4.c"
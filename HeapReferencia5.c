@@ -0,0 +1,53 @@
+/*
+ * heap_5 do kernel com os simbolos renomeados.  Ver HeapReferencia.h.
+ */
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "HeapReferencia.h"
+
+/* Regioes desalinhadas e com buracos entre elas, como no demo original. */
+#define heapREGIAO_1                            8201
+#define heapREGIAO_2                            23905
+#define heapREGIAO_3                            16807
+
+/* O benchmark conta as falhas; o rastreio e o gancho sao do alocador do
+ * sistema. */
+#undef traceMALLOC
+#define traceMALLOC( pvAddress, uiSize )
+#undef traceFREE
+#define traceFREE( pvAddress, uiSize )
+#undef configUSE_MALLOC_FAILED_HOOK
+#define configUSE_MALLOC_FAILED_HOOK            0
+
+#define pvPortMalloc                            pvHeap5Alocar
+#define vPortFree                               vHeap5Liberar
+#define pvPortCalloc                            pvHeap5Calloc
+#define xPortGetFreeHeapSize                    xHeap5Livres
+#define xPortGetMinimumEverFreeHeapSize         xHeap5MinimoLivres
+#define vPortInitialiseBlocks                   vHeap5InicializarBlocos
+#define vPortGetHeapStats                       vHeap5Estatisticas
+#define vPortDefineHeapRegions                  vHeap5DefinirRegioes
+
+#include "../../Source/portable/MemMang/heap_5.c"
+
+/*-----------------------------------------------------------*/
+
+void Heap5Inicializar(void)
+{
+    /* Um vetor so, com as regioes em ordem crescente de endereco. */
+    static uint8_t ucArena[configTOTAL_HEAP_SIZE];
+    const HeapRegion_t xRegioes[] = {
+        { ucArena + 1,                                   heapREGIAO_1 },
+        { ucArena + 15 + heapREGIAO_1,                   heapREGIAO_2 },
+        { ucArena + 19 + heapREGIAO_1 + heapREGIAO_2,    heapREGIAO_3 },
+        { NULL,                                          0            }
+    };
+
+    configASSERT((19 + heapREGIAO_1 + heapREGIAO_2 + heapREGIAO_3) < configTOTAL_HEAP_SIZE);
+
+    vHeap5DefinirRegioes(xRegioes);
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,292 @@
+/*
+ * Contabilidade do heap por tarefa.  Ver HeapTarefas.h.
+ */
+
+/* Aqui traceMALLOC() e traceFREE() sao os do recorder (ver FreeRTOSConfig.h). */
+#define heapTAREFAS_IMPLEMENTACAO
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "HeapTarefas.h"
+
+#if ( configHEAP_POR_TAREFA == 1 )
+
+/* Marca a entrada que acumula as tarefas que nao couberam na tabela; nunca e
+ * um handle de tarefa. */
+#define heapTAREFAS_OUTRAS              ( ( TaskHandle_t ) &xEntradas )
+
+#define heapTAREFAS_MASCARA             ( heapTAREFAS_MAX_BLOCOS - 1 )
+
+typedef struct {
+    TaskHandle_t xTarefa;           /* NULL na entrada da partida */
+    EstatisticaHeapTarefa_t xEstatisticas;
+    TickType_t xInicioJanela;
+    uint32_t ulAlocacoesJanela;
+} EntradaHeap_t;
+
+typedef struct {
+    void* pvEndereco;               /* NULL: posicao vazia */
+    uint8_t ucEntrada;
+} BlocoVivo_t;
+
+static EntradaHeap_t xEntradas[heapTAREFAS_MAX_TAREFAS];
+static UBaseType_t uxNumEntradas;
+
+/* Dono de cada bloco vivo: hash com sondagem linear. */
+static BlocoVivo_t xBlocos[heapTAREFAS_MAX_BLOCOS];
+static uint32_t ulBlocosNaoRastreados;
+
+const size_t xRamHeapTarefas = sizeof(xEntradas) + sizeof(xBlocos);
+
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvHash(const void* pv)
+{
+    uint32_t ulHash = (uint32_t)((uintptr_t)pv >> 3) * 2654435761UL;
+
+    return (UBaseType_t)(ulHash >> 16) & heapTAREFAS_MASCARA;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInserirBloco(void* pv, UBaseType_t uxEntrada)
+{
+    UBaseType_t uxPos = prvHash(pv);
+
+    for (UBaseType_t uxSondagens = 0; uxSondagens < heapTAREFAS_MAX_BLOCOS; uxSondagens++) {
+        if (xBlocos[uxPos].pvEndereco == NULL) {
+            xBlocos[uxPos].pvEndereco = pv;
+            xBlocos[uxPos].ucEntrada = (uint8_t)uxEntrada;
+            return;
+        }
+        uxPos = (uxPos + 1) & heapTAREFAS_MASCARA;
+    }
+
+    ulBlocosNaoRastreados++;
+}
+/*-----------------------------------------------------------*/
+
+/* Retorna a entrada dona de pv, ou -1, e tira o bloco da tabela. */
+static BaseType_t prvRemoverBloco(const void* pv)
+{
+    UBaseType_t uxPos = prvHash(pv);
+    UBaseType_t uxProxima;
+    BaseType_t xEntrada;
+
+    while (xBlocos[uxPos].pvEndereco != pv) {
+        if (xBlocos[uxPos].pvEndereco == NULL)
+            return -1;
+        uxPos = (uxPos + 1) & heapTAREFAS_MASCARA;
+    }
+
+    xEntrada = xBlocos[uxPos].ucEntrada;
+    xBlocos[uxPos].pvEndereco = NULL;
+
+    /* Puxa para o buraco os blocos seguintes da mesma sequencia cuja posicao
+     * de origem nao fica entre o buraco e eles, para a busca nao parar antes. */
+    uxProxima = uxPos;
+    for (;;) {
+        UBaseType_t uxOrigem;
+
+        uxProxima = (uxProxima + 1) & heapTAREFAS_MASCARA;
+        if (xBlocos[uxProxima].pvEndereco == NULL)
+            break;
+
+        uxOrigem = prvHash(xBlocos[uxProxima].pvEndereco);
+        if (uxPos <= uxProxima ? (uxPos < uxOrigem && uxOrigem <= uxProxima)
+                               : (uxPos < uxOrigem || uxOrigem <= uxProxima))
+            continue;
+
+        xBlocos[uxPos] = xBlocos[uxProxima];
+        xBlocos[uxProxima].pvEndereco = NULL;
+        uxPos = uxProxima;
+    }
+
+    return xEntrada;
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvEntradaCorrente(void)
+{
+    TaskHandle_t xTarefa = NULL;
+    const char* pcNome = "partida";
+    EntradaHeap_t* pxEntrada;
+
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+        xTarefa = xTaskGetCurrentTaskHandle();
+        pcNome = pcTaskGetName(xTarefa);
+    }
+
+    for (UBaseType_t ux = 0; ux < uxNumEntradas; ux++) {
+        if (xEntradas[ux].xTarefa == xTarefa && !xEntradas[ux].xEstatisticas.xEncerrada)
+            return ux;
+    }
+
+    if (uxNumEntradas == heapTAREFAS_MAX_TAREFAS) {
+        pxEntrada = &xEntradas[heapTAREFAS_MAX_TAREFAS - 1];
+        if (pxEntrada->xTarefa != heapTAREFAS_OUTRAS) {
+            pxEntrada->xTarefa = heapTAREFAS_OUTRAS;
+            pxEntrada->xEstatisticas.xEncerrada = pdFALSE;
+            snprintf(pxEntrada->xEstatisticas.cNome, sizeof(pxEntrada->xEstatisticas.cNome), "outras");
+        }
+        return heapTAREFAS_MAX_TAREFAS - 1;
+    }
+
+    pxEntrada = &xEntradas[uxNumEntradas];
+    memset(pxEntrada, 0, sizeof(*pxEntrada));
+    pxEntrada->xTarefa = xTarefa;
+    pxEntrada->xInicioJanela = xTaskGetTickCount();
+    snprintf(pxEntrada->xEstatisticas.cNome, sizeof(pxEntrada->xEstatisticas.cNome), "%s", pcNome);
+
+    return uxNumEntradas++;
+}
+/*-----------------------------------------------------------*/
+
+/* Taxa da janela corrente se ela ja passou de um segundo, senao a da
+ * anterior. */
+static uint32_t prvTaxa(const EntradaHeap_t* pxEntrada, TickType_t xAgora)
+{
+    TickType_t xDecorrido = xAgora - pxEntrada->xInicioJanela;
+
+    if (xDecorrido < configTICK_RATE_HZ)
+        return pxEntrada->xEstatisticas.ulAlocacoesPorSegundo;
+
+    return (uint32_t)((uint64_t)pxEntrada->ulAlocacoesJanela * configTICK_RATE_HZ / xDecorrido);
+}
+/*-----------------------------------------------------------*/
+
+void HeapTarefasAlocacao(void* pvEndereco, size_t xTamanho)
+{
+    UBaseType_t uxEntrada = prvEntradaCorrente();
+    EntradaHeap_t* pxEntrada = &xEntradas[uxEntrada];
+    EstatisticaHeapTarefa_t* pxEstatisticas = &pxEntrada->xEstatisticas;
+    TickType_t xAgora = xTaskGetTickCount();
+
+    if (pvEndereco == NULL) {
+        pxEstatisticas->ulFalhas++;
+    }
+    else {
+        if (xAgora - pxEntrada->xInicioJanela >= configTICK_RATE_HZ) {
+            pxEstatisticas->ulAlocacoesPorSegundo = prvTaxa(pxEntrada, xAgora);
+            pxEntrada->xInicioJanela = xAgora;
+            pxEntrada->ulAlocacoesJanela = 0;
+        }
+        pxEntrada->ulAlocacoesJanela++;
+
+        pxEstatisticas->ulAlocacoes++;
+        pxEstatisticas->ullBytesAlocados += xTamanho;
+        pxEstatisticas->xBytesVivos += xTamanho;
+        if (pxEstatisticas->xBytesVivos > pxEstatisticas->xPicoBytes)
+            pxEstatisticas->xPicoBytes = pxEstatisticas->xBytesVivos;
+
+        prvInserirBloco(pvEndereco, uxEntrada);
+    }
+
+    traceMALLOC(pvEndereco, xTamanho);
+}
+/*-----------------------------------------------------------*/
+
+void HeapTarefasLiberacao(void* pvEndereco, size_t xTamanho)
+{
+    BaseType_t xEntrada = prvRemoverBloco(pvEndereco);
+
+    if (xEntrada >= 0) {
+        EstatisticaHeapTarefa_t* pxEstatisticas = &xEntradas[xEntrada].xEstatisticas;
+
+        pxEstatisticas->ulLiberacoes++;
+        pxEstatisticas->xBytesVivos -= xTamanho <= pxEstatisticas->xBytesVivos ? xTamanho : pxEstatisticas->xBytesVivos;
+    }
+
+    /* TCB liberado: a tarefa acabou e o handle pode voltar com outra. */
+    for (UBaseType_t ux = 0; ux < uxNumEntradas; ux++) {
+        if (xEntradas[ux].xTarefa == (TaskHandle_t)pvEndereco)
+            xEntradas[ux].xEstatisticas.xEncerrada = pdTRUE;
+    }
+
+    traceFREE(pvEndereco, xTamanho);
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t HeapTarefasObter(UBaseType_t uxEntrada, EstatisticaHeapTarefa_t* pxEstatisticas)
+{
+    BaseType_t xOk = pdFAIL;
+
+    vTaskSuspendAll();
+    {
+        if (uxEntrada < uxNumEntradas) {
+            *pxEstatisticas = xEntradas[uxEntrada].xEstatisticas;
+            pxEstatisticas->ulAlocacoesPorSegundo = prvTaxa(&xEntradas[uxEntrada], xTaskGetTickCount());
+            xOk = pdPASS;
+        }
+    }
+    (void)xTaskResumeAll();
+
+    return xOk;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t HeapTarefasMaiorConsumidora(void)
+{
+    BaseType_t xMaior = -1;
+    size_t xMaiorBytes = 0;
+
+    vTaskSuspendAll();
+    {
+        for (UBaseType_t ux = 0; ux < uxNumEntradas; ux++) {
+            if (xEntradas[ux].xEstatisticas.xBytesVivos > xMaiorBytes) {
+                xMaiorBytes = xEntradas[ux].xEstatisticas.xBytesVivos;
+                xMaior = (BaseType_t)ux;
+            }
+        }
+    }
+    (void)xTaskResumeAll();
+
+    return xMaior;
+}
+/*-----------------------------------------------------------*/
+
+void HeapTarefasExportar(void)
+{
+    static EstatisticaHeapTarefa_t xCopia[heapTAREFAS_MAX_TAREFAS];
+    UBaseType_t uxEntradas = 0;
+    uint32_t ulNaoRastreados;
+
+    while (HeapTarefasObter(uxEntradas, &xCopia[uxEntradas]) == pdPASS)
+        uxEntradas++;
+    ulNaoRastreados = ulBlocosNaoRastreados;
+
+    /* Ordena por bytes vivos (insercao; sao poucas entradas). */
+    for (UBaseType_t ux = 1; ux < uxEntradas; ux++) {
+        EstatisticaHeapTarefa_t xAtual = xCopia[ux];
+        UBaseType_t uxPos = ux;
+
+        while (uxPos > 0 && xCopia[uxPos - 1].xBytesVivos < xAtual.xBytesVivos) {
+            xCopia[uxPos] = xCopia[uxPos - 1];
+            uxPos--;
+        }
+        xCopia[uxPos] = xAtual;
+    }
+
+    printf("[heap por tarefa] livre %u bytes, minimo historico %u bytes, blocos nao rastreados %lu\n",
+           (unsigned)xPortGetFreeHeapSize(), (unsigned)xPortGetMinimumEverFreeHeapSize(),
+           (unsigned long)ulNaoRastreados);
+    for (UBaseType_t ux = 0; ux < uxEntradas; ux++) {
+        printf("[heap por tarefa]   %-*s vivos %6u bytes  pico %6u  alocacoes %7lu (%lu/s)  liberacoes %7lu  falhas %lu%s\n",
+               configMAX_TASK_NAME_LEN, xCopia[ux].cNome,
+               (unsigned)xCopia[ux].xBytesVivos,
+               (unsigned)xCopia[ux].xPicoBytes,
+               (unsigned long)xCopia[ux].ulAlocacoes,
+               (unsigned long)xCopia[ux].ulAlocacoesPorSegundo,
+               (unsigned long)xCopia[ux].ulLiberacoes,
+               (unsigned long)xCopia[ux].ulFalhas,
+               xCopia[ux].xEncerrada ? "  (encerrada)" : "");
+    }
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configHEAP_POR_TAREFA */
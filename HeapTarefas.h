@@ -0,0 +1,67 @@
+#ifndef HEAP_TAREFAS_H
+#define HEAP_TAREFAS_H
+
+/*
+ * Contabilidade do heap por tarefa, pelos ganchos traceMALLOC() e traceFREE()
+ * (ver o fim de FreeRTOSConfig.h).
+ *
+ * Cada alocacao e atribuida a tarefa que chamou pvPortMalloc(), ou a
+ * "partida" antes do escalonador iniciar.  O dono de cada bloco vivo fica numa
+ * tabela hash pelo endereco, entao a liberacao desconta da tarefa que alocou,
+ * mesmo quando quem libera e outra (a ociosa, no caso das tarefas apagadas).
+ * Quando o TCB de uma tarefa e liberado a entrada dela e encerrada e um handle
+ * reaproveitado abre uma entrada nova.
+ *
+ * Os eventos do recorder continuam sendo gerados: os ganchos chamam o
+ * traceMALLOC()/traceFREE() do recorder depois da contabilidade.  Com
+ * configHEAP_POR_TAREFA 0 os ganchos do recorder ficam como estavam.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Entradas por tarefa (a ultima acumula o que nao couber) e blocos vivos
+ * rastreados (potencia de 2). */
+#define heapTAREFAS_MAX_TAREFAS         32
+#define heapTAREFAS_MAX_BLOCOS          512
+
+typedef struct {
+    char cNome[configMAX_TASK_NAME_LEN];
+    BaseType_t xEncerrada;          /* TCB da tarefa ja liberado */
+    size_t xBytesVivos;
+    size_t xPicoBytes;
+    uint32_t ulAlocacoes;
+    uint32_t ulLiberacoes;
+    uint32_t ulFalhas;
+    uint32_t ulAlocacoesPorSegundo; /* No ultimo segundo completo */
+    uint64_t ullBytesAlocados;
+} EstatisticaHeapTarefa_t;
+
+#if ( configHEAP_POR_TAREFA == 1 )
+
+    /* Ganchos, chamados com o escalonador suspenso pelo heap. */
+    void HeapTarefasAlocacao(void* pvEndereco, size_t xTamanho);
+    void HeapTarefasLiberacao(void* pvEndereco, size_t xTamanho);
+
+    /* Retorna pdFAIL se nao houver entrada de indice uxEntrada. */
+    BaseType_t HeapTarefasObter(UBaseType_t uxEntrada, EstatisticaHeapTarefa_t* pxEstatisticas);
+
+    /* Entrada com mais bytes vivos, ou -1 se nenhuma tem. */
+    BaseType_t HeapTarefasMaiorConsumidora(void);
+
+    /* Imprime todas as entradas, em ordem de bytes vivos. */
+    void HeapTarefasExportar(void);
+
+    /* Bytes das entradas e da tabela de blocos, para o orcamento de RAM. */
+    extern const size_t xRamHeapTarefas;
+
+#else
+
+    #define HeapTarefasObter(uxEntrada, pxEstatisticas)     ((void)(uxEntrada), (void)(pxEstatisticas), pdFAIL)
+    #define HeapTarefasMaiorConsumidora()                   (-1)
+    #define HeapTarefasExportar()
+    #define xRamHeapTarefas                                 ((size_t)0)
+
+#endif
+
+#endif /* HEAP_TAREFAS_H */
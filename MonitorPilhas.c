@@ -0,0 +1,238 @@
+/*
+ * Monitor de pilhas.  Ver MonitorPilhas.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "MonitorPilhas.h"
+
+static EstatisticaPilha_t xEntradas[pilhasMAX_TAREFAS];
+static UBaseType_t uxNumEntradas;
+static uint32_t ulAmostragensPerdidas;  /* Mais tarefas que pilhasMAX_TAREFAS */
+
+static TaskStatus_t xSituacao[pilhasMAX_TAREFAS];
+
+const size_t xRamPilhas = sizeof(xEntradas) + sizeof(xSituacao);
+
+static TaskHandle_t xTarefaMonitor;
+static StaticTask_t xTCBMonitor;
+static StackType_t uxPilhaMonitor[pilhasTAMANHO_PILHA];
+
+/*-----------------------------------------------------------*/
+
+/* Chamar com o escalonador suspenso.  Retorna NULL com a tabela cheia. */
+static EstatisticaPilha_t* prvEntrada(UBaseType_t uxNumero, const char* pcNome)
+{
+    EstatisticaPilha_t* pxEntrada;
+
+    for (UBaseType_t ux = 0; ux < uxNumEntradas; ux++) {
+        if (xEntradas[ux].uxNumero == uxNumero)
+            return &xEntradas[ux];
+    }
+
+    if (uxNumEntradas == pilhasMAX_TAREFAS)
+        return NULL;
+
+    pxEntrada = &xEntradas[uxNumEntradas++];
+    memset(pxEntrada, 0, sizeof(*pxEntrada));
+    snprintf(pxEntrada->cNome, sizeof(pxEntrada->cNome), "%s", pcNome);
+    pxEntrada->uxNumero = uxNumero;
+    pxEntrada->xAtiva = pdTRUE;
+    pxEntrada->xTamanhoPresumido = pdTRUE;
+    pxEntrada->ulTamanho = configMINIMAL_STACK_SIZE;
+    pxEntrada->ulLivreMinimo = UINT32_MAX;
+
+    return pxEntrada;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRecomendar(const EstatisticaPilha_t* pxEntrada)
+{
+    uint32_t ulUso = 0;
+    uint32_t ulRecomendado;
+
+    if (pxEntrada->ulLivreMinimo < pxEntrada->ulTamanho)
+        ulUso = pxEntrada->ulTamanho - pxEntrada->ulLivreMinimo;
+
+    ulRecomendado = ulUso + ulUso * pilhasMARGEM_PERCENTUAL / 100 + pilhasFOLGA_PALAVRAS;
+
+    return (ulRecomendado + pilhasARREDONDAMENTO - 1) / pilhasARREDONDAMENTO * pilhasARREDONDAMENTO;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAmostrar(void)
+{
+    UBaseType_t uxTarefas;
+
+    /* xSituacao e compartilhado pelo monitor e por quem chamar
+     * PilhasExportar(): tudo com o escalonador suspenso, que o
+     * uxTaskGetSystemState() suspende de novo. */
+    vTaskSuspendAll();
+    {
+        uxTarefas = uxTaskGetSystemState(xSituacao, pilhasMAX_TAREFAS, NULL);
+
+        if (uxTarefas == 0)
+            ulAmostragensPerdidas++;
+        else {
+            for (UBaseType_t ux = 0; ux < uxNumEntradas; ux++)
+                xEntradas[ux].xAtiva = pdFALSE;
+        }
+
+        for (UBaseType_t ux = 0; ux < uxTarefas; ux++) {
+            EstatisticaPilha_t* pxEntrada = prvEntrada(xSituacao[ux].xTaskNumber, xSituacao[ux].pcTaskName);
+
+            if (pxEntrada == NULL)
+                continue;
+
+            pxEntrada->xAtiva = pdTRUE;
+            if (xSituacao[ux].usStackHighWaterMark < pxEntrada->ulLivreMinimo)
+                pxEntrada->ulLivreMinimo = xSituacao[ux].usStackHighWaterMark;
+        }
+    }
+    (void)xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static void prvMonitorTask(void* pvParameters)
+{
+    TickType_t xUltimoRelatorio;
+    BaseType_t xRelatar;
+
+    (void)pvParameters;
+
+    /* Criadas pelo vTaskStartScheduler(). */
+    PilhasRegistrar(xTaskGetIdleTaskHandle(), configMINIMAL_STACK_SIZE);
+    PilhasRegistrar(xTimerGetTimerDaemonTaskHandle(), configTIMER_TASK_STACK_DEPTH);
+
+    xUltimoRelatorio = xTaskGetTickCount();
+
+    for (;;) {
+        /* Pedido da tecla ou relatorio periodico, que nao depende do
+         * console. */
+        xRelatar = ulTaskNotifyTake(pdTRUE, pilhasPERIODO) > 0;
+        if (pilhasPERIODO_RELATORIO > 0 && xTaskGetTickCount() - xUltimoRelatorio >= pilhasPERIODO_RELATORIO)
+            xRelatar = pdTRUE;
+
+        if (xRelatar) {
+            PilhasExportar();
+            xUltimoRelatorio = xTaskGetTickCount();
+        }
+        else
+            prvAmostrar();
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t PilhasIniciar(UBaseType_t uxPrioridade)
+{
+    configASSERT(xTarefaMonitor == NULL);
+
+    xTarefaMonitor = xTaskCreateStatic(prvMonitorTask, "Pilhas", pilhasTAMANHO_PILHA, NULL,
+                                       uxPrioridade, uxPilhaMonitor, &xTCBMonitor);
+    if (xTarefaMonitor == NULL)
+        return pdFAIL;
+
+    PilhasRegistrar(xTarefaMonitor, pilhasTAMANHO_PILHA);
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void PilhasRegistrar(TaskHandle_t xTarefa, uint32_t ulPalavras)
+{
+    TaskStatus_t xInfo;
+    EstatisticaPilha_t* pxEntrada;
+
+    if (xTarefa == NULL)
+        return;
+
+    /* Sem a marca de agua: so o numero e o nome. */
+    vTaskGetInfo(xTarefa, &xInfo, pdFALSE, eInvalid);
+
+    vTaskSuspendAll();
+    {
+        pxEntrada = prvEntrada(xInfo.xTaskNumber, xInfo.pcTaskName);
+        if (pxEntrada != NULL) {
+            pxEntrada->ulTamanho = ulPalavras;
+            pxEntrada->xTamanhoPresumido = pdFALSE;
+        }
+    }
+    (void)xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t PilhasSolicitarDeISR(void)
+{
+    BaseType_t xTrocar = pdFALSE;
+
+    if (xTarefaMonitor != NULL)
+        vTaskNotifyGiveFromISR(xTarefaMonitor, &xTrocar);
+
+    return xTrocar;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t PilhasObter(UBaseType_t uxEntrada, EstatisticaPilha_t* pxEstatisticas)
+{
+    BaseType_t xOk = pdFAIL;
+
+    vTaskSuspendAll();
+    {
+        if (uxEntrada < uxNumEntradas) {
+            *pxEstatisticas = xEntradas[uxEntrada];
+            pxEstatisticas->ulRecomendado = prvRecomendar(&xEntradas[uxEntrada]);
+            xOk = pdPASS;
+        }
+    }
+    (void)xTaskResumeAll();
+
+    return xOk;
+}
+/*-----------------------------------------------------------*/
+
+void PilhasExportar(void)
+{
+    EstatisticaPilha_t xEntrada;
+    uint32_t ulAlocado = 0, ulRecomendado = 0;
+    BaseType_t xHaPresumidos = pdFALSE;
+
+    prvAmostrar();
+
+    for (UBaseType_t ux = 0; PilhasObter(ux, &xEntrada) == pdPASS; ux++) {
+        /* Registrada e apagada antes de qualquer amostragem. */
+        if (xEntrada.ulLivreMinimo > xEntrada.ulTamanho)
+            xEntrada.ulLivreMinimo = xEntrada.ulTamanho;
+
+        printf("[pilhas] %-*s %4lu palavras%s  uso maximo %4lu  livre minimo %4lu  recomendado %4lu%s\n",
+               configMAX_TASK_NAME_LEN, xEntrada.cNome,
+               (unsigned long)xEntrada.ulTamanho,
+               xEntrada.xTamanhoPresumido ? "*" : " ",
+               (unsigned long)(xEntrada.ulTamanho - xEntrada.ulLivreMinimo),
+               (unsigned long)xEntrada.ulLivreMinimo,
+               (unsigned long)xEntrada.ulRecomendado,
+               xEntrada.xAtiva ? "" : "  (apagada)");
+
+        xHaPresumidos |= xEntrada.xTamanhoPresumido;
+        if (xEntrada.xAtiva) {
+            ulAlocado += xEntrada.ulTamanho;
+            ulRecomendado += xEntrada.ulRecomendado;
+        }
+    }
+
+    printf("[pilhas] tarefas ativas: %lu palavras alocadas, %lu recomendadas (%ld bytes de diferenca)\n",
+           (unsigned long)ulAlocado, (unsigned long)ulRecomendado,
+           ((long)ulAlocado - (long)ulRecomendado) * (long)sizeof(StackType_t));
+    if (xHaPresumidos)
+        printf("[pilhas] * tamanho presumido (configMINIMAL_STACK_SIZE)\n");
+    if (ulAmostragensPerdidas > 0)
+        printf("[pilhas] %lu amostragens perdidas: mais de %u tarefas\n",
+               (unsigned long)ulAmostragensPerdidas, (unsigned)pilhasMAX_TAREFAS);
+    printf("\n");
+}
+/*-----------------------------------------------------------*/
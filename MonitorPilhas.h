@@ -0,0 +1,65 @@
+#ifndef MONITOR_PILHAS_H
+#define MONITOR_PILHAS_H
+
+/*
+ * Monitor de pilhas: uma tarefa de baixa prioridade le, a cada
+ * pilhasPERIODO, a marca de agua (menor espaco livre ja visto, em palavras)
+ * da pilha de todas as tarefas com uxTaskGetSystemState() e guarda o minimo
+ * de cada uma.  As tarefas sao identificadas pelo numero do TCB, entao uma
+ * tarefa apagada e outra criada no mesmo TCB nao se misturam.
+ *
+ * O relatorio (tecla de pilhas, a cada pilhasPERIODO_RELATORIO, fim do soak
+ * ou PilhasExportar()) mostra, por tarefa, o tamanho da pilha, o maior uso
+ * visto e o tamanho recomendado: uso maximo mais pilhasMARGEM_PERCENTUAL %
+ * e pilhasFOLGA_PALAVRAS, arredondado para pilhasARREDONDAMENTO palavras.  O
+ * tamanho vem de PilhasRegistrar(); para as tarefas nao registradas e
+ * presumido configMINIMAL_STACK_SIZE, como nos benchmarks.
+ *
+ * No simulador a pilha de cada tarefa guarda so o contexto salvo, porque o
+ * codigo roda na pilha da thread do Windows: as recomendacoes valem para o
+ * que a porta Win32 usa.  Numa porta nativa o mesmo monitor mede a pilha
+ * inteira.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define pilhasMAX_TAREFAS               48
+#define pilhasPERIODO                   pdMS_TO_TICKS( 100 )
+#define pilhasPERIODO_RELATORIO         pdMS_TO_TICKS( 60000 )   /* 0: so sob pedido */
+#define pilhasMARGEM_PERCENTUAL         25
+#define pilhasFOLGA_PALAVRAS            16
+#define pilhasARREDONDAMENTO            8
+#define pilhasTAMANHO_PILHA             configMINIMAL_STACK_SIZE
+
+typedef struct {
+    char cNome[configMAX_TASK_NAME_LEN];
+    UBaseType_t uxNumero;           /* xTaskNumber do TCB */
+    BaseType_t xAtiva;              /* Vista na ultima amostragem */
+    BaseType_t xTamanhoPresumido;   /* Sem PilhasRegistrar() */
+    uint32_t ulTamanho;             /* Palavras */
+    uint32_t ulLivreMinimo;         /* Palavras */
+    uint32_t ulRecomendado;         /* Palavras */
+} EstatisticaPilha_t;
+
+/* Cria a tarefa do monitor. */
+BaseType_t PilhasIniciar(UBaseType_t uxPrioridade);
+
+/* Informa o tamanho, em palavras, da pilha com que xTarefa foi criada. */
+void PilhasRegistrar(TaskHandle_t xTarefa, uint32_t ulPalavras);
+
+/* Chamada pelo tratador do teclado (interrupcao simulada): o relatorio e
+ * impresso pela tarefa do monitor.  Retorna pdTRUE se ela deve rodar em
+ * seguida. */
+BaseType_t PilhasSolicitarDeISR(void);
+
+/* Retorna pdFAIL se nao houver entrada de indice uxEntrada. */
+BaseType_t PilhasObter(UBaseType_t uxEntrada, EstatisticaPilha_t* pxEstatisticas);
+
+/* Amostra uma vez e imprime o relatorio. */
+void PilhasExportar(void);
+
+/* Bytes das tabelas do monitor (sem a propria pilha e o TCB). */
+extern const size_t xRamPilhas;
+
+#endif /* MONITOR_PILHAS_H */
@@ -0,0 +1,389 @@
+/*
+ * Monitor de tempo de execucao e de prazo das tarefas aperiodicas.  Ver
+ * MonitorPrazos.h.
+ *
+ * Os estouros e as perdas sao detectados por temporizadores de disparo unico
+ * armados na liberacao (prazo) e no inicio (orcamento); MonitorConcluir conta
+ * so o que eles ainda nao marcaram.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "Gateway.h"
+#include "MonitorPrazos.h"
+
+#define monitorPARA_US(x)   ((unsigned long long)(x) * 1000ULL / gatewayRUN_TIME_POR_MS)
+
+/* Unidades do contador de run time equivalentes a um tick. */
+#define monitorRUN_TIME_POR_TICK    ( ( configRUN_TIME_COUNTER_TYPE ) ( gatewayRUN_TIME_POR_MS * portTICK_PERIOD_MS ) )
+
+typedef struct {
+    PrazoTarefa_t xConfig;
+    configRUN_TIME_COUNTER_TYPE ulOrcamento;
+    configRUN_TIME_COUNTER_TYPE ulPrazo;
+    configRUN_TIME_COUNTER_TYPE ulLarguraFaixa;
+
+    /* Liberacoes dos trabalhos pendentes, na ordem de execucao.  Os
+     * uxAtrasados primeiros ja foram contados como prazo perdido. */
+    configRUN_TIME_COUNTER_TYPE ulLiberacoes[monitorMAX_PENDENTES];
+    UBaseType_t uxPrimeira;
+    UBaseType_t uxPendentes;
+    UBaseType_t uxAtrasados;
+
+    /* Trabalho em execucao, o primeiro pendente.  Os trabalhos sao executados
+     * um de cada vez pela tarefa do servidor. */
+    TaskHandle_t xExecutor;                 /* NULL fora da execucao */
+    configRUN_TIME_COUNTER_TYPE ulContadorInicio;
+    BaseType_t xEstourou;
+
+    uint32_t ulTrabalhos;
+    uint32_t ulEstourosOrcamento;
+    uint32_t ulPrazosPerdidos;
+    uint64_t ullExecucaoMax;
+    uint64_t ullRespostaMin;
+    uint64_t ullRespostaMax;
+    configRUN_TIME_COUNTER_TYPE ulUltimaPerda;
+    uint32_t ulHistograma[monitorFAIXAS_HISTOGRAMA];  /* Ultima faixa: acima de 2x o prazo */
+
+    TimerHandle_t xTemporizadorPrazo;
+    TimerHandle_t xTemporizadorOrcamento;
+    StaticTimer_t xTemporizadorPrazoEstatico;
+    StaticTimer_t xTemporizadorOrcamentoEstatico;
+} TarefaMonitorada_t;
+
+static TarefaMonitorada_t xTarefas[monitorMAX_TAREFAS];
+static UBaseType_t uxTarefasMonitoradas;
+
+const size_t xRamMonitor = sizeof(xTarefas);
+
+static void prvPrazoVencido(TimerHandle_t xTemporizador);
+static void prvOrcamentoVencido(TimerHandle_t xTemporizador);
+
+/*-----------------------------------------------------------*/
+
+static TickType_t prvParaTicks(configRUN_TIME_COUNTER_TYPE ulUnidades)
+{
+    /* Arredonda para cima e nunca retorna 0, que nao e um periodo valido. */
+    configRUN_TIME_COUNTER_TYPE ulTicks = (ulUnidades + monitorRUN_TIME_POR_TICK - 1) / monitorRUN_TIME_POR_TICK;
+
+    return (ulTicks < 1) ? 1 : (TickType_t)ulTicks;
+}
+/*-----------------------------------------------------------*/
+
+/* Chamada em secao critica.  Tempo ate o prazo do primeiro trabalho pendente
+ * que ainda nao foi marcado (no minimo 1), ou 0 se nao ha nenhum. */
+static configRUN_TIME_COUNTER_TYPE prvAteProximoPrazo(const TarefaMonitorada_t* pxTarefa, configRUN_TIME_COUNTER_TYPE ulAgora)
+{
+    configRUN_TIME_COUNTER_TYPE ulDecorrido;
+
+    if (pxTarefa->uxAtrasados >= pxTarefa->uxPendentes)
+        return 0;
+
+    ulDecorrido = ulAgora - pxTarefa->ulLiberacoes[(pxTarefa->uxPrimeira + pxTarefa->uxAtrasados) % monitorMAX_PENDENTES];
+
+    return ulDecorrido < pxTarefa->ulPrazo ? pxTarefa->ulPrazo - ulDecorrido : 1;
+}
+/*-----------------------------------------------------------*/
+
+/* Limite superior do percentil a partir do histograma, limitado ao maximo
+ * observado.  Chamado dentro de secao critica. */
+static uint64_t prvPercentil(const TarefaMonitorada_t* pxTarefa, uint32_t ulPercentual)
+{
+    uint32_t ulAlvo = (uint32_t)(((uint64_t)pxTarefa->ulTrabalhos * ulPercentual + 99) / 100);
+    uint32_t ulAcumulado = 0;
+    uint64_t ullLimite;
+    UBaseType_t uxFaixa;
+
+    if (ulAlvo == 0)
+        ulAlvo = 1;
+
+    for (uxFaixa = 0; uxFaixa < monitorFAIXAS_HISTOGRAMA - 1; uxFaixa++) {
+        ulAcumulado += pxTarefa->ulHistograma[uxFaixa];
+        if (ulAcumulado >= ulAlvo) {
+            ullLimite = (uint64_t)(uxFaixa + 1) * pxTarefa->ulLarguraFaixa;
+            return ullLimite < pxTarefa->ullRespostaMax ? ullLimite : pxTarefa->ullRespostaMax;
+        }
+    }
+
+    return pxTarefa->ullRespostaMax;
+}
+/*-----------------------------------------------------------*/
+
+void MonitorInicializar(const PrazoTarefa_t* pxConfig, UBaseType_t uxNumTarefas)
+{
+    UBaseType_t uxTarefa;
+    TarefaMonitorada_t* pxTarefa;
+
+    configASSERT(uxNumTarefas <= monitorMAX_TAREFAS);
+
+    memset(xTarefas, 0, sizeof(xTarefas));
+    for (uxTarefa = 0; uxTarefa < uxNumTarefas; uxTarefa++) {
+        pxTarefa = &xTarefas[uxTarefa];
+        pxTarefa->xConfig = pxConfig[uxTarefa];
+        pxTarefa->ulOrcamento = (configRUN_TIME_COUNTER_TYPE)(pxConfig[uxTarefa].ulOrcamentoMs * gatewayRUN_TIME_POR_MS);
+        pxTarefa->ulPrazo = (configRUN_TIME_COUNTER_TYPE)(pxConfig[uxTarefa].ulPrazoMs * gatewayRUN_TIME_POR_MS);
+        pxTarefa->ulLarguraFaixa = (2 * pxTarefa->ulPrazo + monitorFAIXAS_HISTOGRAMA - 2) / (monitorFAIXAS_HISTOGRAMA - 1);
+        if (pxTarefa->ulLarguraFaixa == 0)
+            pxTarefa->ulLarguraFaixa = 1;
+        pxTarefa->ullRespostaMin = UINT64_MAX;
+
+        /* Os periodos sao trocados a cada armacao. */
+        pxTarefa->xTemporizadorPrazo = xTimerCreateStatic(pxConfig[uxTarefa].pcNome, 1, pdFALSE, pxTarefa,
+                                                          prvPrazoVencido, &pxTarefa->xTemporizadorPrazoEstatico);
+        pxTarefa->xTemporizadorOrcamento = xTimerCreateStatic(pxConfig[uxTarefa].pcNome, 1, pdFALSE, pxTarefa,
+                                                              prvOrcamentoVencido, &pxTarefa->xTemporizadorOrcamentoEstatico);
+        configASSERT(pxTarefa->xTemporizadorPrazo != NULL && pxTarefa->xTemporizadorOrcamento != NULL);
+    }
+    uxTarefasMonitoradas = uxNumTarefas;
+}
+/*-----------------------------------------------------------*/
+
+void MonitorLiberar(UBaseType_t uxTarefa, configRUN_TIME_COUNTER_TYPE ulLiberacao)
+{
+    TarefaMonitorada_t* pxTarefa = &xTarefas[uxTarefa];
+    configRUN_TIME_COUNTER_TYPE ulEspera = 0;
+
+    configASSERT(uxTarefa < uxTarefasMonitoradas);
+
+    taskENTER_CRITICAL();
+    {
+        configASSERT(pxTarefa->uxPendentes < monitorMAX_PENDENTES);
+        pxTarefa->ulLiberacoes[(pxTarefa->uxPrimeira + pxTarefa->uxPendentes) % monitorMAX_PENDENTES] = ulLiberacao;
+        pxTarefa->uxPendentes++;
+
+        /* O temporizador do prazo acompanha so o primeiro trabalho ainda no
+         * prazo; os seguintes vencem depois dele. */
+        if (pxTarefa->uxPendentes == pxTarefa->uxAtrasados + 1)
+            ulEspera = prvAteProximoPrazo(pxTarefa, ulGetRunTimeCounterValue());
+    }
+    taskEXIT_CRITICAL();
+
+    if (ulEspera > 0)
+        xTimerChangePeriod(pxTarefa->xTemporizadorPrazo, prvParaTicks(ulEspera), portMAX_DELAY);
+}
+/*-----------------------------------------------------------*/
+
+void MonitorDescartar(UBaseType_t uxTarefa)
+{
+    TarefaMonitorada_t* pxTarefa = &xTarefas[uxTarefa];
+
+    configASSERT(uxTarefa < uxTarefasMonitoradas);
+
+    /* Se o temporizador estava armado para este trabalho, o callback nao
+     * encontra mais nada a marcar. */
+    taskENTER_CRITICAL();
+    {
+        configASSERT(pxTarefa->uxPendentes > pxTarefa->uxAtrasados);
+        pxTarefa->uxPendentes--;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void MonitorIniciar(UBaseType_t uxTarefa)
+{
+    TarefaMonitorada_t* pxTarefa = &xTarefas[uxTarefa];
+
+    configASSERT(uxTarefa < uxTarefasMonitoradas);
+
+    taskENTER_CRITICAL();
+    {
+        configASSERT(pxTarefa->uxPendentes > 0);
+        pxTarefa->ulContadorInicio = RunTimeTarefaAtual();
+        pxTarefa->xEstourou = pdFALSE;
+        pxTarefa->xExecutor = xTaskGetCurrentTaskHandle();
+    }
+    taskEXIT_CRITICAL();
+
+    xTimerChangePeriod(pxTarefa->xTemporizadorOrcamento, prvParaTicks(pxTarefa->ulOrcamento), portMAX_DELAY);
+}
+/*-----------------------------------------------------------*/
+
+void MonitorConcluir(UBaseType_t uxTarefa)
+{
+    TarefaMonitorada_t* pxTarefa = &xTarefas[uxTarefa];
+    configRUN_TIME_COUNTER_TYPE ulFim;
+    configRUN_TIME_COUNTER_TYPE ulExecucao;
+    configRUN_TIME_COUNTER_TYPE ulResposta;
+    configRUN_TIME_COUNTER_TYPE ulLiberacao;
+    configRUN_TIME_COUNTER_TYPE ulEspera;
+    UBaseType_t uxFaixa;
+
+    configASSERT(uxTarefa < uxTarefasMonitoradas);
+
+    xTimerStop(pxTarefa->xTemporizadorOrcamento, portMAX_DELAY);
+
+    taskENTER_CRITICAL();
+    {
+        ulFim = ulGetRunTimeCounterValue();
+        ulExecucao = RunTimeTarefaAtual() - pxTarefa->ulContadorInicio;
+        ulLiberacao = pxTarefa->ulLiberacoes[pxTarefa->uxPrimeira];
+        ulResposta = ulFim - ulLiberacao;
+
+        /* O que os temporizadores ja marcaram nao e contado de novo; o que
+         * venceu sem o callback ter rodado ainda e contado aqui. */
+        if (!pxTarefa->xEstourou && ulExecucao > pxTarefa->ulOrcamento)
+            pxTarefa->ulEstourosOrcamento++;
+
+        if (pxTarefa->uxAtrasados > 0)
+            pxTarefa->uxAtrasados--;
+        else if (ulResposta > pxTarefa->ulPrazo) {
+            pxTarefa->ulPrazosPerdidos++;
+            pxTarefa->ulUltimaPerda = ulLiberacao;
+        }
+
+        pxTarefa->xExecutor = NULL;
+        pxTarefa->uxPrimeira = (pxTarefa->uxPrimeira + 1) % monitorMAX_PENDENTES;
+        pxTarefa->uxPendentes--;
+
+        pxTarefa->ulTrabalhos++;
+        if (ulExecucao > pxTarefa->ullExecucaoMax)
+            pxTarefa->ullExecucaoMax = ulExecucao;
+        if (ulResposta < pxTarefa->ullRespostaMin)
+            pxTarefa->ullRespostaMin = ulResposta;
+        if (ulResposta > pxTarefa->ullRespostaMax)
+            pxTarefa->ullRespostaMax = ulResposta;
+
+        uxFaixa = (UBaseType_t)(ulResposta / pxTarefa->ulLarguraFaixa);
+        if (uxFaixa >= monitorFAIXAS_HISTOGRAMA)
+            uxFaixa = monitorFAIXAS_HISTOGRAMA - 1;
+        pxTarefa->ulHistograma[uxFaixa]++;
+
+        ulEspera = prvAteProximoPrazo(pxTarefa, ulFim);
+    }
+    taskEXIT_CRITICAL();
+
+    /* O temporizador do prazo passa para o proximo trabalho ainda no prazo.
+     * Sem nenhum ele fica como esta: parar aqui poderia desfazer a armacao de
+     * uma liberacao feita enquanto esta tarefa estava rebaixada. */
+    if (ulEspera > 0)
+        xTimerChangePeriod(pxTarefa->xTemporizadorPrazo, prvParaTicks(ulEspera), portMAX_DELAY);
+}
+/*-----------------------------------------------------------*/
+
+/* Roda na tarefa de temporizadores: marca, em ordem, os pendentes que
+ * passaram do prazo e rearma para o seguinte. */
+static void prvPrazoVencido(TimerHandle_t xTemporizador)
+{
+    TarefaMonitorada_t* pxTarefa = (TarefaMonitorada_t*)pvTimerGetTimerID(xTemporizador);
+    configRUN_TIME_COUNTER_TYPE ulAgora;
+    configRUN_TIME_COUNTER_TYPE ulLiberacao;
+    configRUN_TIME_COUNTER_TYPE ulEspera;
+
+    taskENTER_CRITICAL();
+    {
+        ulAgora = ulGetRunTimeCounterValue();
+
+        while (pxTarefa->uxAtrasados < pxTarefa->uxPendentes) {
+            ulLiberacao = pxTarefa->ulLiberacoes[(pxTarefa->uxPrimeira + pxTarefa->uxAtrasados) % monitorMAX_PENDENTES];
+            if (ulAgora - ulLiberacao <= pxTarefa->ulPrazo)
+                break;
+
+            pxTarefa->uxAtrasados++;
+            pxTarefa->ulPrazosPerdidos++;
+            pxTarefa->ulUltimaPerda = ulLiberacao;
+        }
+
+        ulEspera = prvAteProximoPrazo(pxTarefa, ulAgora);
+    }
+    taskEXIT_CRITICAL();
+
+    if (ulEspera > 0)
+        xTimerChangePeriod(xTemporizador, prvParaTicks(ulEspera), 0);
+}
+/*-----------------------------------------------------------*/
+
+/* Roda na tarefa de temporizadores, que preemptou o executor: o contador de
+ * run time dele esta atualizado.  Se o executor foi preemptado e ainda nao
+ * gastou o orcamento, rearma para o que falta. */
+static void prvOrcamentoVencido(TimerHandle_t xTemporizador)
+{
+    TarefaMonitorada_t* pxTarefa = (TarefaMonitorada_t*)pvTimerGetTimerID(xTemporizador);
+    configRUN_TIME_COUNTER_TYPE ulExecucao;
+    configRUN_TIME_COUNTER_TYPE ulRestante = 0;
+
+    taskENTER_CRITICAL();
+    {
+        if (pxTarefa->xExecutor != NULL && !pxTarefa->xEstourou) {
+            ulExecucao = ulTaskGetRunTimeCounter(pxTarefa->xExecutor) - pxTarefa->ulContadorInicio;
+
+            if (ulExecucao > pxTarefa->ulOrcamento) {
+                pxTarefa->xEstourou = pdTRUE;
+                pxTarefa->ulEstourosOrcamento++;
+            }
+            else
+                ulRestante = pxTarefa->ulOrcamento - ulExecucao + 1;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (ulRestante > 0)
+        xTimerChangePeriod(xTemporizador, prvParaTicks(ulRestante), 0);
+}
+/*-----------------------------------------------------------*/
+
+void MonitorObterResumo(UBaseType_t uxTarefa, ResumoPrazos_t* pxResumo)
+{
+    const TarefaMonitorada_t* pxTarefa = &xTarefas[uxTarefa];
+
+    configASSERT(uxTarefa < uxTarefasMonitoradas);
+
+    taskENTER_CRITICAL();
+    {
+        pxResumo->ulTrabalhos = pxTarefa->ulTrabalhos;
+        pxResumo->ulEstourosOrcamento = pxTarefa->ulEstourosOrcamento;
+        pxResumo->ulPrazosPerdidos = pxTarefa->ulPrazosPerdidos;
+        pxResumo->ulAtrasados = (uint32_t)pxTarefa->uxAtrasados;
+        pxResumo->ullExecucaoMax = pxTarefa->ullExecucaoMax;
+        pxResumo->ullUltimaPerda = pxTarefa->ulUltimaPerda;
+
+        if (pxTarefa->ulTrabalhos == 0) {
+            pxResumo->ullRespostaMin = 0;
+            pxResumo->ullRespostaP50 = 0;
+            pxResumo->ullRespostaP99 = 0;
+            pxResumo->ullRespostaMax = 0;
+        }
+        else {
+            pxResumo->ullRespostaMin = pxTarefa->ullRespostaMin;
+            pxResumo->ullRespostaP50 = prvPercentil(pxTarefa, 50);
+            pxResumo->ullRespostaP99 = prvPercentil(pxTarefa, 99);
+            pxResumo->ullRespostaMax = pxTarefa->ullRespostaMax;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void MonitorExportar(void)
+{
+    ResumoPrazos_t xResumo;
+    UBaseType_t uxTarefa;
+
+    for (uxTarefa = 0; uxTarefa < uxTarefasMonitoradas; uxTarefa++) {
+        MonitorObterResumo(uxTarefa, &xResumo);
+        printf("[prazos] %-10s trabalhos %lu  estouros %lu  perdidos %lu  atrasados agora %lu  exec max %llu us  "
+               "resposta min/p50/p99/max %llu/%llu/%llu/%llu us (prazo %lu ms)\n",
+               xTarefas[uxTarefa].xConfig.pcNome,
+               (unsigned long)xResumo.ulTrabalhos,
+               (unsigned long)xResumo.ulEstourosOrcamento,
+               (unsigned long)xResumo.ulPrazosPerdidos,
+               (unsigned long)xResumo.ulAtrasados,
+               monitorPARA_US(xResumo.ullExecucaoMax),
+               monitorPARA_US(xResumo.ullRespostaMin),
+               monitorPARA_US(xResumo.ullRespostaP50),
+               monitorPARA_US(xResumo.ullRespostaP99),
+               monitorPARA_US(xResumo.ullRespostaMax),
+               (unsigned long)xTarefas[uxTarefa].xConfig.ulPrazoMs);
+        if (xResumo.ulPrazosPerdidos > 0)
+            printf("[prazos] %-10s ultimo prazo perdido: liberado em %llu us\n",
+                   xTarefas[uxTarefa].xConfig.pcNome, monitorPARA_US(xResumo.ullUltimaPerda));
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,76 @@
+#ifndef MONITOR_PRAZOS_H
+#define MONITOR_PRAZOS_H
+
+/*
+ * Monitor de tempo de execucao e de prazo das tarefas aperiodicas T6 a T9.
+ *
+ * Cada trabalho tem tres marcas tiradas do contador de run time
+ * (Run-time-stats-utils.c, ns): liberacao (comando aceito pelo
+ * despachante), inicio e fim da execucao na tarefa do servidor.  Os estouros
+ * sao detectados quando acontecem, por temporizadores de disparo unico: o do
+ * prazo e armado na liberacao e o do orcamento no inicio da execucao, e os
+ * dois sao cancelados na conclusao.  Um trabalho preso ou rebaixado pelo
+ * servidor e contado assim que passa do prazo, mesmo que nunca termine.  O
+ * callback so conta e marca; a impressao fica para MonitorExportar().  Os
+ * tempos de resposta vao para um histograma por tarefa, de onde sai o resumo
+ * min/p50/p99/max.
+ *
+ * Os percentis saem do histograma, entao sao arredondados para cima ate o fim
+ * da faixa.  As faixas cobrem ate duas vezes o prazo; acima disso so o
+ * maximo e exato.
+ */
+
+#include "FreeRTOS.h"
+
+#define monitorMAX_TAREFAS          4
+#define monitorFAIXAS_HISTOGRAMA    128
+
+/* Trabalhos liberados e nao concluidos de uma tarefa; precisa cobrir a fila
+ * do servidor mais o trabalho em execucao. */
+#define monitorMAX_PENDENTES        16
+
+typedef struct {
+    const char* pcNome;
+    uint32_t ulOrcamentoMs;
+    uint32_t ulPrazoMs;             /* Relativo a liberacao */
+} PrazoTarefa_t;
+
+/* Tempos em unidades do contador de run time. */
+typedef struct {
+    uint32_t ulTrabalhos;
+    uint32_t ulEstourosOrcamento;
+    uint32_t ulPrazosPerdidos;
+    uint32_t ulAtrasados;           /* Ja passaram do prazo e ainda nao terminaram */
+    uint64_t ullExecucaoMax;
+    uint64_t ullRespostaMin;
+    uint64_t ullRespostaP50;
+    uint64_t ullRespostaP99;
+    uint64_t ullRespostaMax;
+    uint64_t ullUltimaPerda;        /* Liberacao do ultimo trabalho que perdeu o prazo */
+} ResumoPrazos_t;
+
+/* pxConfig[i] descreve a tarefa de indice i nas demais funcoes.  Cria os
+ * temporizadores (memoria estatica); chamar uma vez, antes do escalonador. */
+void MonitorInicializar(const PrazoTarefa_t* pxConfig, UBaseType_t uxNumTarefas);
+
+/* Chamadas pelo despachante.  ulLiberacao e o instante em que o pedido foi
+ * aceito; os trabalhos de uma tarefa comecam na ordem em que foram liberados.
+ * MonitorDescartar() desfaz a ultima liberacao da tarefa, quando o pedido nao
+ * chegou a ser submetido. */
+void MonitorLiberar(UBaseType_t uxTarefa, configRUN_TIME_COUNTER_TYPE ulLiberacao);
+void MonitorDescartar(UBaseType_t uxTarefa);
+
+/* Chamadas pela tarefa que executa o trabalho mais antigo liberado, antes e
+ * depois dele. */
+void MonitorIniciar(UBaseType_t uxTarefa);
+void MonitorConcluir(UBaseType_t uxTarefa);
+
+void MonitorObterResumo(UBaseType_t uxTarefa, ResumoPrazos_t* pxResumo);
+
+/* Imprime o resumo de todas as tarefas. */
+void MonitorExportar(void);
+
+/* Bytes das tabelas e dos temporizadores, para o orcamento de RAM. */
+extern const size_t xRamMonitor;
+
+#endif /* MONITOR_PRAZOS_H */
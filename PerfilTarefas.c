@@ -0,0 +1,212 @@
+/*
+ * Medicao do tempo de execucao por ativacao.  Ver PerfilTarefas.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Gateway.h"
+#include "PerfilTarefas.h"
+
+#if ( perfilHABILITADO == 1 )
+
+#define perfilPARA_US(x)    ((unsigned long long)(x) * 1000ULL / gatewayRUN_TIME_POR_MS)
+
+typedef struct {
+    const char* pcNome;
+    BaseType_t xEmAtivacao;
+    configRUN_TIME_COUNTER_TYPE ulContadorInicio;
+
+    uint32_t ulAtivacoes;
+    uint64_t ullExecucaoTotal;
+    uint64_t ullExecucaoMin;
+    uint64_t ullExecucaoMax;
+    uint32_t ulHistograma[perfilFAIXAS];
+} PerfilTarefa_t;
+
+static PerfilTarefa_t xPerfis[perfilMAX_TAREFAS];
+static UBaseType_t uxPerfisUsados;
+
+const size_t xRamPerfil = sizeof(xPerfis);
+
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvFaixa(uint64_t ullValor)
+{
+    uint32_t ulValor = ullValor > UINT32_MAX ? UINT32_MAX : (uint32_t)ullValor;
+    UBaseType_t uxBit;
+
+    if (ulValor < perfilSUBFAIXAS)
+        return (UBaseType_t)ulValor;
+
+    /* Bit mais significativo e as perfilSUBFAIXAS_BITS posicoes abaixo dele. */
+    for (uxBit = 31; (ulValor & (1UL << uxBit)) == 0; uxBit--)
+        ;
+
+    return (uxBit - perfilSUBFAIXAS_BITS + 1) * perfilSUBFAIXAS +
+           ((ulValor >> (uxBit - perfilSUBFAIXAS_BITS)) & (perfilSUBFAIXAS - 1));
+}
+/*-----------------------------------------------------------*/
+
+/* Maior valor que cai na faixa. */
+static uint64_t prvLimiteFaixa(UBaseType_t uxFaixa)
+{
+    UBaseType_t uxDeslocamento;
+    uint64_t ullInicio;
+
+    if (uxFaixa < perfilSUBFAIXAS)
+        return uxFaixa;
+
+    uxDeslocamento = uxFaixa / perfilSUBFAIXAS - 1;
+    ullInicio = (uint64_t)(perfilSUBFAIXAS + uxFaixa % perfilSUBFAIXAS) << uxDeslocamento;
+
+    return ullInicio + (1ULL << uxDeslocamento) - 1;
+}
+/*-----------------------------------------------------------*/
+
+/* ulPermil: 500 para p50, 999 para p99.9.  Chamado dentro de secao critica. */
+static uint64_t prvPercentil(const PerfilTarefa_t* pxPerfil, uint32_t ulPermil)
+{
+    uint32_t ulAlvo = (uint32_t)(((uint64_t)pxPerfil->ulAtivacoes * ulPermil + 999) / 1000);
+    uint32_t ulAcumulado = 0;
+    uint64_t ullLimite;
+    UBaseType_t uxFaixa;
+
+    if (ulAlvo == 0)
+        ulAlvo = 1;
+
+    for (uxFaixa = 0; uxFaixa < perfilFAIXAS; uxFaixa++) {
+        ulAcumulado += pxPerfil->ulHistograma[uxFaixa];
+        if (ulAcumulado >= ulAlvo) {
+            ullLimite = prvLimiteFaixa(uxFaixa);
+            return ullLimite < pxPerfil->ullExecucaoMax ? ullLimite : pxPerfil->ullExecucaoMax;
+        }
+    }
+
+    return pxPerfil->ullExecucaoMax;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t PerfilRegistrar(TaskHandle_t xTarefa)
+{
+    PerfilTarefa_t* pxPerfil;
+
+    configASSERT(xTarefa != NULL);
+
+    taskENTER_CRITICAL();
+    {
+        pxPerfil = uxPerfisUsados < perfilMAX_TAREFAS ? &xPerfis[uxPerfisUsados++] : NULL;
+    }
+    taskEXIT_CRITICAL();
+
+    if (pxPerfil == NULL)
+        return pdFAIL;
+
+    memset(pxPerfil, 0, sizeof(*pxPerfil));
+    pxPerfil->pcNome = pcTaskGetName(xTarefa);
+    pxPerfil->ullExecucaoMin = UINT64_MAX;
+
+    vTaskSetApplicationTaskTag(xTarefa, (TaskHookFunction_t)pxPerfil);
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void PerfilInicioAtivacao(void)
+{
+    PerfilTarefa_t* pxPerfil = (PerfilTarefa_t*)xTaskGetApplicationTaskTag(NULL);
+
+    if (pxPerfil == NULL)
+        return;
+
+    pxPerfil->ulContadorInicio = RunTimeTarefaAtual();
+    pxPerfil->xEmAtivacao = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void PerfilFimAtivacao(void)
+{
+    PerfilTarefa_t* pxPerfil = (PerfilTarefa_t*)xTaskGetApplicationTaskTag(NULL);
+    configRUN_TIME_COUNTER_TYPE ulExecucao;
+
+    if (pxPerfil == NULL || !pxPerfil->xEmAtivacao)
+        return;
+
+    ulExecucao = RunTimeTarefaAtual() - pxPerfil->ulContadorInicio;
+
+    /* So esta tarefa escreve no seu perfil; a secao critica protege quem le. */
+    taskENTER_CRITICAL();
+    {
+        pxPerfil->xEmAtivacao = pdFALSE;
+        pxPerfil->ulAtivacoes++;
+        pxPerfil->ullExecucaoTotal += ulExecucao;
+        if (ulExecucao < pxPerfil->ullExecucaoMin)
+            pxPerfil->ullExecucaoMin = ulExecucao;
+        if (ulExecucao > pxPerfil->ullExecucaoMax)
+            pxPerfil->ullExecucaoMax = ulExecucao;
+        pxPerfil->ulHistograma[prvFaixa(ulExecucao)]++;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t PerfilObterResumo(UBaseType_t uxPerfil, ResumoPerfil_t* pxResumo)
+{
+    const PerfilTarefa_t* pxPerfil;
+
+    if (uxPerfil >= uxPerfisUsados)
+        return pdFAIL;
+
+    pxPerfil = &xPerfis[uxPerfil];
+
+    taskENTER_CRITICAL();
+    {
+        pxResumo->pcNome = pxPerfil->pcNome;
+        pxResumo->ulAtivacoes = pxPerfil->ulAtivacoes;
+        pxResumo->ullExecucaoTotal = pxPerfil->ullExecucaoTotal;
+
+        if (pxPerfil->ulAtivacoes == 0) {
+            pxResumo->ullExecucaoMin = 0;
+            pxResumo->ullExecucaoP50 = 0;
+            pxResumo->ullExecucaoP99 = 0;
+            pxResumo->ullExecucaoP999 = 0;
+            pxResumo->ullExecucaoMax = 0;
+        }
+        else {
+            pxResumo->ullExecucaoMin = pxPerfil->ullExecucaoMin;
+            pxResumo->ullExecucaoP50 = prvPercentil(pxPerfil, 500);
+            pxResumo->ullExecucaoP99 = prvPercentil(pxPerfil, 990);
+            pxResumo->ullExecucaoP999 = prvPercentil(pxPerfil, 999);
+            pxResumo->ullExecucaoMax = pxPerfil->ullExecucaoMax;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void PerfilExportar(void)
+{
+    ResumoPerfil_t xResumo;
+    UBaseType_t uxPerfil;
+
+    for (uxPerfil = 0; PerfilObterResumo(uxPerfil, &xResumo) == pdPASS; uxPerfil++) {
+        printf("[perfil] %-34s ativacoes %lu  exec min/p50/p99/p99.9/max %llu/%llu/%llu/%llu/%llu us\n",
+               xResumo.pcNome,
+               (unsigned long)xResumo.ulAtivacoes,
+               perfilPARA_US(xResumo.ullExecucaoMin),
+               perfilPARA_US(xResumo.ullExecucaoP50),
+               perfilPARA_US(xResumo.ullExecucaoP99),
+               perfilPARA_US(xResumo.ullExecucaoP999),
+               perfilPARA_US(xResumo.ullExecucaoMax));
+    }
+}
+/*-----------------------------------------------------------*/
+
+#endif /* perfilHABILITADO */
@@ -0,0 +1,71 @@
+#ifndef PERFIL_TAREFAS_H
+#define PERFIL_TAREFAS_H
+
+/*
+ * Medicao do tempo de execucao de cada ativacao das tarefas da aplicacao.
+ *
+ * Uma tarefa registrada recebe como tag (configUSE_APPLICATION_TASK_TAG) o
+ * endereco do seu perfil.  PerfilInicioAtivacao() e PerfilFimAtivacao(),
+ * chamadas pela propria tarefa em volta de cada ativacao, leem o contador de
+ * run time da tarefa, entao o tempo em que ela ficou bloqueada ou preemptada
+ * nao entra na conta.  Cada ativacao alimenta um histograma log-linear (8
+ * faixas por potencia de 2, erro maximo de 12,5%) de onde saem os percentis.
+ *
+ * As chamadas numa tarefa nao registrada nao fazem nada.  Com
+ * perfilHABILITADO 0 elas somem e nenhuma tarefa recebe tag.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef perfilHABILITADO
+    #define perfilHABILITADO        1
+#endif
+
+#define perfilMAX_TAREFAS           16
+#define perfilSUBFAIXAS_BITS        3
+#define perfilSUBFAIXAS             (1 << perfilSUBFAIXAS_BITS)
+/* Valores de 0 a 2^32 - 1 unidades do contador. */
+#define perfilFAIXAS                ((32 - perfilSUBFAIXAS_BITS + 1) * perfilSUBFAIXAS)
+
+/* Tempos em unidades do contador de run time. */
+typedef struct {
+    const char* pcNome;
+    uint32_t ulAtivacoes;
+    uint64_t ullExecucaoTotal;
+    uint64_t ullExecucaoMin;
+    uint64_t ullExecucaoP50;
+    uint64_t ullExecucaoP99;
+    uint64_t ullExecucaoP999;
+    uint64_t ullExecucaoMax;
+} ResumoPerfil_t;
+
+#if ( perfilHABILITADO == 1 )
+
+    /* Retorna pdFAIL se todos os perfis ja estiverem em uso. */
+    BaseType_t PerfilRegistrar(TaskHandle_t xTarefa);
+
+    void PerfilInicioAtivacao(void);
+    void PerfilFimAtivacao(void);
+
+    /* Retorna pdFAIL se nao houver perfil de indice uxPerfil. */
+    BaseType_t PerfilObterResumo(UBaseType_t uxPerfil, ResumoPerfil_t* pxResumo);
+
+    /* Imprime o resumo de todas as tarefas registradas. */
+    void PerfilExportar(void);
+
+    /* Bytes dos perfis e histogramas, para o orcamento de RAM. */
+    extern const size_t xRamPerfil;
+
+#else
+
+    #define PerfilRegistrar(xTarefa)                ((void)(xTarefa), pdPASS)
+    #define PerfilInicioAtivacao()
+    #define PerfilFimAtivacao()
+    #define PerfilObterResumo(uxPerfil, pxResumo)   pdFAIL
+    #define PerfilExportar()
+    #define xRamPerfil                              ((size_t)0)
+
+#endif /* perfilHABILITADO */
+
+#endif /* PERFIL_TAREFAS_H */
@@ -0,0 +1,262 @@
+/*
+ * Rastreio continuo em arquivos rotativos.  Ver RastreioContinuo.h.
+ *
+ * As funcoes da porta de streaming rodam na TzCtrl (transferencia do buffer
+ * interno) e dentro de xTraceEnable()/xTraceDisable() (abrir e fechar o
+ * segmento).  Cada chamada ao Windows tem a sua propria secao critica curta,
+ * como os blocos de DespejoRastreio.c, e a troca do segmento corrente so
+ * troca o ponteiro dentro dela: fopen() e fclose(), que descarrega o segmento
+ * no disco, ficam com RastreioTrocarSegmento(), fora do recorder.
+ *
+ * RastreioTrocarSegmento() reinicia o recorder acima da prioridade da TzCtrl.
+ * Chamada de uma tarefa de prioridade menor, a TzCtrl estava bloqueada entre
+ * duas transferencias e nao volta antes do cabecalho do segmento novo estar
+ * gravado.  As tarefas acima dessa prioridade continuam rodando.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "RastreioContinuo.h"
+
+#if ( TRC_USE_TRACEALYZER_RECORDER == 1 ) && ( TRC_CFG_RECORDER_MODE == TRC_RECORDER_MODE_STREAMING )
+
+/* Acima da TzCtrl durante a troca do segmento. */
+#define rastreioPRIORIDADE_TROCA        ( TRC_CFG_CTRL_TASK_PRIORITY + 1 )
+
+static FILE* pxSegmento;        /* Recebendo os dados */
+static FILE* pxProximo;         /* Aberto antes da troca */
+static FILE* pxFechado;         /* Fechado depois da troca */
+static EstatisticaRastreio_t xEstatisticas;
+
+/* O primeiro xTraceEnable() abre o segmento 0; os seguintes avancam. */
+static BaseType_t xPrimeiroSegmento = pdTRUE;
+
+/* A tarefa de rotacao e a tecla de rastreio trocam o segmento. */
+static SemaphoreHandle_t xMutexTroca;
+static StaticSemaphore_t xMutexTrocaBuffer;
+
+static TaskHandle_t xTarefaRotacao;
+static StaticTask_t xTCBRotacao;
+static StackType_t uxPilhaRotacao[rastreioTAMANHO_PILHA];
+
+/*-----------------------------------------------------------*/
+
+traceResult xTraceStreamPortInitialize(TraceStreamPortBuffer_t* pxBuffer)
+{
+    if (pxBuffer == NULL)
+        return TRC_FAIL;
+
+    return xTraceInternalEventBufferInitialize(pxBuffer->buffer, sizeof(pxBuffer->buffer));
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvProximoSegmento(void)
+{
+    return xPrimeiroSegmento ? 0 : (xEstatisticas.ulSegmento + 1) % rastreioNUM_ARQUIVOS;
+}
+/*-----------------------------------------------------------*/
+
+static FILE* prvAbrir(uint32_t ulSegmento)
+{
+    char cNome[32];
+    FILE* pxArquivo;
+
+    snprintf(cNome, sizeof(cNome), rastreioARQUIVO_FORMATO, (unsigned)ulSegmento);
+
+    taskENTER_CRITICAL();
+    {
+        pxArquivo = fopen(cNome, "wb");
+    }
+    taskEXIT_CRITICAL();
+
+    return pxArquivo;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFechar(FILE* pxArquivo)
+{
+    if (pxArquivo == NULL)
+        return;
+
+    taskENTER_CRITICAL();
+    {
+        fclose(pxArquivo);
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+int32_t RastreioAbrirSegmento(void)
+{
+    uint32_t ulSegmento = prvProximoSegmento();
+    FILE* pxNovo = pxProximo;
+
+    /* Fora de RastreioTrocarSegmento() (inicio do recorder, vAssertCalled())
+     * nao ha segmento aberto antes: abre aqui, com o que ficou por fechar. */
+    if (pxNovo == NULL) {
+        RastreioFecharPendente();
+        pxNovo = prvAbrir(ulSegmento);
+    }
+
+    taskENTER_CRITICAL();
+    {
+        pxSegmento = pxNovo;
+        pxProximo = NULL;
+        xPrimeiroSegmento = pdFALSE;
+        xEstatisticas.ulSegmento = ulSegmento;
+        xEstatisticas.ulBytesSegmento = 0;
+    }
+    taskEXIT_CRITICAL();
+
+    return pxNovo != NULL ? 0 : -1;
+}
+/*-----------------------------------------------------------*/
+
+void RastreioFecharSegmento(void)
+{
+    int32_t lTransferidos;
+
+    if (pxSegmento == NULL)
+        return;
+
+    /* O que ainda esta no buffer interno pertence a este segmento. */
+    (void)xTraceInternalEventBufferTransfer(&lTransferidos);
+
+    taskENTER_CRITICAL();
+    {
+        configASSERT(pxFechado == NULL);
+        pxFechado = pxSegmento;
+        pxSegmento = NULL;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void RastreioEscrever(void* pvDados, uint32_t ulTamanho, int32_t* plEscritos)
+{
+    taskENTER_CRITICAL();
+    {
+        /* Sem segmento aberto os dados sao dados como escritos, para o buffer
+         * interno nao encher; so a contagem registra a perda. */
+        if (pxSegmento == NULL) {
+            xEstatisticas.ulBytesDescartados += ulTamanho;
+            *plEscritos = (int32_t)ulTamanho;
+        }
+        else {
+            *plEscritos = (int32_t)fwrite(pvDados, 1, ulTamanho, pxSegmento);
+            xEstatisticas.ullBytesGravados += (uint32_t)*plEscritos;
+            xEstatisticas.ulBytesSegmento += (uint32_t)*plEscritos;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void RastreioTrocarSegmento(void)
+{
+    UBaseType_t uxPrioridade = uxTaskPriorityGet(NULL);
+
+    configASSERT(xMutexTroca != NULL);
+    xSemaphoreTake(xMutexTroca, portMAX_DELAY);
+
+    pxProximo = prvAbrir(prvProximoSegmento());
+
+    if (uxPrioridade < rastreioPRIORIDADE_TROCA)
+        vTaskPrioritySet(NULL, rastreioPRIORIDADE_TROCA);
+    (void)xTraceDisable();
+    (void)xTraceEnable(TRC_START);
+    vTaskPrioritySet(NULL, uxPrioridade);
+
+    RastreioFecharPendente();
+
+    xSemaphoreGive(xMutexTroca);
+}
+/*-----------------------------------------------------------*/
+
+void RastreioFecharPendente(void)
+{
+    FILE* pxAntigo;
+
+    taskENTER_CRITICAL();
+    {
+        pxAntigo = pxFechado;
+        pxFechado = NULL;
+    }
+    taskEXIT_CRITICAL();
+
+    prvFechar(pxAntigo);
+}
+/*-----------------------------------------------------------*/
+
+static void prvRotacaoTask(void* pvParameters)
+{
+    (void)pvParameters;
+
+    for (;;) {
+        vTaskDelay(rastreioINTERVALO_ROTACAO);
+
+        if (xEstatisticas.ulBytesSegmento < rastreioBYTES_POR_ARQUIVO)
+            continue;
+
+        RastreioTrocarSegmento();
+        xEstatisticas.ulRotacoes++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t RastreioIniciarRotacao(UBaseType_t uxPrioridade)
+{
+    configASSERT(xTarefaRotacao == NULL);
+
+    xMutexTroca = xSemaphoreCreateMutexStatic(&xMutexTrocaBuffer);
+    xTarefaRotacao = xTaskCreateStatic(prvRotacaoTask, "Rastreio", rastreioTAMANHO_PILHA, NULL,
+                                       uxPrioridade, uxPilhaRotacao, &xTCBRotacao);
+
+    return xTarefaRotacao != NULL ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+void RastreioObterEstatisticas(EstatisticaRastreio_t* pxEstatisticas)
+{
+    taskENTER_CRITICAL();
+    {
+        *pxEstatisticas = xEstatisticas;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+#else
+
+void RastreioTrocarSegmento(void)
+{
+}
+/*-----------------------------------------------------------*/
+
+void RastreioFecharPendente(void)
+{
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t RastreioIniciarRotacao(UBaseType_t uxPrioridade)
+{
+    (void)uxPrioridade;
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void RastreioObterEstatisticas(EstatisticaRastreio_t* pxEstatisticas)
+{
+    memset(pxEstatisticas, 0, sizeof(*pxEstatisticas));
+}
+/*-----------------------------------------------------------*/
+
+#endif /* TRC_CFG_RECORDER_MODE == TRC_RECORDER_MODE_STREAMING */
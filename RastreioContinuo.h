@@ -0,0 +1,50 @@
+#ifndef RASTREIO_CONTINUO_H
+#define RASTREIO_CONTINUO_H
+
+/*
+ * Rastreio continuo do Tracealyzer em arquivos rotativos (modo streaming, ver
+ * Trace_Recorder_Configuration/trcStreamPort.h).
+ *
+ * Os eventos sao gravados em Trace_00.psf, Trace_01.psf, ... ate
+ * rastreioNUM_ARQUIVOS arquivos; depois o mais antigo e sobrescrito.  Quando o
+ * segmento corrente passa de rastreioBYTES_POR_ARQUIVO, a tarefa de rotacao
+ * abre o segmento seguinte, para e reinicia o recorder e fecha o anterior: o
+ * buffer interno e descarregado no segmento que fecha e o recorder grava
+ * cabecalho, tabela de simbolos e objetos no segmento novo, entao cada
+ * arquivo abre sozinho no Tracealyzer.  O escalonador nao para: so a troca do
+ * ponteiro do segmento e cada chamada ao Windows tem secao critica.  O disco
+ * usado fica limitado a rastreioNUM_ARQUIVOS segmentos.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define rastreioARQUIVO_FORMATO         "Trace_%02u.psf"
+#define rastreioNUM_ARQUIVOS            8
+#define rastreioBYTES_POR_ARQUIVO       ( 16UL * 1024UL * 1024UL )
+#define rastreioINTERVALO_ROTACAO       pdMS_TO_TICKS( 1000 )
+#define rastreioTAMANHO_PILHA           configMINIMAL_STACK_SIZE
+
+typedef struct {
+    uint64_t ullBytesGravados;
+    uint32_t ulBytesDescartados;    /* Transferidos sem segmento aberto */
+    uint32_t ulRotacoes;
+    uint32_t ulSegmento;            /* Indice do arquivo corrente */
+    uint32_t ulBytesSegmento;
+} EstatisticaRastreio_t;
+
+/* Cria a tarefa de rotacao.  So tem efeito no modo streaming. */
+BaseType_t RastreioIniciarRotacao(UBaseType_t uxPrioridade);
+
+/* Fecha o segmento corrente e passa para o seguinte, como a rotacao.  Chamada
+ * por tarefas abaixo da prioridade da TzCtrl, fora de secao critica. */
+void RastreioTrocarSegmento(void);
+
+/* Fecha o segmento deixado por um xTraceDisable() fora de
+ * RastreioTrocarSegmento(), como o de DespejoImediato().  Pode ser chamada em
+ * secao critica. */
+void RastreioFecharPendente(void);
+
+void RastreioObterEstatisticas(EstatisticaRastreio_t* pxEstatisticas);
+
+#endif /* RASTREIO_CONTINUO_H */
@@ -0,0 +1,222 @@
+/*
+ * Registro adiado das mensagens do gateway.  Ver RegistroEventos.h.
+ *
+ * Anel limitado de varios produtores e um consumidor.  A posicao i comeca com
+ * sequencia i.  O produtor que reserva o indice p (comparar e trocar na
+ * cabeca) so pode usar a posicao quando a sequencia dela for p, preenche o
+ * registro e publica com sequencia p + 1.  A drenagem consome o indice c
+ * quando a sequencia e c + 1 e devolve a posicao para a volta seguinte com
+ * sequencia c + registroPROFUNDIDADE.  Uma sequencia menor que p indica que a
+ * posicao da volta anterior ainda nao foi drenada: anel cheio.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "PerfilTarefas.h"
+#include "RegistroEventos.h"
+
+#define registroMASCARA     ( registroPROFUNDIDADE - 1 )
+
+typedef struct {
+    volatile uint32_t ulSequencia;
+    RegistroBinario_t xRegistro;
+} PosicaoRegistro_t;
+
+typedef struct {
+    /* Escritos pelos produtores, com comparar e trocar. */
+    volatile uint32_t ulCabeca;
+    volatile uint32_t ulDescartados;
+    uint8_t ucPreenchimentoProdutores[atomicoLINHA_CACHE - 2 * sizeof(uint32_t)];
+
+    /* Escritos apenas pela drenagem. */
+    volatile uint32_t ulCauda;
+    uint32_t ulDrenados;
+    uint32_t ulOcupacaoMax;
+    uint8_t ucPreenchimentoConsumidor[atomicoLINHA_CACHE - 3 * sizeof(uint32_t)];
+} AnelRegistro_t;
+
+static PosicaoRegistro_t xPosicoes[registroPROFUNDIDADE];
+static AnelRegistro_t xAnel;
+
+const size_t xRamRegistro = sizeof(xPosicoes) + sizeof(xAnel);
+
+static const char* const* ppcFormatosRegistro;
+static UBaseType_t uxNumMensagensRegistro;
+static SaidaRegistro_t eSaidaRegistro;
+static volatile ModoRegistro_t eModoRegistro = REGISTRO_DIRETO;
+
+static TaskHandle_t xTarefaDrenagem;
+static StaticTask_t xTCBDrenagem;
+static StackType_t uxPilhaDrenagem[registroTAMANHO_PILHA];
+
+/*-----------------------------------------------------------*/
+
+static void prvImprimir(const RegistroBinario_t* pxRegistro)
+{
+    printf(ppcFormatosRegistro[pxRegistro->usMensagem],
+           (int)pxRegistro->lArgumentos[0], (int)pxRegistro->lArgumentos[1],
+           (int)pxRegistro->lArgumentos[2], (int)pxRegistro->lArgumentos[3]);
+}
+/*-----------------------------------------------------------*/
+
+/* Somente a drenagem. */
+static BaseType_t prvConsumir(RegistroBinario_t* pxRegistro)
+{
+    uint32_t ulCauda = xAnel.ulCauda;
+    PosicaoRegistro_t* pxPosicao = &xPosicoes[ulCauda & registroMASCARA];
+
+    /* Posicao reservada e ainda nao publicada: o produtor foi preemptado no
+     * meio da escrita e o registro sai na proxima drenagem. */
+    if (pxPosicao->ulSequencia != ulCauda + 1)
+        return pdFALSE;
+
+    atomicoBARREIRA_ADQUIRIR();
+    *pxRegistro = pxPosicao->xRegistro;
+
+    /* A copia precisa terminar antes de a posicao voltar aos produtores. */
+    atomicoBARREIRA_LIBERAR();
+    pxPosicao->ulSequencia = ulCauda + registroPROFUNDIDADE;
+    xAnel.ulCauda = ulCauda + 1;
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDrenagemTask(void* pvParameters)
+{
+    RegistroBinario_t xRegistro;
+    FILE* pxArquivo = NULL;
+    uint32_t ulOcupacao;
+
+    (void)pvParameters;
+
+    if (eSaidaRegistro == SAIDA_ARQUIVO) {
+        pxArquivo = fopen(registroARQUIVO, "wb");
+        if (pxArquivo == NULL)
+            printf("[registro] nao foi possivel abrir %s, usando o console\n", registroARQUIVO);
+    }
+
+    for (;;) {
+        PerfilInicioAtivacao();
+
+        ulOcupacao = xAnel.ulCabeca - xAnel.ulCauda;
+        if (ulOcupacao > xAnel.ulOcupacaoMax)
+            xAnel.ulOcupacaoMax = ulOcupacao;
+
+        while (prvConsumir(&xRegistro)) {
+            if (pxArquivo != NULL)
+                fwrite(&xRegistro, sizeof(xRegistro), 1, pxArquivo);
+            else
+                prvImprimir(&xRegistro);
+            xAnel.ulDrenados++;
+        }
+
+        if (pxArquivo != NULL)
+            fflush(pxArquivo);
+
+        PerfilFimAtivacao();
+        vTaskDelay(registroINTERVALO_DRENAGEM);
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t RegistroInicializar(const char* const* ppcFormatos, UBaseType_t uxNumMensagens,
+                               SaidaRegistro_t eSaida, UBaseType_t uxPrioridadeDrenagem)
+{
+    uint32_t i;
+
+    configASSERT((registroPROFUNDIDADE & registroMASCARA) == 0);
+    configASSERT(xTarefaDrenagem == NULL);
+
+    for (i = 0; i < registroPROFUNDIDADE; i++)
+        xPosicoes[i].ulSequencia = i;
+    memset(&xAnel, 0, sizeof(xAnel));
+
+    ppcFormatosRegistro = ppcFormatos;
+    uxNumMensagensRegistro = uxNumMensagens;
+    eSaidaRegistro = eSaida;
+
+    xTarefaDrenagem = xTaskCreateStatic(prvDrenagemTask, "Registro", registroTAMANHO_PILHA, NULL,
+                                        uxPrioridadeDrenagem, uxPilhaDrenagem, &xTCBDrenagem);
+
+    return xTarefaDrenagem != NULL ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+void RegistroDefinirModo(ModoRegistro_t eModo)
+{
+    eModoRegistro = eModo;
+}
+/*-----------------------------------------------------------*/
+
+void RegistroEscrever(uint16_t usMensagem, int32_t lArg0, int32_t lArg1, int32_t lArg2, int32_t lArg3)
+{
+    PosicaoRegistro_t* pxPosicao;
+    uint32_t ulPosicao;
+    uint32_t ulDescartados;
+    int32_t lDiferenca;
+
+    configASSERT(usMensagem < uxNumMensagensRegistro);
+
+    if (eModoRegistro == REGISTRO_DIRETO) {
+        printf(ppcFormatosRegistro[usMensagem], (int)lArg0, (int)lArg1, (int)lArg2, (int)lArg3);
+        return;
+    }
+
+    ulPosicao = xAnel.ulCabeca;
+    for (;;) {
+        pxPosicao = &xPosicoes[ulPosicao & registroMASCARA];
+        lDiferenca = (int32_t)(pxPosicao->ulSequencia - ulPosicao);
+        atomicoBARREIRA_ADQUIRIR();
+
+        if (lDiferenca == 0) {
+            if (atomicoCOMPARAR_TROCAR(&xAnel.ulCabeca, ulPosicao, ulPosicao + 1))
+                break;
+        }
+        else if (lDiferenca < 0) {
+            /* Anel cheio: descarta em vez de esperar pela drenagem. */
+            do {
+                ulDescartados = xAnel.ulDescartados;
+            } while (!atomicoCOMPARAR_TROCAR(&xAnel.ulDescartados, ulDescartados, ulDescartados + 1));
+            return;
+        }
+
+        /* Outro produtor reservou a posicao primeiro. */
+        ulPosicao = xAnel.ulCabeca;
+    }
+
+    pxPosicao->xRegistro.usMensagem = usMensagem;
+    pxPosicao->xRegistro.usReservado = 0;
+    pxPosicao->xRegistro.xTick = xTaskGetTickCount();
+    pxPosicao->xRegistro.lArgumentos[0] = lArg0;
+    pxPosicao->xRegistro.lArgumentos[1] = lArg1;
+    pxPosicao->xRegistro.lArgumentos[2] = lArg2;
+    pxPosicao->xRegistro.lArgumentos[3] = lArg3;
+
+    /* O registro precisa estar completo antes de ficar visivel. */
+    atomicoBARREIRA_LIBERAR();
+    pxPosicao->ulSequencia = ulPosicao + 1;
+}
+/*-----------------------------------------------------------*/
+
+TaskHandle_t RegistroObterTarefaDrenagem(void)
+{
+    return xTarefaDrenagem;
+}
+/*-----------------------------------------------------------*/
+
+void RegistroObterEstatisticas(EstatisticaRegistro_t* pxEstatisticas)
+{
+    /* Cada posicao reservada na cabeca e um registro escrito. */
+    pxEstatisticas->ulEscritos = xAnel.ulCabeca;
+    pxEstatisticas->ulDescartados = xAnel.ulDescartados;
+    pxEstatisticas->ulDrenados = xAnel.ulDrenados;
+    pxEstatisticas->ulOcupacaoMax = xAnel.ulOcupacaoMax;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,82 @@
+#ifndef REGISTRO_EVENTOS_H
+#define REGISTRO_EVENTOS_H
+
+/*
+ * Registro adiado das mensagens do gateway.
+ *
+ * Em vez de formatar e imprimir no caminho de amostragem, a tarefa grava um
+ * registro binario compacto (identificador da mensagem, tick e ate
+ * registroMAX_ARGUMENTOS inteiros) num anel sem trava de varios produtores.
+ * Uma tarefa de drenagem de baixa prioridade esvazia o anel periodicamente e
+ * formata cada registro com o formato da mensagem, ou grava os registros crus
+ * num arquivo.  RegistroEscrever() nunca bloqueia: com o anel cheio o registro
+ * e descartado e contado.
+ *
+ * Cada posicao do anel tem um numero de sequencia que diz se ela esta livre
+ * para o produtor da volta corrente ou pronta para o consumidor, entao um
+ * produtor so disputa com os outros a reserva da posicao (comparar e trocar
+ * na cabeca).  Os formatos aceitam apenas conversoes de inteiros.
+ *
+ * Com REGISTRO_DIRETO a mensagem e impressa na hora com printf, como antes;
+ * o modo pode ser trocado com o gateway rodando, para comparar os custos.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Atomico.h"
+
+/* Profundidade do anel (potencia de 2) e periodo da drenagem. */
+#define registroPROFUNDIDADE            1024
+#define registroMAX_ARGUMENTOS          4
+#define registroINTERVALO_DRENAGEM      pdMS_TO_TICKS( 10 )
+#define registroTAMANHO_PILHA           configMINIMAL_STACK_SIZE
+#define registroARQUIVO                 "Registro.bin"
+
+typedef enum {
+    REGISTRO_DIRETO = 0,            /* printf na tarefa que registra */
+    REGISTRO_ADIADO                 /* Anel + tarefa de drenagem */
+} ModoRegistro_t;
+
+typedef enum {
+    SAIDA_CONSOLE = 0,              /* A drenagem formata com printf */
+    SAIDA_ARQUIVO                   /* A drenagem grava RegistroBinario_t crus em registroARQUIVO */
+} SaidaRegistro_t;
+
+/* Formato gravado no arquivo, na ordem de escrita no anel. */
+typedef struct {
+    uint16_t usMensagem;
+    uint16_t usReservado;
+    TickType_t xTick;
+    int32_t lArgumentos[registroMAX_ARGUMENTOS];
+} RegistroBinario_t;
+
+typedef struct {
+    uint32_t ulEscritos;
+    uint32_t ulDescartados;         /* Anel cheio */
+    uint32_t ulDrenados;
+    uint32_t ulOcupacaoMax;         /* Maior numero de registros esperando a drenagem */
+} EstatisticaRegistro_t;
+
+/* ppcFormatos[i] e o formato da mensagem i; a tabela precisa existir enquanto
+ * o registro estiver em uso.  Cria a tarefa de drenagem (memoria estatica). */
+BaseType_t RegistroInicializar(const char* const* ppcFormatos, UBaseType_t uxNumMensagens,
+                               SaidaRegistro_t eSaida, UBaseType_t uxPrioridadeDrenagem);
+
+void RegistroDefinirModo(ModoRegistro_t eModo);
+
+/* Qualquer tarefa.  Argumentos que o formato nao usa sao ignorados. */
+void RegistroEscrever(uint16_t usMensagem, int32_t lArg0, int32_t lArg1, int32_t lArg2, int32_t lArg3);
+
+#define Registrar0( usMensagem )                    RegistroEscrever( ( usMensagem ), 0, 0, 0, 0 )
+#define Registrar1( usMensagem, a )                 RegistroEscrever( ( usMensagem ), ( int32_t ) ( a ), 0, 0, 0 )
+#define Registrar2( usMensagem, a, b )              RegistroEscrever( ( usMensagem ), ( int32_t ) ( a ), ( int32_t ) ( b ), 0, 0 )
+
+TaskHandle_t RegistroObterTarefaDrenagem(void);
+
+void RegistroObterEstatisticas(EstatisticaRegistro_t* pxEstatisticas);
+
+/* Bytes do anel (posicoes e indices), para o orcamento de RAM. */
+extern const size_t xRamRegistro;
+
+#endif /* REGISTRO_EVENTOS_H */
@@ -28,71 +28,253 @@
  * Utility functions required to gather run time statistics.  See:
  * https://www.FreeRTOS.org/rtos-run-time-stats.html
  *
- * Note that this is a simulated port, where simulated time is a lot slower than
- * real time, therefore the run time counter values have no real meaningful
- * units.
+ * O contador de run time e em nanossegundos (gatewayRUN_TIME_POR_MS) e vem de
+ * uma fonte escolhida por configFONTE_RUN_TIME:
  *
- * Also note that it is assumed this demo is going to be used for short periods
- * of time only, and therefore timer overflows are not handled.
-*/
+ *  - configRUN_TIME_RELOGIO: QueryPerformanceCounter() no Windows,
+ *    clock_gettime( CLOCK_MONOTONIC_RAW ) no Linux;
+ *  - configRUN_TIME_TSC: rdtsc, calibrado contra o relogio na partida.  So
+ *    com TSC invariante (CPUID 0x80000007, EDX bit 8); sem ele volta para o
+ *    relogio.
+ *
+ * O kernel le o contador em toda troca de contexto e o recorder em todo
+ * evento, entao a leitura nao divide: a conversao para nanossegundos e uma
+ * multiplicacao de 64x64 bits e um deslocamento.  A diferenca para a leitura
+ * da partida e feita sem sinal, o que tolera a volta do contador da fonte, e
+ * o resultado de 64 bits so volta depois de 584 anos.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
 
 /* FreeRTOS includes. */
 #include <FreeRTOS.h>
 
-/* Variables used in the creation of the run time stats time base.  Run time
-stats record how much time each task spends in the Running state. */
-static long long llInitialRunTimeCounterValue = 0LL, llTicksPerHundedthMillisecond = 0LL;
+#include "Gateway.h"
+
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+	#define runtimeTEM_TSC			1
+#else
+	#define runtimeTEM_TSC			0
+#endif
+
+#if defined( _WIN32 )
+	/* windows.h ja vem pelo portmacro.h. */
+	#include <intrin.h>
+#else
+	#include <time.h>
+	#if ( runtimeTEM_TSC == 1 )
+		#include <x86intrin.h>
+		#include <cpuid.h>
+	#endif
+#endif
+
+/* ns = ( unidades * ullMultiplicador ) >> runtimeDESLOCAMENTO. */
+#define runtimeDESLOCAMENTO		32
+#define runtimeNS_POR_SEGUNDO	1000000000ULL
+
+/* Janela de calibracao do TSC e leituras para medir o custo de uma leitura. */
+#define runtimeCALIBRACAO_NS	( 20ULL * 1000000ULL )
+#define runtimeLEITURAS_CUSTO	10000UL
+
+typedef uint64_t ( *LerFonte_t )( void );
+
+static uint64_t prvLerNada( void );
+
+/* Ate vConfigureTimerForRunTimeStats() o multiplicador e zero e o contador
+tambem: os ganchos do recorder chamam antes do escalonador iniciar. */
+static LerFonte_t pxLerFonte = prvLerNada;
+static uint64_t ullMultiplicador = 0ULL;
+static uint64_t ullLeituraInicial = 0ULL;
+
+static FonteRunTime_t xFonte = { "nenhuma", 0ULL, 0UL };
 
 /*-----------------------------------------------------------*/
 
-void vConfigureTimerForRunTimeStats( void )
+static uint64_t prvLerNada( void )
 {
-LARGE_INTEGER liPerformanceCounterFrequency, liInitialRunTimeValue;
+	return 0ULL;
+}
+/*-----------------------------------------------------------*/
+
+#if defined( _WIN32 )
+
+	static uint64_t prvLerRelogio( void )
+	{
+	LARGE_INTEGER liContagem;
+
+		QueryPerformanceCounter( &liContagem );
+		return ( uint64_t ) liContagem.QuadPart;
+	}
+
+	static uint64_t prvFrequenciaRelogio( void )
+	{
+	LARGE_INTEGER liFrequencia;
+
+		if( QueryPerformanceFrequency( &liFrequencia ) == 0 )
+		{
+			return 0ULL;
+		}
+
+		return ( uint64_t ) liFrequencia.QuadPart;
+	}
+
+	#define runtimeNOME_RELOGIO		"QueryPerformanceCounter"
+
+#else
+
+	static uint64_t prvLerRelogio( void )
+	{
+	struct timespec xAgora;
+
+		clock_gettime( CLOCK_MONOTONIC_RAW, &xAgora );
+		return ( uint64_t ) xAgora.tv_sec * runtimeNS_POR_SEGUNDO + ( uint64_t ) xAgora.tv_nsec;
+	}
+
+	static uint64_t prvFrequenciaRelogio( void )
+	{
+	struct timespec xAgora;
+
+		if( clock_gettime( CLOCK_MONOTONIC_RAW, &xAgora ) != 0 )
+		{
+			return 0ULL;
+		}
+
+		return runtimeNS_POR_SEGUNDO;
+	}
+
+	#define runtimeNOME_RELOGIO		"CLOCK_MONOTONIC_RAW"
 
-	/* Initialise the variables used to create the run time stats time base.
-	Run time stats record how much time each task spends in the Running
-	state. */
+#endif /* _WIN32 */
+/*-----------------------------------------------------------*/
+
+#if ( runtimeTEM_TSC == 1 )
+
+	static uint64_t prvLerTsc( void )
+	{
+		return ( uint64_t ) __rdtsc();
+	}
 
-	if( QueryPerformanceFrequency( &liPerformanceCounterFrequency ) == 0 )
+	static BaseType_t prvTscInvariante( void )
 	{
-		llTicksPerHundedthMillisecond = 1;
+	#if defined( _WIN32 )
+		int iRegistros[ 4 ];
+
+		__cpuid( iRegistros, 0x80000000 );
+		if( ( unsigned int ) iRegistros[ 0 ] < 0x80000007U )
+		{
+			return pdFALSE;
+		}
+
+		__cpuid( iRegistros, 0x80000007 );
+		return ( ( ( unsigned int ) iRegistros[ 3 ] & ( 1U << 8 ) ) != 0U ) ? pdTRUE : pdFALSE;
+	#else
+		unsigned int uiA, uiB, uiC, uiD;
+
+		/* __get_cpuid() ja confere a folha maxima estendida. */
+		if( __get_cpuid( 0x80000007U, &uiA, &uiB, &uiC, &uiD ) == 0 )
+		{
+			return pdFALSE;
+		}
+
+		return ( ( uiD & ( 1U << 8 ) ) != 0U ) ? pdTRUE : pdFALSE;
+	#endif
 	}
-	else
+
+	/* Conta os ciclos do TSC durante runtimeCALIBRACAO_NS do relogio. */
+	static uint64_t prvCalibrarTsc( uint64_t ullFrequenciaRelogio )
 	{
-		/* How many times does the performance counter increment in 1/100th
-		millisecond. */
-		llTicksPerHundedthMillisecond = liPerformanceCounterFrequency.QuadPart / 100000LL;
-
-		/* What is the performance counter value now, this will be subtracted
-		from readings taken at run time. */
-		QueryPerformanceCounter( &liInitialRunTimeValue );
-		llInitialRunTimeCounterValue = liInitialRunTimeValue.QuadPart;
+	uint64_t ullRelogioInicio, ullRelogioFim, ullTscInicio, ullTscFim, ullEspera;
+
+		ullEspera = runtimeCALIBRACAO_NS * ullFrequenciaRelogio / runtimeNS_POR_SEGUNDO;
+
+		ullRelogioInicio = prvLerRelogio();
+		ullTscInicio = prvLerTsc();
+
+		do
+		{
+			ullRelogioFim = prvLerRelogio();
+		} while( ullRelogioFim - ullRelogioInicio < ullEspera );
+
+		ullTscFim = prvLerTsc();
+
+		return ( ullTscFim - ullTscInicio ) * ullFrequenciaRelogio / ( ullRelogioFim - ullRelogioInicio );
 	}
+
+#endif /* runtimeTEM_TSC */
+/*-----------------------------------------------------------*/
+
+/* ( ullUnidades * ullMultiplicador ) >> 32, modulo 2^64. */
+static uint64_t prvParaNanossegundos( uint64_t ullUnidades )
+{
+#if defined( __SIZEOF_INT128__ )
+	return ( uint64_t ) ( ( ( unsigned __int128 ) ullUnidades * ullMultiplicador ) >> runtimeDESLOCAMENTO );
+#else
+	uint64_t ullUnidadesAlto = ullUnidades >> 32, ullUnidadesBaixo = ullUnidades & 0xFFFFFFFFULL;
+	uint64_t ullMultAlto = ullMultiplicador >> 32, ullMultBaixo = ullMultiplicador & 0xFFFFFFFFULL;
+
+	return ( ( ullUnidadesAlto * ullMultAlto ) << 32 ) + ullUnidadesAlto * ullMultBaixo +
+		   ullUnidadesBaixo * ullMultAlto + ( ( ullUnidadesBaixo * ullMultBaixo ) >> 32 );
+#endif
 }
 /*-----------------------------------------------------------*/
 
-configRUN_TIME_COUNTER_TYPE ulGetRunTimeCounterValue( void )
+void vConfigureTimerForRunTimeStats( void )
 {
-LARGE_INTEGER liCurrentCount;
-configRUN_TIME_COUNTER_TYPE ulReturn;
+uint64_t ullFrequenciaRelogio, ullFrequencia;
+LerFonte_t pxLer;
+const char *pcNome;
+configRUN_TIME_COUNTER_TYPE ulInicio;
 
-	/* What is the performance counter value now? */
-	QueryPerformanceCounter( &liCurrentCount );
+	ullFrequenciaRelogio = prvFrequenciaRelogio();
+	if( ullFrequenciaRelogio == 0ULL )
+	{
+		/* Sem relogio o contador fica em zero, como antes. */
+		return;
+	}
+
+	pxLer = prvLerRelogio;
+	ullFrequencia = ullFrequenciaRelogio;
+	pcNome = runtimeNOME_RELOGIO;
 
-	/* Subtract the performance counter value reading taken when the
-	application started to get a count from that reference point, then
-	scale to (simulated) 1/100ths of a millisecond. */
-	if( llTicksPerHundedthMillisecond == 0 )
+	#if ( configFONTE_RUN_TIME == configRUN_TIME_TSC ) && ( runtimeTEM_TSC == 1 )
 	{
-		/* The trace macros are probably calling this function before the
-		scheduler has been started. */
-		ulReturn = 0;
+		if( prvTscInvariante() == pdTRUE )
+		{
+			pxLer = prvLerTsc;
+			ullFrequencia = prvCalibrarTsc( ullFrequenciaRelogio );
+			pcNome = "TSC";
+		}
 	}
-	else
+	#endif
+
+	/* 10^9 * 2^32 cabe em 64 bits (2^62): frequencias de 1 Hz para cima. */
+	ullMultiplicador = ( runtimeNS_POR_SEGUNDO << runtimeDESLOCAMENTO ) / ullFrequencia;
+	ullLeituraInicial = pxLer();
+	pxLerFonte = pxLer;
+
+	/* Custo medio de ulGetRunTimeCounterValue(), com a chamada. */
+	ulInicio = ulGetRunTimeCounterValue();
+	for( uint32_t ul = 0; ul < runtimeLEITURAS_CUSTO; ul++ )
 	{
-		ulReturn = ( configRUN_TIME_COUNTER_TYPE ) ( ( liCurrentCount.QuadPart - llInitialRunTimeCounterValue ) / llTicksPerHundedthMillisecond );
+		( void ) ulGetRunTimeCounterValue();
 	}
 
-	return ulReturn;
+	xFonte.pcNome = pcNome;
+	xFonte.ullFrequenciaHz = ullFrequencia;
+	xFonte.ulCustoLeituraNs = ( uint32_t ) ( ( ulGetRunTimeCounterValue() - ulInicio ) / runtimeLEITURAS_CUSTO );
+}
+/*-----------------------------------------------------------*/
+
+configRUN_TIME_COUNTER_TYPE ulGetRunTimeCounterValue( void )
+{
+	/* A diferenca sem sinal tolera a volta do contador da fonte. */
+	return ( configRUN_TIME_COUNTER_TYPE ) prvParaNanossegundos( pxLerFonte() - ullLeituraInicial );
+}
+/*-----------------------------------------------------------*/
+
+void RunTimeObterFonte( FonteRunTime_t *pxFonte )
+{
+	*pxFonte = xFonte;
 }
 /*-----------------------------------------------------------*/
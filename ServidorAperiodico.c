@@ -0,0 +1,409 @@
+/*
+ * Deferrable Server e Sporadic Server para tarefas aperiodicas.  Ver
+ * ServidorAperiodico.h.
+ *
+ * A contabilidade da capacidade e "liquidada" sempre que a tarefa do servidor
+ * sai de um trabalho e sempre que um temporizador precisa saber quanto ja foi
+ * consumido.  Os callbacks dos temporizadores rodam na tarefa de temporizadores,
+ * entao nesse momento a tarefa do servidor nao esta executando e o seu contador
+ * de run time esta atualizado.  Dentro da propria tarefa do servidor a leitura
+ * usa RunTimeTarefaAtual().
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "timers.h"
+
+/* Gateway includes. */
+#include "Gateway.h"
+#include "ServidorAperiodico.h"
+#include "PerfilTarefas.h"
+
+/* Unidades do contador de run time equivalentes a um tick. */
+#define servidorRUN_TIME_POR_TICK    ( ( int64_t ) ( gatewayRUN_TIME_POR_MS * portTICK_PERIOD_MS ) )
+
+static void prvServidorTask(void* pvParameters);
+static void prvOrcamentoEsgotado(TimerHandle_t xTemporizador);
+static void prvRecargaDeferrable(TimerHandle_t xTemporizador);
+static void prvRecargaEsporadica(TimerHandle_t xTemporizador);
+
+/*-----------------------------------------------------------*/
+
+static TickType_t prvParaTicks(int64_t llUnidades)
+{
+    /* Arredonda para cima e nunca retorna 0, que nao e um periodo valido. */
+    int64_t llTicks = (llUnidades + servidorRUN_TIME_POR_TICK - 1) / servidorRUN_TIME_POR_TICK;
+
+    return (llTicks < 1) ? 1 : (TickType_t)llTicks;
+}
+/*-----------------------------------------------------------*/
+
+/* Deve ser chamada em secao critica.  Desconta da capacidade o que a tarefa
+ * consumiu desde a ultima liquidacao, se ela ainda estiver na prioridade do
+ * servidor; o que roda depois do rebaixamento nao conta. */
+static void prvLiquidar(ServidorAperiodico_t* pxServidor, configRUN_TIME_COUNTER_TYPE ulContadorTarefa, BaseType_t xEmTrabalho)
+{
+    int64_t llUsado;
+
+    if (xEmTrabalho && !pxServidor->xRebaixado) {
+        llUsado = (int64_t)(ulContadorTarefa - pxServidor->ulInicioTrabalho);
+
+        if (llUsado > pxServidor->llOrcamento)
+            llUsado = pxServidor->llOrcamento;
+
+        pxServidor->llOrcamento -= llUsado;
+        pxServidor->llConsumoAtivo += llUsado;
+        pxServidor->xEstatisticas.ullConsumido += (uint64_t)llUsado;
+    }
+
+    pxServidor->ulInicioTrabalho = ulContadorTarefa;
+}
+/*-----------------------------------------------------------*/
+
+/* Deve ser chamada em secao critica.  Soma a recarga sem ultrapassar a
+ * capacidade e devolve a prioridade do servidor se ele estava rebaixado. */
+static void prvRecarregar(ServidorAperiodico_t* pxServidor, int64_t llQuantidade)
+{
+    pxServidor->llOrcamento += llQuantidade;
+
+    if (pxServidor->llOrcamento > pxServidor->llCapacidade)
+        pxServidor->llOrcamento = pxServidor->llCapacidade;
+
+    pxServidor->xEstatisticas.ulRecargas++;
+
+    if (pxServidor->xRebaixado && pxServidor->llOrcamento > 0) {
+        vTaskPrioritySet(pxServidor->xTarefa, pxServidor->xConfig.uxPrioridade);
+        pxServidor->xRebaixado = pdFALSE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t ServidorCriar(ServidorAperiodico_t* pxServidor, const ConfigServidor_t* pxConfig)
+{
+    TimerCallbackFunction_t pxRecarga;
+    UBaseType_t uxRecarregaAutomatico;
+
+    memset(pxServidor, 0, sizeof(*pxServidor));
+    pxServidor->xConfig = *pxConfig;
+    pxServidor->llCapacidade = (int64_t)pxConfig->xCapacidade * servidorRUN_TIME_POR_TICK;
+    pxServidor->llOrcamento = pxServidor->llCapacidade;
+    pxServidor->xEstatisticas.ullRespostaMin = UINT64_MAX;
+
+    configASSERT(pxConfig->xCapacidade > 0 && pxConfig->xCapacidade <= pxConfig->xPeriodo);
+    configASSERT(pxConfig->uxTamanhoFila > 0 && pxConfig->uxTamanhoFila <= servidorMAX_FILA);
+
+    if (pxConfig->ePolitica == SERVIDOR_DEFERRABLE) {
+        pxRecarga = prvRecargaDeferrable;
+        uxRecarregaAutomatico = pdTRUE;
+    }
+    else {
+        pxRecarga = prvRecargaEsporadica;
+        uxRecarregaAutomatico = pdFALSE;
+    }
+
+    pxServidor->xFila = xQueueCreateStatic(pxConfig->uxTamanhoFila, sizeof(PedidoServidor_t),
+                                           pxServidor->ucArmazenamentoFila, &pxServidor->xFilaEstatica);
+    pxServidor->xTemporizadorRecarga = xTimerCreateStatic(pxConfig->pcNome, pxConfig->xPeriodo, uxRecarregaAutomatico,
+                                                          pxServidor, pxRecarga, &pxServidor->xTemporizadorRecargaEstatico);
+    pxServidor->xTemporizadorOrcamento = xTimerCreateStatic(pxConfig->pcNome, pxConfig->xCapacidade, pdFALSE,
+                                                            pxServidor, prvOrcamentoEsgotado, &pxServidor->xTemporizadorOrcamentoEstatico);
+    pxServidor->xTarefa = xTaskCreateStatic(prvServidorTask, pxConfig->pcNome, servidorTAMANHO_PILHA, pxServidor,
+                                            pxConfig->uxPrioridade, pxServidor->uxPilha, &pxServidor->xTCB);
+
+    if (pxServidor->xFila == NULL || pxServidor->xTemporizadorRecarga == NULL ||
+        pxServidor->xTemporizadorOrcamento == NULL || pxServidor->xTarefa == NULL)
+        return pdFAIL;
+
+    /* O deferrable recarrega a cada periodo; o esporadico so agenda recargas
+     * depois de consumir capacidade. */
+    if (pxConfig->ePolitica == SERVIDOR_DEFERRABLE)
+        xTimerStart(pxServidor->xTemporizadorRecarga, 0);
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t ServidorSubmeter(ServidorAperiodico_t* pxServidor, TrabalhoAperiodico_t pxTrabalho, void* pvParametro)
+{
+    PedidoServidor_t xPedido;
+
+    xPedido.pxTrabalho = pxTrabalho;
+    xPedido.pvParametro = pvParametro;
+    xPedido.ulChegada = ulGetRunTimeCounterValue();
+
+    /* Os contadores sao lidos por ServidorObterEstatisticas() em outra
+     * tarefa e podem ser atualizados por mais de um submissor. */
+    taskENTER_CRITICAL();
+    {
+        pxServidor->xEstatisticas.ulSubmetidos++;
+    }
+    taskEXIT_CRITICAL();
+
+    if (xQueueSend(pxServidor->xFila, &xPedido, 0) != pdPASS) {
+        taskENTER_CRITICAL();
+        {
+            pxServidor->xEstatisticas.ulRejeitados++;
+        }
+        taskEXIT_CRITICAL();
+
+        return pdFAIL;
+    }
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void ServidorObterEstatisticas(ServidorAperiodico_t* pxServidor, EstatisticaServidor_t* pxEstatisticas)
+{
+    taskENTER_CRITICAL();
+    {
+        *pxEstatisticas = pxServidor->xEstatisticas;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+/* xBloqueio e 0 nos callbacks: a tarefa de temporizadores nao pode esperar
+ * pela propria fila de comandos. */
+static void prvAgendarRecarga(ServidorAperiodico_t* pxServidor, TickType_t xInstante, int64_t llQuantidade, TickType_t xBloqueio)
+{
+    BaseType_t xPrimeira = pdFALSE;
+
+    taskENTER_CRITICAL();
+    {
+        if (pxServidor->uxNumRecargas < servidorMAX_RECARGAS) {
+            UBaseType_t uxPosicao = (pxServidor->uxPrimeiraRecarga + pxServidor->uxNumRecargas) % servidorMAX_RECARGAS;
+
+            pxServidor->xRecargas[uxPosicao].xInstante = xInstante;
+            pxServidor->xRecargas[uxPosicao].llQuantidade = llQuantidade;
+            pxServidor->uxNumRecargas++;
+            xPrimeira = (pxServidor->uxNumRecargas == 1);
+        }
+        else {
+            /* Sem espaco: junta com a ultima recarga no instante da nova, o que
+             * so atrasa a devolucao e mantem o limite de interferencia. */
+            UBaseType_t uxUltima = (pxServidor->uxPrimeiraRecarga + pxServidor->uxNumRecargas - 1) % servidorMAX_RECARGAS;
+
+            pxServidor->xRecargas[uxUltima].xInstante = xInstante;
+            pxServidor->xRecargas[uxUltima].llQuantidade += llQuantidade;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (xPrimeira) {
+        int32_t lEspera = (int32_t)(xInstante - xTaskGetTickCount());
+
+        /* Instantes ja vencidos recarregam no proximo tick. */
+        if (lEspera < 1)
+            lEspera = 1;
+
+        xTimerChangePeriod(pxServidor->xTemporizadorRecarga, (TickType_t)lEspera, xBloqueio);
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvServidorTask(void* pvParameters)
+{
+    ServidorAperiodico_t* pxServidor = (ServidorAperiodico_t*)pvParameters;
+    PedidoServidor_t xPedido;
+    int64_t llDisponivel;
+    configRUN_TIME_COUNTER_TYPE ulResposta;
+    BaseType_t xFimAtivo;
+    TickType_t xInicioAtivo;
+    int64_t llConsumoAtivo;
+
+    for (;;) {
+        xQueueReceive(pxServidor->xFila, &xPedido, portMAX_DELAY);
+
+        /* Sem capacidade o trabalho espera a proxima recarga, que notifica a
+         * tarefa. */
+        for (;;) {
+            taskENTER_CRITICAL();
+            llDisponivel = pxServidor->llOrcamento;
+            taskEXIT_CRITICAL();
+
+            if (llDisponivel > 0)
+                break;
+
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+
+        if (pxServidor->xConfig.ePolitica == SERVIDOR_ESPORADICO && !pxServidor->xAtivo) {
+            pxServidor->xAtivo = pdTRUE;
+            pxServidor->xInicioAtivo = xTaskGetTickCount();
+            pxServidor->llConsumoAtivo = 0;
+        }
+
+        taskENTER_CRITICAL();
+        {
+            pxServidor->ulInicioTrabalho = RunTimeTarefaAtual();
+            pxServidor->xEmTrabalho = pdTRUE;
+            llDisponivel = pxServidor->llOrcamento;
+        }
+        taskEXIT_CRITICAL();
+
+        xTimerChangePeriod(pxServidor->xTemporizadorOrcamento, prvParaTicks(llDisponivel), portMAX_DELAY);
+
+        PerfilInicioAtivacao();
+        xPedido.pxTrabalho(xPedido.pvParametro);
+        PerfilFimAtivacao();
+
+        xTimerStop(pxServidor->xTemporizadorOrcamento, portMAX_DELAY);
+
+        taskENTER_CRITICAL();
+        {
+            prvLiquidar(pxServidor, RunTimeTarefaAtual(), pdTRUE);
+            pxServidor->xEmTrabalho = pdFALSE;
+
+            ulResposta = ulGetRunTimeCounterValue() - xPedido.ulChegada;
+            pxServidor->xEstatisticas.ulAtendidos++;
+            pxServidor->xEstatisticas.ullRespostaTotal += ulResposta;
+            if (ulResposta < pxServidor->xEstatisticas.ullRespostaMin)
+                pxServidor->xEstatisticas.ullRespostaMin = ulResposta;
+            if (ulResposta > pxServidor->xEstatisticas.ullRespostaMax)
+                pxServidor->xEstatisticas.ullRespostaMax = ulResposta;
+
+            /* O periodo ativo do esporadico termina aqui quando a fila
+             * esvazia, ou quando a capacidade acabou junto com o trabalho,
+             * antes de o temporizador do orcamento disparar.  O esgotamento no
+             * meio do trabalho e tratado em prvOrcamentoEsgotado(). */
+            xFimAtivo = pxServidor->xAtivo &&
+                        (uxQueueMessagesWaiting(pxServidor->xFila) == 0 || pxServidor->llOrcamento <= 0);
+            xInicioAtivo = pxServidor->xInicioAtivo;
+            llConsumoAtivo = pxServidor->llConsumoAtivo;
+
+            if (xFimAtivo)
+                pxServidor->xAtivo = pdFALSE;
+        }
+        taskEXIT_CRITICAL();
+
+        if (xFimAtivo && llConsumoAtivo > 0)
+            prvAgendarRecarga(pxServidor, xInicioAtivo + pxServidor->xConfig.xPeriodo, llConsumoAtivo, portMAX_DELAY);
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvOrcamentoEsgotado(TimerHandle_t xTemporizador)
+{
+    ServidorAperiodico_t* pxServidor = (ServidorAperiodico_t*)pvTimerGetTimerID(xTemporizador);
+    int64_t llRestante = 0;
+    BaseType_t xFimAtivo = pdFALSE;
+    TickType_t xInicioAtivo = 0;
+    int64_t llConsumoAtivo = 0;
+
+    taskENTER_CRITICAL();
+    {
+        if (pxServidor->xEmTrabalho && !pxServidor->xRebaixado) {
+            prvLiquidar(pxServidor, ulTaskGetRunTimeCounter(pxServidor->xTarefa), pdTRUE);
+
+            if (pxServidor->llOrcamento <= 0) {
+                /* Capacidade esgotada: o restante do trabalho roda em segundo
+                 * plano ate a proxima recarga. */
+                vTaskPrioritySet(pxServidor->xTarefa, tskIDLE_PRIORITY);
+                pxServidor->xRebaixado = pdTRUE;
+                pxServidor->xEstatisticas.ulEsgotamentos++;
+
+                /* O periodo ativo do esporadico termina aqui e a recarga do
+                 * que ele consumiu e agendada ja, senao o trabalho ficaria na
+                 * prioridade ociosa sem recarga a caminho. */
+                if (pxServidor->xAtivo) {
+                    pxServidor->xAtivo = pdFALSE;
+                    xFimAtivo = pdTRUE;
+                    xInicioAtivo = pxServidor->xInicioAtivo;
+                    llConsumoAtivo = pxServidor->llConsumoAtivo;
+                }
+            }
+            else {
+                /* O servidor foi preemptado e ainda tem capacidade. */
+                llRestante = pxServidor->llOrcamento;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (xFimAtivo && llConsumoAtivo > 0)
+        prvAgendarRecarga(pxServidor, xInicioAtivo + pxServidor->xConfig.xPeriodo, llConsumoAtivo, 0);
+
+    if (llRestante > 0)
+        xTimerChangePeriod(xTemporizador, prvParaTicks(llRestante), 0);
+}
+/*-----------------------------------------------------------*/
+
+/* Comum as duas politicas: aplica a recarga e, se um trabalho estava em
+ * andamento, reinicia a contagem da capacidade a partir de agora.  No
+ * esporadico o trabalho interrompido pelo esgotamento abre um novo periodo
+ * ativo neste instante. */
+static void prvAplicarRecarga(ServidorAperiodico_t* pxServidor, int64_t llQuantidade)
+{
+    int64_t llDisponivel = 0;
+
+    taskENTER_CRITICAL();
+    {
+        prvLiquidar(pxServidor, ulTaskGetRunTimeCounter(pxServidor->xTarefa), pxServidor->xEmTrabalho);
+        prvRecarregar(pxServidor, llQuantidade);
+
+        if (pxServidor->xEmTrabalho) {
+            llDisponivel = pxServidor->llOrcamento;
+
+            if (pxServidor->xConfig.ePolitica == SERVIDOR_ESPORADICO && !pxServidor->xAtivo && llDisponivel > 0) {
+                pxServidor->xAtivo = pdTRUE;
+                pxServidor->xInicioAtivo = xTaskGetTickCount();
+                pxServidor->llConsumoAtivo = 0;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (llDisponivel > 0)
+        xTimerChangePeriod(pxServidor->xTemporizadorOrcamento, prvParaTicks(llDisponivel), 0);
+
+    xTaskNotifyGive(pxServidor->xTarefa);
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecargaDeferrable(TimerHandle_t xTemporizador)
+{
+    ServidorAperiodico_t* pxServidor = (ServidorAperiodico_t*)pvTimerGetTimerID(xTemporizador);
+
+    prvAplicarRecarga(pxServidor, pxServidor->llCapacidade);
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecargaEsporadica(TimerHandle_t xTemporizador)
+{
+    ServidorAperiodico_t* pxServidor = (ServidorAperiodico_t*)pvTimerGetTimerID(xTemporizador);
+    TickType_t xAgora = xTaskGetTickCount();
+    TickType_t xProxima = 0;
+    int64_t llQuantidade = 0;
+
+    taskENTER_CRITICAL();
+    {
+        /* Aplica todas as recargas vencidas. */
+        while (pxServidor->uxNumRecargas > 0) {
+            RecargaServidor_t* pxRecarga = &pxServidor->xRecargas[pxServidor->uxPrimeiraRecarga];
+
+            if ((int32_t)(pxRecarga->xInstante - xAgora) > 0) {
+                /* Ainda no futuro. */
+                xProxima = (TickType_t)(pxRecarga->xInstante - xAgora);
+                break;
+            }
+
+            llQuantidade += pxRecarga->llQuantidade;
+            pxServidor->uxPrimeiraRecarga = (pxServidor->uxPrimeiraRecarga + 1) % servidorMAX_RECARGAS;
+            pxServidor->uxNumRecargas--;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (llQuantidade > 0)
+        prvAplicarRecarga(pxServidor, llQuantidade);
+
+    if (xProxima > 0)
+        xTimerChangePeriod(xTemporizador, xProxima, 0);
+}
+/*-----------------------------------------------------------*/
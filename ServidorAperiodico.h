@@ -0,0 +1,129 @@
+#ifndef SERVIDOR_APERIODICO_H
+#define SERVIDOR_APERIODICO_H
+
+/*
+ * Servidor para tarefas aperiodicas com reserva de banda.
+ *
+ * Cada servidor tem uma capacidade (tempo de CPU), um periodo de recarga e uma
+ * prioridade.  Os trabalhos submetidos entram numa fila e sao executados pela
+ * tarefa do servidor, na prioridade do servidor, enquanto houver capacidade.
+ * Quando a capacidade acaba no meio de um trabalho a tarefa cai para a
+ * prioridade ociosa e so volta a prioridade do servidor na proxima recarga, o
+ * que limita a interferencia nas tarefas periodicas dos sensores a capacidade
+ * por periodo.
+ *
+ * Regras de recarga:
+ * - SERVIDOR_DEFERRABLE: a capacidade volta ao valor cheio a cada periodo,
+ *   mesmo que nao tenha sido usada.
+ * - SERVIDOR_ESPORADICO: o que foi consumido a partir do instante em que o
+ *   servidor ficou ativo e devolvido um periodo depois desse instante.  O
+ *   periodo ativo termina quando a fila esvazia ou quando a capacidade acaba;
+ *   no segundo caso o trabalho interrompido abre outro periodo ativo quando a
+ *   recarga chega.
+ *
+ * O consumo e medido com o contador de run time da propria tarefa do servidor,
+ * entao o tempo em que ela foi preemptada nao e descontado da capacidade.
+ *
+ * A tarefa, a fila e os temporizadores usam memoria do proprio
+ * ServidorAperiodico_t (variantes Static da API), entao criar um servidor e
+ * submeter trabalhos nunca aloca do heap.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "timers.h"
+
+/* Recargas pendentes guardadas por um servidor esporadico. */
+#define servidorMAX_RECARGAS       8
+
+/* Limites da memoria reservada em cada servidor. */
+#define servidorMAX_FILA           8
+#define servidorTAMANHO_PILHA      configMINIMAL_STACK_SIZE
+
+typedef enum {
+    SERVIDOR_DEFERRABLE = 0,
+    SERVIDOR_ESPORADICO
+} PoliticaServidor_t;
+
+typedef void (*TrabalhoAperiodico_t)(void* pvParametro);
+
+typedef struct {
+    const char* pcNome;
+    PoliticaServidor_t ePolitica;
+    TickType_t xCapacidade;         /* Em ticks de CPU */
+    TickType_t xPeriodo;            /* Periodo de recarga, em ticks */
+    UBaseType_t uxPrioridade;
+    UBaseType_t uxTamanhoFila;      /* Trabalhos aguardando capacidade, ate servidorMAX_FILA */
+} ConfigServidor_t;
+
+/* Tempos em unidades do contador de run time. */
+typedef struct {
+    uint32_t ulSubmetidos;
+    uint32_t ulAtendidos;
+    uint32_t ulRejeitados;          /* Fila cheia */
+    uint32_t ulEsgotamentos;        /* Capacidade acabou no meio de um trabalho */
+    uint32_t ulRecargas;
+    uint64_t ullConsumido;          /* Capacidade usada na prioridade do servidor */
+    uint64_t ullRespostaTotal;
+    uint64_t ullRespostaMin;
+    uint64_t ullRespostaMax;
+} EstatisticaServidor_t;
+
+typedef struct {
+    TickType_t xInstante;
+    int64_t llQuantidade;
+} RecargaServidor_t;
+
+typedef struct {
+    TrabalhoAperiodico_t pxTrabalho;
+    void* pvParametro;
+    configRUN_TIME_COUNTER_TYPE ulChegada;
+} PedidoServidor_t;
+
+typedef struct {
+    ConfigServidor_t xConfig;
+    QueueHandle_t xFila;
+    TaskHandle_t xTarefa;
+    TimerHandle_t xTemporizadorRecarga;
+    TimerHandle_t xTemporizadorOrcamento;
+
+    /* Capacidade restante, em unidades do contador de run time.  Alterada
+     * pela tarefa do servidor e pelos callbacks dos temporizadores, sempre
+     * dentro de secao critica. */
+    int64_t llOrcamento;
+    int64_t llCapacidade;
+    BaseType_t xRebaixado;
+    BaseType_t xEmTrabalho;
+    configRUN_TIME_COUNTER_TYPE ulInicioTrabalho;   /* Base da ultima liquidacao */
+
+    /* Servidor esporadico: periodo ativo corrente e recargas agendadas, em
+     * ordem de instante. */
+    BaseType_t xAtivo;
+    TickType_t xInicioAtivo;
+    int64_t llConsumoAtivo;
+    RecargaServidor_t xRecargas[servidorMAX_RECARGAS];
+    UBaseType_t uxPrimeiraRecarga;
+    UBaseType_t uxNumRecargas;
+
+    EstatisticaServidor_t xEstatisticas;
+
+    /* Memoria estatica da tarefa, da fila e dos temporizadores. */
+    StaticTask_t xTCB;
+    StackType_t uxPilha[servidorTAMANHO_PILHA];
+    StaticQueue_t xFilaEstatica;
+    uint8_t ucArmazenamentoFila[servidorMAX_FILA * sizeof(PedidoServidor_t)];
+    StaticTimer_t xTemporizadorRecargaEstatico;
+    StaticTimer_t xTemporizadorOrcamentoEstatico;
+} ServidorAperiodico_t;
+
+/* Cria a fila, a tarefa e os temporizadores do servidor.  Retorna pdFAIL se
+ * algum deles nao puder ser criado. */
+BaseType_t ServidorCriar(ServidorAperiodico_t* pxServidor, const ConfigServidor_t* pxConfig);
+
+/* Nao bloqueia.  Retorna pdFAIL se a fila do servidor estiver cheia. */
+BaseType_t ServidorSubmeter(ServidorAperiodico_t* pxServidor, TrabalhoAperiodico_t pxTrabalho, void* pvParametro);
+
+void ServidorObterEstatisticas(ServidorAperiodico_t* pxServidor, EstatisticaServidor_t* pxEstatisticas);
+
+#endif /* SERVIDOR_APERIODICO_H */
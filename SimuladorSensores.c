@@ -0,0 +1,174 @@
+/*
+ * Simulacao das leituras dos sensores.  Ver SimuladorSensores.h.
+ *
+ * Gerador PCG32 (XSH RR): estado de 64 bits avancado por congruencia linear,
+ * saida de 32 bits por xorshift e rotacao.  O incremento (impar) separa os
+ * fluxos; o indice do sensor entra no incremento, entao os fluxos de uma
+ * mesma semente sao independentes.
+ */
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+
+#include "SimuladorSensores.h"
+
+#define simMULTIPLICADOR            6364136223846793005ULL
+
+/* Faixas de cada leitura; os limites de defeito sao os dos modulos sensores. */
+#define simTENSAO_QUEDA_MAX         199
+#define simTENSAO_NOMINAL_MIN       200
+#define simTENSAO_NOMINAL_MAX       220
+#define simTENSAO_SOBRE_MIN         221
+#define simTENSAO_SOBRE_MAX         260
+#define simPARTICULAS_NORMAL_MIN    3000
+#define simPARTICULAS_NORMAL_MAX    4499
+#define simPARTICULAS_ALTA_MIN      4501
+#define simPARTICULAS_ALTA_MAX      6000
+
+const CenarioSimulacao_t xCenarioPadrao = {
+    "padrao",
+    182, 182,
+    25, 2,
+    { { 91, 91 }, { 109, 109 } },
+    91,
+    91
+};
+
+const CenarioSimulacao_t xCenarioEstavel = {
+    "estavel",
+    100, 100,
+    22, 1,
+    { { 5, 5 }, { 5, 5 } },
+    5,
+    2
+};
+
+const CenarioSimulacao_t xCenarioDegradado = {
+    "degradado",
+    182, 182,
+    28, 4,
+    { { 250, 100 }, { 300, 100 } },
+    300,
+    200
+};
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvProximo(FluxoAleatorio_t* pxFluxo)
+{
+    uint64_t ullAnterior = pxFluxo->ullEstado;
+    uint32_t ulMistura, ulRotacao;
+
+    pxFluxo->ullEstado = ullAnterior * simMULTIPLICADOR + pxFluxo->ullIncremento;
+
+    ulMistura = (uint32_t)(((ullAnterior >> 18) ^ ullAnterior) >> 27);
+    ulRotacao = (uint32_t)(ullAnterior >> 59);
+
+    return (ulMistura >> ulRotacao) | (ulMistura << ((0U - ulRotacao) & 31));
+}
+/*-----------------------------------------------------------*/
+
+/* Uniforme em [0, ulFaixa).  O vies da multiplicacao e desprezivel para as
+ * faixas pequenas usadas aqui. */
+static uint32_t prvUniforme(FluxoAleatorio_t* pxFluxo, uint32_t ulFaixa)
+{
+    return (uint32_t)(((uint64_t)prvProximo(pxFluxo) * ulFaixa) >> 32);
+}
+/*-----------------------------------------------------------*/
+
+/* Uniforme em [lMin, lMax]. */
+static int32_t prvEntre(FluxoAleatorio_t* pxFluxo, int32_t lMin, int32_t lMax)
+{
+    return lMin + (int32_t)prvUniforme(pxFluxo, (uint32_t)(lMax - lMin + 1));
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvPorMil(FluxoAleatorio_t* pxFluxo, uint16_t usPorMil)
+{
+    return prvUniforme(pxFluxo, 1000) < usPorMil;
+}
+/*-----------------------------------------------------------*/
+
+void SimuladorInicializar(SimuladorSensores_t* pxSimulador, uint64_t ullSemente, const CenarioSimulacao_t* pxCenario)
+{
+    UBaseType_t uxSensor;
+
+    configASSERT(pxCenario != NULL);
+
+    pxSimulador->pxCenario = pxCenario;
+    pxSimulador->ullSemente = ullSemente;
+
+    /* Inicializacao de referencia do PCG32. */
+    for (uxSensor = 0; uxSensor < NUM_SENSORES; uxSensor++) {
+        FluxoAleatorio_t* pxFluxo = &pxSimulador->xFluxos[uxSensor];
+
+        pxFluxo->ullEstado = 0;
+        pxFluxo->ullIncremento = ((uint64_t)uxSensor << 1) | 1;
+        (void)prvProximo(pxFluxo);
+        pxFluxo->ullEstado += ullSemente;
+        (void)prvProximo(pxFluxo);
+    }
+}
+/*-----------------------------------------------------------*/
+
+int32_t SimularFluxo(SimuladorSensores_t* pxSimulador, int32_t lOcupantes)
+{
+    const CenarioSimulacao_t* pxCenario = pxSimulador->pxCenario;
+    uint32_t ulSorteio = prvUniforme(&pxSimulador->xFluxos[SENSOR_PRESENCA], 1000);
+
+    if (ulSorteio < pxCenario->usEntradaPorMil)
+        return 1;
+
+    if (ulSorteio < (uint32_t)pxCenario->usEntradaPorMil + pxCenario->usSaidaPorMil && lOcupantes > 0)
+        return -1;
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+int32_t SimularTemperatura(SimuladorSensores_t* pxSimulador)
+{
+    const CenarioSimulacao_t* pxCenario = pxSimulador->pxCenario;
+
+    return prvEntre(&pxSimulador->xFluxos[SENSOR_TEMPERATURA],
+                    pxCenario->lTemperaturaBase - pxCenario->lVariacaoMax,
+                    pxCenario->lTemperaturaBase + pxCenario->lVariacaoMax);
+}
+/*-----------------------------------------------------------*/
+
+int32_t SimularTensao(SimuladorSensores_t* pxSimulador, CanalTensao_t eCanal)
+{
+    const PerfilTensao_t* pxPerfil = &pxSimulador->pxCenario->xTensao[eCanal];
+    FluxoAleatorio_t* pxFluxo = &pxSimulador->xFluxos[SENSOR_TENSAO];
+    uint32_t ulSorteio;
+
+    configASSERT(eCanal < NUM_CANAIS_TENSAO);
+
+    ulSorteio = prvUniforme(pxFluxo, 1000);
+
+    if (ulSorteio < pxPerfil->usQuedaPorMil)
+        return prvEntre(pxFluxo, 0, simTENSAO_QUEDA_MAX);
+
+    if (ulSorteio < (uint32_t)pxPerfil->usQuedaPorMil + pxPerfil->usSobretensaoPorMil)
+        return prvEntre(pxFluxo, simTENSAO_SOBRE_MIN, simTENSAO_SOBRE_MAX);
+
+    return prvEntre(pxFluxo, simTENSAO_NOMINAL_MIN, simTENSAO_NOMINAL_MAX);
+}
+/*-----------------------------------------------------------*/
+
+int32_t SimularParticulas(SimuladorSensores_t* pxSimulador)
+{
+    FluxoAleatorio_t* pxFluxo = &pxSimulador->xFluxos[SENSOR_PARTICULAS];
+
+    if (prvPorMil(pxFluxo, pxSimulador->pxCenario->usParticulasAltasPorMil))
+        return prvEntre(pxFluxo, simPARTICULAS_ALTA_MIN, simPARTICULAS_ALTA_MAX);
+
+    return prvEntre(pxFluxo, simPARTICULAS_NORMAL_MIN, simPARTICULAS_NORMAL_MAX);
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t SimularGas(SimuladorSensores_t* pxSimulador)
+{
+    return prvPorMil(&pxSimulador->xFluxos[SENSOR_GAS], pxSimulador->pxCenario->usGasPorMil);
+}
+/*-----------------------------------------------------------*/
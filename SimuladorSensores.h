@@ -0,0 +1,84 @@
+#ifndef SIMULADOR_SENSORES_H
+#define SIMULADOR_SENSORES_H
+
+/*
+ * Simulacao das leituras dos sensores com gerador pseudoaleatorio proprio.
+ *
+ * Cada sensor tem o seu fluxo PCG32 (64 bits de estado), derivado da semente
+ * do simulador e do indice do sensor, entao a sequencia de valores de cada
+ * sensor depende so da semente e do cenario: a mesma semente repete os mesmos
+ * valores, bit a bit, em qualquer execucao.  Cada fluxo so pode ser usado por
+ * uma tarefa (o gerador do sensor), o que dispensa qualquer trava.
+ *
+ * As distribuicoes vem de um CenarioSimulacao_t.  As probabilidades sao em
+ * eventos por mil amostras e os sorteios em faixa usam multiplicacao e
+ * deslocamento em vez de divisao, entao uma amostra custa poucos
+ * nanossegundos e nenhuma chamada ao sistema.
+ */
+
+#include "FreeRTOS.h"
+
+#include "Gateway.h"
+
+typedef enum {
+    TENSAO_VENTOINHA = 0,
+    TENSAO_COMPRESSOR,
+    NUM_CANAIS_TENSAO
+} CanalTensao_t;
+
+typedef struct {
+    uint16_t usQuedaPorMil;         /* Abaixo de 200V: defeito */
+    uint16_t usSobretensaoPorMil;   /* De 221V a 260V */
+} PerfilTensao_t;                   /* No resto, de 200V a 220V */
+
+typedef struct {
+    const char* pcNome;
+
+    /* Pessoas: cada amostra tem uma entrada, uma saida (se houver alguem) ou
+     * nenhuma mudanca. */
+    uint16_t usEntradaPorMil;
+    uint16_t usSaidaPorMil;
+
+    /* Temperatura uniforme em lTemperaturaBase +- lVariacaoMax graus. */
+    int32_t lTemperaturaBase;
+    int32_t lVariacaoMax;
+
+    PerfilTensao_t xTensao[NUM_CANAIS_TENSAO];
+
+    /* Particulas acima de 4500 (falha da autolimpeza); no resto, de 3000 a
+     * 4499. */
+    uint16_t usParticulasAltasPorMil;
+
+    uint16_t usGasPorMil;
+} CenarioSimulacao_t;
+
+/* Distribuicoes usadas antes com rand() (padrao), poucas falhas (estavel) e
+ * falhas frequentes com temperatura alta (degradado). */
+extern const CenarioSimulacao_t xCenarioPadrao;
+extern const CenarioSimulacao_t xCenarioEstavel;
+extern const CenarioSimulacao_t xCenarioDegradado;
+
+typedef struct {
+    uint64_t ullEstado;
+    uint64_t ullIncremento;
+} FluxoAleatorio_t;
+
+typedef struct {
+    const CenarioSimulacao_t* pxCenario;
+    uint64_t ullSemente;
+    FluxoAleatorio_t xFluxos[NUM_SENSORES];
+} SimuladorSensores_t;
+
+void SimuladorInicializar(SimuladorSensores_t* pxSimulador, uint64_t ullSemente, const CenarioSimulacao_t* pxCenario);
+
+/* Cada funcao usa apenas o fluxo do seu sensor. */
+
+/* Retorna +1, -1 ou 0; so ha saida com lOcupantes > 0. */
+int32_t SimularFluxo(SimuladorSensores_t* pxSimulador, int32_t lOcupantes);
+int32_t SimularTemperatura(SimuladorSensores_t* pxSimulador);
+/* Os dois canais vem do fluxo do sensor de tensao. */
+int32_t SimularTensao(SimuladorSensores_t* pxSimulador, CanalTensao_t eCanal);
+int32_t SimularParticulas(SimuladorSensores_t* pxSimulador);
+BaseType_t SimularGas(SimuladorSensores_t* pxSimulador);
+
+#endif /* SIMULADOR_SENSORES_H */
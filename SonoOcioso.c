@@ -0,0 +1,121 @@
+/*
+ * Sono ocioso sem tick para o simulador Win32.  Ver SonoOcioso.h.
+ */
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "Gateway.h"
+#include "SonoOcioso.h"
+
+#if ( configSONO_OCIOSO == 1 )
+
+#define sonoNS_POR_TICK     ( gatewayRUN_TIME_POR_MS * portTICK_PERIOD_MS )
+
+static HANDLE pvAcordar;
+static volatile BaseType_t xHabilitado = pdTRUE;
+
+/* Fracao de tick dormida e ainda nao passada ao contador de ticks. */
+static configRUN_TIME_COUNTER_TYPE ulRestoNs;
+
+static EstatisticaSonoOcioso_t xEstatisticas;
+
+/*-----------------------------------------------------------*/
+
+void SonoOciosoIniciar(void)
+{
+    /* Reinicia sozinho ao liberar a espera. */
+    pvAcordar = CreateEvent(NULL, FALSE, FALSE, NULL);
+    configASSERT(pvAcordar != NULL);
+}
+/*-----------------------------------------------------------*/
+
+void SonoOciosoHabilitar(BaseType_t xHabilitar)
+{
+    xHabilitado = xHabilitar;
+}
+/*-----------------------------------------------------------*/
+
+void SonoOciosoDormir(uint32_t ulTicksOciosos)
+{
+    configRUN_TIME_COUNTER_TYPE ulInicio, ulDormido;
+    TickType_t xTicksDormidos;
+    DWORD ulEspera;
+
+    /* Desligado: a tarefa ociosa continua girando, com tick. */
+    if (xHabilitado == pdFALSE)
+        return;
+
+    /* Segura o mutex das interrupcoes simuladas ate o fim do sono. */
+    taskENTER_CRITICAL();
+    {
+        if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+            /* Uma interrupcao liberou uma tarefa depois que a ociosa decidiu
+             * dormir. */
+            xEstatisticas.ulSonosAbortados++;
+        }
+        else {
+            /* Sem tarefa esperando por tempo so uma interrupcao acorda. */
+            if ((TickType_t)ulTicksOciosos == portMAX_DELAY)
+                ulEspera = INFINITE;
+            else
+                ulEspera = (DWORD)(ulTicksOciosos * portTICK_PERIOD_MS);
+
+            ulInicio = ulGetRunTimeCounterValue();
+            if (WaitForSingleObject(pvAcordar, ulEspera) == WAIT_OBJECT_0)
+                xEstatisticas.ulSonosInterrompidos++;
+            xEstatisticas.ulRetornosEspera++;
+            ulDormido = ulGetRunTimeCounterValue() - ulInicio;
+
+            /* O Windows pode acordar depois do pedido: o contador de ticks
+             * nao passa do proximo desbloqueio, e o atraso fica por conta do
+             * tick seguinte. */
+            xTicksDormidos = (TickType_t)((ulDormido + ulRestoNs) / sonoNS_POR_TICK);
+            if (xTicksDormidos >= (TickType_t)ulTicksOciosos) {
+                xTicksDormidos = (TickType_t)ulTicksOciosos;
+                ulRestoNs = 0;
+            }
+            else
+                ulRestoNs = ulDormido + ulRestoNs - (configRUN_TIME_COUNTER_TYPE)xTicksDormidos * sonoNS_POR_TICK;
+
+            /* A thread do tick venceu durante o sono e esta parada no mutex:
+             * entrega um tick logo depois de taskEXIT_CRITICAL(), e ele e o
+             * ultimo dos dormidos.  Num sono de menos de um tick o que ela
+             * entregar e o tick normal, e o tempo fica no resto. */
+            if (xTicksDormidos > 1)
+                vTaskStepTick(xTicksDormidos - 1);
+
+            xEstatisticas.ulSonos++;
+            xEstatisticas.ullTicksCorrigidos += xTicksDormidos > 1 ? xTicksDormidos - 1 : 0;
+            xEstatisticas.ullNsDormidos += ulDormido;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void SonoOciosoTick(void)
+{
+    xEstatisticas.ullTicksTratados++;
+}
+/*-----------------------------------------------------------*/
+
+void SonoOciosoAcordar(void)
+{
+    if (pvAcordar != NULL)
+        SetEvent(pvAcordar);
+}
+/*-----------------------------------------------------------*/
+
+void SonoOciosoObterEstatisticas(EstatisticaSonoOcioso_t* pxEstatisticas)
+{
+    taskENTER_CRITICAL();
+    {
+        *pxEstatisticas = xEstatisticas;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configSONO_OCIOSO */
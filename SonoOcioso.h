@@ -0,0 +1,71 @@
+#ifndef SONO_OCIOSO_H
+#define SONO_OCIOSO_H
+
+/*
+ * Sono ocioso sem tick para o simulador Win32, ligado por configSONO_OCIOSO em
+ * FreeRTOSConfig.h.
+ *
+ * Quando todas as tarefas estao bloqueadas a tarefa ociosa, em vez de girar
+ * recebendo um tick por milissegundo, dorme numa espera do Windows ate o
+ * proximo desbloqueio (supressao de ticks, configUSE_TICKLESS_IDLE 2).  Ao
+ * acordar o contador de ticks e corrigido com vTaskStepTick() pelo tempo
+ * realmente dormido, medido com o contador de run time, menos o tick que a
+ * thread do tick entrega ao fim do sono; a fracao de tick que sobra passa
+ * para o proximo sono.
+ *
+ * O port gera o tick numa thread do Windows que nao pode ser parada.  A espera
+ * e feita dentro de uma secao critica: a thread do tick para no mutex das
+ * interrupcoes simuladas e so acorda o host no fim do sono.  As outras
+ * interrupcoes simuladas tambem esperam, entao a thread que as gera deve
+ * chamar SonoOciosoAcordar() antes de vPortGenerateSimulatedInterrupt() (o
+ * teclado, em main.c).
+ *
+ * O sono pode ser desligado em execucao, para comparar os dois modos no mesmo
+ * programa (BenchmarkSonoTask()).  Nao combina com configTEMPO_VIRTUAL, que
+ * usa a mesma supressao de ticks.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef struct {
+    uint32_t ulSonos;
+    uint32_t ulSonosInterrompidos;  /* Por SonoOciosoAcordar() */
+    uint32_t ulSonosAbortados;      /* Tarefa pronta antes de dormir */
+    uint32_t ulRetornosEspera;      /* Do WaitForSingleObject(): acordadas do host pelo sono */
+    uint64_t ullTicksTratados;      /* Ticks do port, contados pelo gancho do tick */
+    uint64_t ullTicksCorrigidos;    /* Passados com vTaskStepTick() */
+    uint64_t ullNsDormidos;
+} EstatisticaSonoOcioso_t;
+
+#if ( configSONO_OCIOSO == 1 )
+
+    /* Antes de iniciar o escalonador e de criar as threads que chamam
+     * SonoOciosoAcordar(). */
+    void SonoOciosoIniciar(void);
+
+    /* Liga (o padrao) ou desliga o sono. */
+    void SonoOciosoHabilitar(BaseType_t xHabilitar);
+
+    /* portSUPPRESS_TICKS_AND_SLEEP(): chamada pela tarefa ociosa com o
+     * escalonador suspenso. */
+    void SonoOciosoDormir(uint32_t ulTicksOciosos);
+
+    /* Chamada por threads do Windows, fora do simulador, antes de gerar uma
+     * interrupcao simulada. */
+    void SonoOciosoAcordar(void);
+
+    /* Chamada pelo vApplicationTickHook(), uma vez por tick do port. */
+    void SonoOciosoTick(void);
+
+    void SonoOciosoObterEstatisticas(EstatisticaSonoOcioso_t* pxEstatisticas);
+
+#else
+
+    #define SonoOciosoIniciar()
+    #define SonoOciosoAcordar()
+    #define SonoOciosoTick()
+
+#endif
+
+#endif /* SONO_OCIOSO_H */
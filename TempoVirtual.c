@@ -0,0 +1,80 @@
+/*
+ * Tempo virtual para o simulador Win32.  Ver TempoVirtual.h.
+ *
+ * vTaskStepTick() so existe com configUSE_TICKLESS_IDLE diferente de 0, e
+ * configEXPECTED_IDLE_TIME_BEFORE_SLEEP nao pode ser menor que 2: com o
+ * proximo desbloqueio a um tick a tarefa ociosa nao suprime ticks e quem
+ * avanca e o gancho ocioso, por xTaskCatchUpTicks().  O kernel so suprime
+ * ticks sem outra tarefa de prioridade ociosa pronta; o gancho roda em toda
+ * passada da tarefa ociosa e precisa conferir o mesmo.
+ */
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "TempoVirtual.h"
+
+#if ( configTEMPO_VIRTUAL == 1 )
+
+static EstatisticaTempoVirtual_t xEstatisticas;
+
+/*-----------------------------------------------------------*/
+
+/* Roda na thread de interrupcoes simuladas do port. */
+static uint32_t prvTickIgnorado(void)
+{
+    xEstatisticas.ulTicksReaisIgnorados++;
+
+    /* Sem troca de contexto. */
+    return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void TempoVirtualIniciar(void)
+{
+    vPortSetInterruptHandler(portINTERRUPT_TICK, prvTickIgnorado);
+}
+/*-----------------------------------------------------------*/
+
+void TempoVirtualOcioso(void)
+{
+    /* A tarefa ociosa cede a vez antes do gancho, mas uma tarefa de
+     * prioridade ociosa pode estar pronta de novo (preempcao, taskYIELD()). */
+    if (!TempoVirtualSoOciosaPronta()) {
+        taskYIELD();
+        return;
+    }
+
+    xEstatisticas.ulTicksUnitarios++;
+    (void)xTaskCatchUpTicks(1);
+}
+/*-----------------------------------------------------------*/
+
+void TempoVirtualSaltar(uint32_t ulTicksOciosos)
+{
+    /* Nenhuma tarefa espera por tempo: so uma interrupcao externa pode
+     * desbloquear alguem, e o gancho ocioso continua avancando. */
+    if ((TickType_t)ulTicksOciosos == portMAX_DELAY)
+        return;
+
+    /* Chegar exatamente ao desbloqueio deixa o ultimo tick pendente, tratado
+     * quando a tarefa ociosa retoma o escalonador. */
+    vTaskStepTick((TickType_t)ulTicksOciosos);
+
+    xEstatisticas.ullTicksSaltados += ulTicksOciosos;
+    xEstatisticas.ulSaltos++;
+}
+/*-----------------------------------------------------------*/
+
+void TempoVirtualObterEstatisticas(EstatisticaTempoVirtual_t* pxEstatisticas)
+{
+    taskENTER_CRITICAL();
+    {
+        *pxEstatisticas = xEstatisticas;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configTEMPO_VIRTUAL */
@@ -0,0 +1,51 @@
+#ifndef TEMPO_VIRTUAL_H
+#define TEMPO_VIRTUAL_H
+
+/*
+ * Tempo virtual para o simulador Win32, ligado por configTEMPO_VIRTUAL em
+ * FreeRTOSConfig.h.
+ *
+ * O tick normal vem de uma thread do Windows a cada milissegundo, entao um dia
+ * de gateway leva um dia.  Com o tempo virtual o tick do Windows e ignorado e
+ * o contador de ticks so anda quando a tarefa ociosa e a unica pronta: ela
+ * salta direto para o proximo desbloqueio (supressao de ticks,
+ * configUSE_TICKLESS_IDLE 2) ou, quando ele esta a um tick, avanca um tick
+ * pelo gancho ocioso.  Outras tarefas de prioridade ociosa (registro, despejo,
+ * monitor de pilhas...) terminam antes de o tempo andar.  Codigo
+ * em execucao nao consome ticks e nenhum tick chega no meio de uma ativacao,
+ * entao a ordem das tarefas depende so dos instantes de liberacao e das
+ * prioridades e se repete em toda execucao com as mesmas entradas.
+ *
+ * O contador de run time continua medindo tempo real: perfis, latencias e
+ * custo de CPU seguem em microssegundos reais.  O teclado continua chegando
+ * em tempo real.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef struct {
+    uint64_t ullTicksSaltados;      /* Pela supressao de ticks */
+    uint32_t ulSaltos;
+    uint32_t ulTicksUnitarios;      /* Pelo gancho ocioso */
+    uint32_t ulTicksReaisIgnorados; /* Da thread de tick do Windows */
+} EstatisticaTempoVirtual_t;
+
+/* Troca o tratador do tick do Windows.  O port instala o seu ao iniciar o
+ * escalonador, entao deve ser chamada depois, por exemplo em
+ * vApplicationDaemonTaskStartupHook(). */
+void TempoVirtualIniciar(void);
+
+/* Chamada por vApplicationIdleHook(). */
+void TempoVirtualOcioso(void);
+
+/* Em freertos_tasks_c_additions.h, com acesso as listas de prontas. */
+BaseType_t TempoVirtualSoOciosaPronta(void);
+
+/* portSUPPRESS_TICKS_AND_SLEEP(): chamada pela tarefa ociosa com o
+ * escalonador suspenso. */
+void TempoVirtualSaltar(uint32_t ulTicksOciosos);
+
+void TempoVirtualObterEstatisticas(EstatisticaTempoVirtual_t* pxEstatisticas);
+
+#endif /* TEMPO_VIRTUAL_H */
@@ -29,6 +29,10 @@
  * Values:
  * TRC_RECORDER_MODE_SNAPSHOT
  * TRC_RECORDER_MODE_STREAMING
+ *
+ * Streaming grava arquivos .psf rotativos, ver trcStreamPort.h e
+ * RastreioContinuo.h.  Snapshot continua o padrao: a tecla de rastreio grava
+ * Trace.dump.
  */
 #define TRC_CFG_RECORDER_MODE                    TRC_RECORDER_MODE_SNAPSHOT
 
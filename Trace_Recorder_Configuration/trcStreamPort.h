@@ -0,0 +1,66 @@
+/*
+ * Porta de streaming do Tracealyzer para o gateway.
+ *
+ * Usada com TRC_CFG_RECORDER_MODE em TRC_RECORDER_MODE_STREAMING
+ * (trcKernelPortConfig.h).  Os eventos vao para o buffer interno do recorder,
+ * de TRC_STREAM_PORT_BUFFER_SIZE bytes; a tarefa TzCtrl (TRC_CFG_CTRL_TASK_*
+ * em trcConfig.h) transfere o buffer a cada TRC_CFG_CTRL_TASK_DELAY ticks para
+ * o segmento corrente de RastreioContinuo.c.  Com o buffer cheio os eventos
+ * novos sao descartados (e contados pelo recorder), sem bloquear quem gerou o
+ * evento.  A memoria usada fica fixa, seja qual for a duracao do rastreio.
+ *
+ * Este arquivo e incluido por trcRecorder.h dentro de FreeRTOSConfig.h, antes
+ * dos tipos do FreeRTOS: so tipos de stdint.h aqui.
+ */
+
+#ifndef TRC_STREAM_PORT_H
+#define TRC_STREAM_PORT_H
+
+#if ( TRC_USE_TRACEALYZER_RECORDER == 1 )
+#if ( TRC_CFG_RECORDER_MODE == TRC_RECORDER_MODE_STREAMING )
+
+#include <stdint.h>
+#include <trcTypes.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+#define TRC_USE_INTERNAL_BUFFER                                 1
+#define TRC_INTERNAL_EVENT_BUFFER_WRITE_MODE                    TRC_INTERNAL_EVENT_BUFFER_OPTION_WRITE_MODE_SKIP
+#define TRC_INTERNAL_EVENT_BUFFER_TRANSFER_MODE                 TRC_INTERNAL_EVENT_BUFFER_OPTION_TRANSFER_MODE_ALL
+#define TRC_INTERNAL_EVENT_BUFFER_CHUNK_SIZE                    1024
+#define TRC_INTERNAL_EVENT_BUFFER_CHUNK_TRANSFER_SIZE_LIMIT     64
+#define TRC_INTERNAL_EVENT_BUFFER_CHUNK_COUNT_LIMIT             4
+
+/* 16 KB contra os 250000 eventos do modo snapshot. */
+#define TRC_STREAM_PORT_BUFFER_SIZE                             ( 16 * 1024 )
+
+typedef struct TraceStreamPortBuffer
+{
+    uint8_t buffer[ TRC_STREAM_PORT_BUFFER_SIZE ];
+} TraceStreamPortBuffer_t;
+
+/* Implementadas em RastreioContinuo.c. */
+traceResult xTraceStreamPortInitialize( TraceStreamPortBuffer_t * pxBuffer );
+int32_t RastreioAbrirSegmento( void );
+void RastreioFecharSegmento( void );
+void RastreioEscrever( void * pvDados, uint32_t ulTamanho, int32_t * plEscritos );
+
+#define xTraceStreamPortAllocate( uiSize, ppvData )                 ( ( void ) ( uiSize ), xTraceStaticBufferGet( ppvData ) )
+#define xTraceStreamPortCommit                                      xTraceInternalEventBufferPush
+#define xTraceStreamPortWriteData( pvData, uiSize, piBytesWritten ) ( RastreioEscrever( pvData, uiSize, piBytesWritten ), TRC_SUCCESS )
+#define xTraceStreamPortReadData( pvData, uiSize, piBytesRead )     ( ( void ) ( pvData ), ( void ) ( uiSize ), ( void ) ( piBytesRead ), TRC_SUCCESS )
+#define xTraceStreamPortOnEnable( uiStartOption )                   ( ( void ) ( uiStartOption ), TRC_SUCCESS )
+#define xTraceStreamPortOnDisable()                                 ( TRC_SUCCESS )
+#define xTraceStreamPortOnTraceBegin()                              ( RastreioAbrirSegmento() == 0 ? TRC_SUCCESS : TRC_FAIL )
+#define xTraceStreamPortOnTraceEnd()                                ( RastreioFecharSegmento(), TRC_SUCCESS )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRC_CFG_RECORDER_MODE == TRC_RECORDER_MODE_STREAMING */
+#endif /* TRC_USE_TRACEALYZER_RECORDER == 1 */
+
+#endif /* TRC_STREAM_PORT_H */
@@ -0,0 +1,38 @@
+/*
+ * Incluido no fim de tasks.c (configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H), com
+ * acesso as listas do kernel.
+ */
+
+#if ( configTEMPO_VIRTUAL == 1 )
+
+/* Chamada pela tarefa ociosa: pdTRUE se ela e a unica tarefa pronta (com
+ * preempcao, nenhuma de prioridade maior esta pronta enquanto ela roda).
+ * Outra tarefa de prioridade ociosa pronta (registro, despejo, pilhas,
+ * gravacao...) ainda tem trabalho no instante atual.  Mesmo teste de
+ * prvGetExpectedIdleTime(). */
+BaseType_t TempoVirtualSoOciosaPronta(void)
+{
+    return listCURRENT_LIST_LENGTH(&(pxReadyTasksLists[tskIDLE_PRIORITY])) <= 1;
+}
+
+#endif /* configTEMPO_VIRTUAL */
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+/* Contador de run time da tarefa em execucao, incluindo a fatia corrente.
+ * ulTaskGetRunTimeCounter(NULL) so ve o que foi acumulado ate a ultima troca
+ * de contexto; aqui soma o tempo desde que ela entrou, sem forcar uma troca. */
+configRUN_TIME_COUNTER_TYPE RunTimeTarefaAtual(void)
+{
+    configRUN_TIME_COUNTER_TYPE ulContador;
+
+    taskENTER_CRITICAL();
+    {
+        ulContador = pxCurrentTCB->ulRunTimeCounter + (portGET_RUN_TIME_COUNTER_VALUE() - ulTaskSwitchedInTime);
+    }
+    taskEXIT_CRITICAL();
+
+    return ulContador;
+}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
@@ -50,6 +50,7 @@
 /* Standard includes. */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <conio.h>
 
 /* Visual studio intrinsics used so the __debugbreak() function is available
@@ -64,6 +65,29 @@
 #include "trcRecorder.h"
 
 #include <semphr.h>
+#include "event_groups.h"
+
+/* Gateway includes. */
+#include "Gateway.h"
+#include "AnelAmostras.h"
+#include "EstadoGateway.h"
+#include "ServidorAperiodico.h"
+#include "ComandosAtuador.h"
+#include "MonitorPrazos.h"
+#include "PerfilTarefas.h"
+#include "Escalonador.h"
+#include "RegistroEventos.h"
+#include "SimuladorSensores.h"
+#include "GravacaoSensores.h"
+#include "TempoVirtual.h"
+#include "RastreioContinuo.h"
+#include "DespejoRastreio.h"
+#include "HeapTarefas.h"
+#include "AlocadorPools.h"
+#include "MonitorPilhas.h"
+#include "SonoOcioso.h"
+#include "AmostragemAdaptativa.h"
+#include "Benchmarks.h"
 
 /* This project provides two demo applications.  A simple blinky style demo
  * application, and a more comprehensive test and demo application.  The
@@ -77,23 +101,160 @@
  * implemented and described in main_full.c. */
 #define mainCREATE_SIMPLE_BLINKY_DEMO_ONLY    1
 
-/* This demo uses heap_5.c, and these constants define the sizes of the regions
- * that make up the total heap.  heap_5 is only used for test and example purposes
- * as this demo could easily create one large heap region instead of multiple
- * smaller heap regions - in which case heap_4.c would be the more appropriate
- * choice.  See http://www.freertos.org/a00111.html for an explanation. */
-#define mainREGION_1_SIZE                     8201
-#define mainREGION_2_SIZE                     23905
-#define mainREGION_3_SIZE                     16807
-
 /* This demo allows for users to perform actions with the keyboard. */
 #define mainNO_KEY_PRESS_VALUE                -1
 #define mainOUTPUT_TRACE_KEY                  't'
+#define mainPILHAS_KEY                        'p'
 #define mainINTERRUPT_NUMBER_KEYBOARD         3
 
 /* This demo allows to save a trace file. */
 #define mainTRACE_FILE_NAME                   "Trace.dump"
 
+/* Politica inicial do PoolingServerTask.  1: bloqueia ate um modulo sensor
+ * sinalizar uma mudanca.  0: consulta o estado a cada 200 ticks (modo antigo,
+ * mantido para comparar a latencia de decisao).  O benchmark de decisao troca
+ * a politica com ControleSelecionarPolitica(). */
+#define mainCONTROLE_POR_EVENTOS              1
+
+/* Servidor que executa as tarefas aperiodicas T6 a T9.  Os quatro comandos de
+ * uma zona podem estar na fila juntos (125 ms) e a fila e FIFO: em duas
+ * recargas a capacidade termina a fila antes do prazo de 250 ms de Controlar e
+ * Notificar (Ferramentas/AnaliseRTA).  O servidor esporadico nao tem o jitter
+ * do deferrable, que com essa capacidade faria as tarefas de prioridade 1
+ * perderem o prazo; a prioridade 5 e dividida com o sensor de temperatura.
+ * mainSERVIDOR_POLITICA escolhe entre SERVIDOR_DEFERRABLE e SERVIDOR_ESPORADICO. */
+#define mainSERVIDOR_POLITICA                 SERVIDOR_ESPORADICO
+#define mainSERVIDOR_CAPACIDADE               pdMS_TO_TICKS( 80 )
+#define mainSERVIDOR_PERIODO                  pdMS_TO_TICKS( 120 )
+#define mainSERVIDOR_PRIORIDADE               5
+#define mainSERVIDOR_TAMANHO_FILA             8
+
+/* Zonas (comodos) atendidas pelo gateway.  As mesmas tarefas varrem todas as
+ * zonas a cada ativacao; mainNUM_ZONAS e o numero inicial e pode ser mudado
+ * em uxNumZonas ate mainMAX_ZONAS.  O console mostra os valores da zona 0. */
+#define mainMAX_ZONAS                         estadoMAX_ZONAS
+#define mainNUM_ZONAS                         1
+
+/* Mensagens das tarefas: REGISTRO_ADIADO grava no anel de RegistroEventos.c e
+ * a tarefa de drenagem, na prioridade ociosa, imprime (SAIDA_CONSOLE) ou grava
+ * os registros binarios em Registro.bin (SAIDA_ARQUIVO).  REGISTRO_DIRETO
+ * imprime na hora, como antes. */
+#define mainREGISTRO_MODO                     REGISTRO_ADIADO
+#define mainREGISTRO_SAIDA                    SAIDA_CONSOLE
+
+/* Leituras simuladas (SimuladorSensores.h): a mesma semente e o mesmo cenario
+ * repetem as mesmas sequencias de valores em cada sensor. */
+#define mainSIMULACAO_SEMENTE                 0x20230601ULL
+#define mainSIMULACAO_CENARIO                 xCenarioPadrao
+
+/* Origem das leituras dos sensores.  SIMULADOS: SimuladorSensores.  GRAVAR:
+ * simula e grava cada amostra dos geradores em mainGRAVACAO_ARQUIVO
+ * (GravacaoSensores.h).  REPRODUZIR: os geradores nao sao criados; a tarefa
+ * de reproducao le o arquivo e copia cada registro nos mesmos vetores, na
+ * ordem gravada, e o modulo do sensor faz uma varredura por registro em vez de
+ * esperar o periodo.  Com mainREPRODUCAO_ACELERADA em 1 os registros seguem
+ * sem espera (dias de captura em segundos); em 0, no ritmo da gravacao.  No
+ * fim a tarefa imprime a latencia de decisao e o perfil das tarefas. */
+#define mainSENSORES_SIMULADOS                0
+#define mainSENSORES_GRAVAR                   1
+#define mainSENSORES_REPRODUZIR               2
+#define mainSENSORES_ORIGEM                   mainSENSORES_SIMULADOS
+#define mainGRAVACAO_ARQUIVO                  "Sensores.grv"
+#define mainREPRODUCAO_ACELERADA              1
+
+/* Geracoes guardadas por sensor, cada uma com um vetor por zona e canal: a
+ * mais recente e a anterior, que o modulo le, e a que o gerador escreve. */
+#define mainPROFUNDIDADE_ANEL                 anelPROFUNDIDADE_MINIMA
+
+/* Seleciona o benchmark executado junto com o gateway.  Com
+ * mainBENCHMARK_NENHUM apenas as tarefas do gateway sao criadas. */
+#define mainBENCHMARK_NENHUM                  0
+#define mainBENCHMARK_SOAK                    1
+#define mainBENCHMARK_ANEL                    2
+#define mainBENCHMARK_DECISAO                 3
+#define mainBENCHMARK_EDF                     4
+#define mainBENCHMARK_ZONAS                   5
+#define mainBENCHMARK_REGISTRO                6
+#define mainBENCHMARK_SIMULACAO               7
+#define mainBENCHMARK_HEAP                    8
+#define mainBENCHMARK_SONO                    9
+#define mainBENCHMARK                         mainBENCHMARK_NENHUM
+
+/* 1: tarefas e grupo de eventos do gateway sao criados com as
+ * variantes estaticas, a partir das tabelas antes de main(), e a partida nao
+ * aloca nada do heap (so os benchmarks alocam).  0: os mesmos objetos vem do
+ * heap.  Nos dois modos main() imprime o orcamento de toda a RAM estatica:
+ * objetos do kernel, vetores por zona, tabelas dos modulos, buffers do
+ * rastreio e da gravacao e o heap.  A compilacao falha se o que main.c enxerga
+ * passar de mainORCAMENTO_RAM, e o configASSERT() da partida se o total
+ * passar.  O rastreio snapshot (TRC_CFG_EVENT_BUFFER_SIZE) e a maior parte. */
+#define mainALOCACAO_ESTATICA                 1
+#define mainPILHA_GATEWAY                     configMINIMAL_STACK_SIZE
+#define mainORCAMENTO_RAM                     ( 3072 * 1024 )
+
+/* 0: os modulos sensores rodam nas prioridades fixas 6 a 2 (rate monotonic).
+ * 1: as prioridades 2 a 6 sao reatribuidas pelo prazo absoluto (EDF, ver
+ * Escalonador.h) e a liberacao de cada modulo vem do seu temporizador.  O
+ * servidor dos atuadores continua na prioridade fixa mainSERVIDOR_PRIORIDADE
+ * e divide esse nivel com o modulo que estiver nele. */
+#define mainESCALONAMENTO_EDF                 0
+#define mainEDF_PRIORIDADE_MINIMA             2
+#define mainEDF_PRIORIDADE_MAXIMA             6
+
+/* 1: o periodo de cada modulo sensor segue o sinal (AmostragemAdaptativa.h),
+ * entre os limites de xConfigAmostragem[]: cresce com o sinal parado e cai
+ * com mudancas grandes ou perto dos limiares de alarme.  0: periodos fixos de
+ * 150, 250 e 2000 ms.  Na reproducao a ativacao vem da gravacao. */
+#define mainAMOSTRAGEM_ADAPTATIVA             1
+
+#if ( mainESCALONAMENTO_EDF == 1 ) && ( mainBENCHMARK == mainBENCHMARK_EDF )
+    #error O benchmark de EDF usa o escalonador para as suas proprias tarefas
+#endif
+
+#if ( mainAMOSTRAGEM_ADAPTATIVA == 1 ) && ( ( mainESCALONAMENTO_EDF == 1 ) || ( mainBENCHMARK == mainBENCHMARK_ZONAS ) )
+    #error Com EDF e no benchmark de zonas os modulos precisam dos periodos fixos
+#endif
+
+#if ( configSONO_OCIOSO != 1 ) && ( mainBENCHMARK == mainBENCHMARK_SONO )
+    #error O benchmark de sono ocioso alterna o sono de configSONO_OCIOSO
+#endif
+
+#if ( mainSENSORES_ORIGEM == mainSENSORES_REPRODUZIR ) && ( ( mainESCALONAMENTO_EDF == 1 ) || ( mainBENCHMARK != mainBENCHMARK_NENHUM ) )
+    #error Na reproducao a ativacao dos modulos vem da gravacao
+#endif
+
+/* Pedido de uma nova amostra ao gerador do sensor e gravacao da amostra
+ * gerada. */
+#if ( mainSENSORES_ORIGEM == mainSENSORES_REPRODUZIR )
+    #define mainPEDIR_AMOSTRA( xGerador )
+#else
+    #define mainPEDIR_AMOSTRA( xGerador )     xTaskNotifyGive( xGerador )
+#endif
+
+#if ( mainSENSORES_ORIGEM == mainSENSORES_GRAVAR )
+    #define mainGRAVAR_AMOSTRA( eSensor, uxZonas, plCanal0, plCanal1 )    GravacaoRegistrar( eSensor, uxZonas, plCanal0, plCanal1 )
+#else
+    #define mainGRAVAR_AMOSTRA( eSensor, uxZonas, plCanal0, plCanal1 )
+#endif
+
+/* Fim do trabalho de um modulo sensor: espera o proximo periodo. */
+#if ( mainSENSORES_ORIGEM == mainSENSORES_REPRODUZIR )
+    #define mainAGUARDAR_PERIODO( xPeriodo )  prvAguardarReproducao()
+#elif ( mainESCALONAMENTO_EDF == 1 )
+    #define mainAGUARDAR_PERIODO( xPeriodo )  do { EscalonadorConcluir(); EscalonadorAguardarLiberacao(); } while( 0 )
+#else
+    #define mainAGUARDAR_PERIODO( xPeriodo )  vTaskDelay( xPeriodo )
+#endif
+
+/* Periodo ate a proxima varredura de um modulo sensor: o fixo, ou o da
+ * politica adaptativa a partir da maior mudanca e do pior valor da varredura.
+ * Na reproducao e com EDF mainAGUARDAR_PERIODO() nem avalia o periodo. */
+#if ( mainAMOSTRAGEM_ADAPTATIVA == 1 )
+    #define mainPERIODO_AMOSTRAGEM( eSensor, xFixo, lMaiorDelta, lPiorValor )    AmostragemRegistrar( eSensor, lMaiorDelta, lPiorValor )
+#else
+    #define mainPERIODO_AMOSTRAGEM( eSensor, xFixo, lMaiorDelta, lPiorValor )    ( xFixo )
+#endif
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -110,14 +271,6 @@ extern void main_full( void );
 extern void vFullDemoTickHookFunction( void );
 extern void vFullDemoIdleFunction( void );
 
-/*
- * This demo uses heap_5.c, so start by defining some heap regions.  It is not
- * necessary for this demo to use heap_5, as it could define one large heap
- * region.  Heap_5 is only used for test and example purposes.  See
- * https://www.FreeRTOS.org/a00111.html for an explanation.
- */
-static void prvInitialiseHeap( void );
-
 /*
  * Prototypes for the standard FreeRTOS application hook (callback) functions
  * implemented within this file.  See http://www.freertos.org/a00016.html .
@@ -134,12 +287,6 @@ void vApplicationGetTimerTaskMemory( StaticTask_t ** ppxTimerTaskTCBBuffer,
                                      StackType_t ** ppxTimerTaskStackBuffer,
                                      uint32_t * pulTimerTaskStackSize );
 
-/*
- * Writes trace data to a disk file when the trace recording is stopped.
- * This function will simply overwrite any trace files that already exist.
- */
-static void prvSaveTraceFile( void );
-
 /*
  * Windows thread function to capture keyboard input from outside of the
  * FreeRTOS simulator. This thread passes data safely into the FreeRTOS
@@ -178,382 +325,1194 @@ static int xKeyPressed = mainNO_KEY_PRESS_VALUE;
 
 /*-----------------------------------------------------------*/
 
-int Buffer_temp[2], Buffer_pres[2];
-boolean Buffer_gas, Buffer_part, Buffer_tensao_vento, Buffer_tensao_comp;
-int index_temp, index_pres;
-SemaphoreHandle_t xMutex_temp, xMutex_pres, xMutex_gas, xMutex_part, xMutex_tensao;
+/* Cada modulo sensor publica o valor mais recente de cada zona no estado
+ * consolidado (EstadoGateway.c), que e a unica coisa que o PoolingServerTask
+ * le para decidir. */
+
+/* Mensagens das tarefas do gateway, gravadas pelo registro adiado
+ * (RegistroEventos.h) e formatadas fora do caminho de amostragem. */
+typedef enum {
+    MSG_SENSORIANDO_PRESENCA = 0,
+    MSG_PESSOAS,
+    MSG_ZONAS_PRESENCA,
+    MSG_MEDINDO_TEMPERATURA,
+    MSG_TEMPERATURA,
+    MSG_ZONAS_TEMPERATURA,
+    MSG_MEDINDO_TENSAO,
+    MSG_TENSAO_VENTOINHA,
+    MSG_TENSAO_COMPRESSOR,
+    MSG_ZONAS_TENSAO,
+    MSG_SENSORIANDO_PARTICULAS,
+    MSG_PARTICULAS,
+    MSG_ZONAS_PARTICULAS,
+    MSG_SENSORIANDO_GAS,
+    MSG_GAS,
+    MSG_ZONAS_GAS,
+    MSG_LIGANDO,
+    MSG_CONTROLANDO,
+    MSG_DESLIGANDO,
+    MSG_NOTIFICANDO,
+    MSG_DEFEITO_ELETRICO,
+    MSG_DEFEITO_AUTOLIMPEZA,
+    MSG_DEFEITO_GAS,
+    NUM_MENSAGENS
+} MensagemGateway_t;
+
+static const char* const pcFormatosMensagem[NUM_MENSAGENS] = {
+    "Sensoriando Presenca...\n",
+    "Quantidade de pessoas no comodo: %d\n\n",
+    "Zonas com mudanca de presenca: %d de %d\n\n",
+    "Medindo a temperatura...\n",
+    "Temperatura Medida: %d\n\n",
+    "Zonas com mudanca de temperatura: %d de %d\n\n",
+    "Medindo a Tensao da Ventoinha e do Compressor de Ar...\n",
+    "Tensao na Ventoinha: %dV Defeito: %d\n",
+    "Tensao no Compressor: %dV Defeito: %d\n\n",
+    "Zonas com defeito eletrico: %d de %d\n\n",
+    "Sensoriando a quantidade de particulas...\n",
+    "Quantidade de particulas: %d Defeito: %d\n\n",
+    "Zonas com defeito na autolimpeza: %d de %d\n\n",
+    "Sensoriando presenca de gas refrigerante...\n",
+    "Gas Refrigerante no ambiente: %d\n\n",
+    "Zonas com gas refrigerante: %d de %d\n\n",
+    "Ligando o ar Condicionado da zona %d...\n\n",
+    "Mudando Temperatura do Ar Condicionado da zona %d...\n\n",
+    "Desligando o ar Condicionado da zona %d...\n\n",
+    "Notificando usuario da zona %d...\n\n",
+    "Foi verificado um problema eletrico no seu ar condicionado.\nDesligue-o e contate o Suporte Tecnico.\n\n",
+    "Foi verificada uma possivel falha no sistema de autolimpeza de seu ar condicionado.\nContate o Suporte Tecnico\n\n",
+    "Foi verificada presenca de gas refrigerante no ambiente.\nContate o Suporte Tecnico\n\n"
+};
+
+/* Estado de cada zona, em vetores indexados pela zona.  So as uxNumZonas
+ * primeiras posicoes estao ativas. */
+
+/* Cada gerador usa so o fluxo do seu sensor no simulador. */
+static SimuladorSensores_t xSimulador;
+
+/* Saidas dos geradores.  A geracao publicada na posicao p do anel do sensor
+ * esta na linha p destes vetores, e o valor da amostra no anel e o numero de
+ * zonas dela.  O gerador so escreve a linha livre e o modulo so le as ja
+ * publicadas, entao nenhum dos dois trava o outro. */
+static AnelAmostras_t xAneis[NUM_SENSORES];
+static Amostra_t xGeracoes[NUM_SENSORES][mainPROFUNDIDADE_ANEL];
+static int32_t lFluxo[mainPROFUNDIDADE_ANEL][mainMAX_ZONAS];
+static int32_t lTemperaturaMedida[mainPROFUNDIDADE_ANEL][mainMAX_ZONAS];
+static int32_t lTensaoVentoinha[mainPROFUNDIDADE_ANEL][mainMAX_ZONAS], lTensaoCompressor[mainPROFUNDIDADE_ANEL][mainMAX_ZONAS];
+static int32_t lParticulas[mainPROFUNDIDADE_ANEL][mainMAX_ZONAS];
+static int32_t lPresencaGas[mainPROFUNDIDADE_ANEL][mainMAX_ZONAS];
+
+/* Privado do gerador de fluxo. */
+static int32_t lOcupantes[mainMAX_ZONAS];
+
+/* Lado dos atuadores: escrito pelas acoes T6 a T9 e pelos modulos. */
+static volatile uint8_t ucArLigado[mainMAX_ZONAS];
+static volatile uint8_t ucDefeitoTarefa[mainMAX_ZONAS];
+
+/* Privado do PoolingServerTask: defeitos ja vistos por zona, zonas com
+ * defeito ainda nao notificado e zonas com comando recusado a repetir. */
+static uint32_t ulDefeitosVistos[mainMAX_ZONAS];
+static uint32_t ulDefeitoPendente[estadoNUM_BLOCOS];
+static uint32_t ulRepetir[estadoNUM_BLOCOS];
+static BlocoEstado_t xCopiaBloco;
+
+volatile UBaseType_t uxNumZonas = mainNUM_ZONAS;
+volatile uint32_t ulZonasAmostradas[NUM_SENSORES];
+volatile uint32_t ulZonasDecididas;
+
+/* Os geradores sao criados uma unica vez em main() e ficam bloqueados ate o
+ * modulo sensor correspondente pedir uma nova amostra por notificacao. */
+xTaskHandle xGeradorFluxo, xGeradorTemp, xGeradorTensao, xGeradorPart, xGeradorGas;
+
+EstatisticaLatencia_t xEstatisticaAmostragem[NUM_SENSORES];
+EstatisticaLatencia_t xLatenciaDecisao;
+volatile uint32_t ulDespertaresControle;
+
+/* Os modulos sensores acordam o PoolingServerTask por este grupo de eventos. */
+EventGroupHandle_t xEventosControle;
+
+/* Politica pedida por ControleSelecionarPolitica(), aplicada pelo controlador. */
+static volatile BaseType_t xPoliticaPedida = mainCONTROLE_POR_EVENTOS;
+
+/* O PoolingServerTask decide e envia comandos (ComandosAtuador.c), executados
+ * pela tarefa deste servidor. */
+ServidorAperiodico_t xServidorAtuadores;
+
+void RegistrarLatencia(EstatisticaLatencia_t* pxEstatistica, configRUN_TIME_COUNTER_TYPE ulInicio) {
+
+    configRUN_TIME_COUNTER_TYPE ulLatencia = ulGetRunTimeCounterValue() - ulInicio;
+
+    pxEstatistica->ulAmostras++;
+    pxEstatistica->ullLatenciaTotal += ulLatencia;
+
+    if (ulLatencia > pxEstatistica->ullLatenciaMax)
+        pxEstatistica->ullLatenciaMax = ulLatencia;
+}
 
-int cont = 0, fluxo;
-int temp_medida = 25;
-int tensoes[2] = { 220, 220 };
-int particulas = 4500;
-boolean presencaGas;
+void RegistrarAmostra(Sensor_t xSensor, configRUN_TIME_COUNTER_TYPE ulInicio) {
+    RegistrarLatencia(&xEstatisticaAmostragem[xSensor], ulInicio);
+}
 
-boolean arCondicionadoLigado;
-int defeitoTarefa = 0;
+/* Zonas ativas do bloco uxBloco. */
+static UBaseType_t prvZonasNoBloco(UBaseType_t uxBloco, UBaseType_t uxZonas) {
 
-void GeradorFluxoPessoas() {
+    UBaseType_t uxRestantes = uxZonas - uxBloco * estadoZONAS_POR_BLOCO;
 
-        srand(time(NULL));
-        xSemaphoreTake(xMutex_pres, portMAX_DELAY);
+    return uxRestantes < estadoZONAS_POR_BLOCO ? uxRestantes : estadoZONAS_POR_BLOCO;
+}
 
-        int sorteio = rand() % 11;
+/* Antes do escalonador: todas as linhas comecam nos valores nominais e cada
+ * anel recebe uma geracao inicial, a que a primeira ativacao do modulo le. */
+static void prvInicializarZonas() {
 
-        if (sorteio <= 6)
-            fluxo = 0;
-        else if (sorteio <= 8) {
-            fluxo = 1;
-            cont++;
-        }
-        else if (cont > 0) {
-            fluxo = -1;
-            cont--;
+    for (UBaseType_t uxLinha = 0; uxLinha < mainPROFUNDIDADE_ANEL; uxLinha++) {
+        for (UBaseType_t uxZona = 0; uxZona < mainMAX_ZONAS; uxZona++) {
+            lTemperaturaMedida[uxLinha][uxZona] = 25;
+            lTensaoVentoinha[uxLinha][uxZona] = 220;
+            lTensaoCompressor[uxLinha][uxZona] = 220;
+            lParticulas[uxLinha][uxZona] = 4500;
         }
-        else
-            fluxo = 0;
+    }
 
-        xSemaphoreGive(xMutex_pres);
+    for (int i = 0; i < NUM_SENSORES; i++) {
+        AnelInicializar(&xAneis[i], xGeracoes[i], mainPROFUNDIDADE_ANEL);
+        AnelPublicar(&xAneis[i], (int32_t)uxNumZonas);
+    }
 }
 
-void ModuloDetectorPresencaTask() {
+/* Geracao mais recente do sensor, para o seu modulo.  Retorna o numero de
+ * zonas dela, ou 0 se o gerador nao publicou nada desde a ultima ativacao:
+ * essa geracao ja foi tratada e o fluxo de pessoas nao pode ser somado duas
+ * vezes. */
+static UBaseType_t prvConsumirGeracao(Sensor_t eSensor, uint32_t* pulAtual, uint32_t* pulAnterior) {
 
-    int qtde_pessoas = 0;
+    Amostra_t xGeracao;
 
-    while (1) {
-        
-        xTaskHandle GP;
-        xTaskCreate(GeradorFluxoPessoas, (signed char*)"Gerador de Fluxo", configMINIMAL_STACK_SIZE, (void*)NULL, 1, &GP);
+    if (!AnelConsumirUltimas(&xAneis[eSensor], &xGeracao, pulAtual, pulAnterior))
+        return 0;
 
-        xSemaphoreTake(xMutex_pres, portMAX_DELAY);
+    return (UBaseType_t)xGeracao.lValor;
+}
 
-        printf("Sensoriando Presenca...\n");
-        // Alteracao de uma variavel que indica o numero de pessoas no ambiente
+#if ( mainSENSORES_ORIGEM == mainSENSORES_REPRODUZIR )
 
-        qtde_pessoas += fluxo;
+/* Registro corrente da gravacao, copiado para os vetores do sensor. */
+static int32_t lReproducaoCanal0[mainMAX_ZONAS], lReproducaoCanal1[mainMAX_ZONAS];
 
-        if (index_pres == 2) {
-            index_pres = 1;
-            Buffer_pres[0] = Buffer_pres[1];
-        }
-        
-        Buffer_pres[index_pres] = qtde_pessoas;
-        index_pres++;
+static TaskHandle_t xModulosSensores[NUM_SENSORES];
+static TaskHandle_t xTarefaReproducao;
+
+/* Modulo que esta varrendo o registro injetado; NULL entre registros. */
+static volatile TaskHandle_t xModuloReproduzido;
 
-        printf("Quantidade de pessoas no comodo: %d\n\n", qtde_pessoas);
+/* Fim da varredura de um modulo: devolve a vez a tarefa de reproducao e
+ * espera o proximo registro do seu sensor.  A primeira varredura, feita antes
+ * de qualquer registro, nao devolve nada. */
+static void prvAguardarReproducao() {
 
-        xSemaphoreGive(xMutex_pres);
-        vTaskDelay(150);
+    if (xModuloReproduzido == xTaskGetCurrentTaskHandle()) {
+        xModuloReproduzido = NULL;
+        xTaskNotifyGive(xTarefaReproducao);
     }
+
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 }
 
-void GeradorTemperatura() {
-    
-    int temperatura = 25;
-    int variacao, sinal;
+/* A tarefa de reproducao e a produtora dos aneis: os geradores nao rodam. */
+static void prvInjetarRegistro(const CabecalhoRegistroGravacao_t* pxCabecalho) {
 
-        srand(time(NULL));
-        xSemaphoreTake(xMutex_temp, portMAX_DELAY);
+    int32_t (* const plDestino[NUM_SENSORES])[mainMAX_ZONAS] = {
+        lFluxo, lTemperaturaMedida, lTensaoVentoinha, lParticulas, lPresencaGas
+    };
+    Sensor_t eSensor = (Sensor_t)pxCabecalho->ucSensor;
+    uint32_t ulLinha = AnelPosicaoLivre(&xAneis[eSensor]);
+    size_t xBytes = pxCabecalho->usZonas * sizeof(int32_t);
 
-        variacao = rand() % 3;
-        sinal = rand() % 2;
+    memcpy(plDestino[eSensor][ulLinha], lReproducaoCanal0, xBytes);
+    if (eSensor == SENSOR_TENSAO)
+        memcpy(lTensaoCompressor[ulLinha], lReproducaoCanal1, xBytes);
 
-        if (sinal)
-            temp_medida = temperatura + variacao;
-        else
-            temp_medida = temperatura - variacao;
+    /* Vale a partir da varredura que o registro vai disparar. */
+    uxNumZonas = pxCabecalho->usZonas;
 
-        xSemaphoreGive(xMutex_temp);
+    AnelPublicar(&xAneis[eSensor], (int32_t)pxCabecalho->usZonas);
 }
 
-void ModuloSensorTemperaturaTask() {
+/* Na prioridade ociosa: o modulo e o controlador terminam de tratar cada
+ * registro antes de o seguinte ser lido. */
+static void prvReproducaoTask(void* pvParameters) {
 
-    while (1) {
-        
-        xTaskHandle GT;
-        xTaskCreate(GeradorTemperatura, (signed char*)"Gerador de Temperatura", configMINIMAL_STACK_SIZE, (void*)NULL, 1, &GT);
+    CabecalhoRegistroGravacao_t xCabecalho;
+    configRUN_TIME_COUNTER_TYPE ulInicio;
+    TickType_t xInicio;
+    uint32_t ulPrimeiroTick = 0, ulUltimoTick = 0, ulRegistros = 0;
+    unsigned long long ullDecorridoMs, ullMedia = 0;
+
+    (void)pvParameters;
+
+    if (ReproducaoAbrir(mainGRAVACAO_ARQUIVO) != pdPASS) {
+        printf("[reproducao] nao foi possivel abrir %s\n", mainGRAVACAO_ARQUIVO);
+        vTaskSuspend(NULL);
+    }
 
-        xSemaphoreTake(xMutex_temp, portMAX_DELAY);
+    ulInicio = ulGetRunTimeCounterValue();
+    xInicio = xTaskGetTickCount();
 
-        printf("Medindo a temperatura...\n");
-        // alteracao de uma variavel que indica a temperatura do ambiente
+    while (ReproducaoLer(&xCabecalho, lReproducaoCanal0, lReproducaoCanal1, mainMAX_ZONAS)) {
+        if (ulRegistros++ == 0)
+            ulPrimeiroTick = xCabecalho.ulTick;
+        ulUltimoTick = xCabecalho.ulTick;
 
-        if (index_temp == 2) {
-            index_temp = 1;
-            Buffer_temp[0] = Buffer_temp[1];
+#if ( mainREPRODUCAO_ACELERADA == 0 )
+        {
+            TickType_t xEspera = xInicio + (TickType_t)(ulUltimoTick - ulPrimeiroTick) - xTaskGetTickCount();
+
+            if ((int32_t)xEspera > 0)
+                vTaskDelay(xEspera);
         }
-        
-        Buffer_temp[index_temp] = temp_medida;
-        index_temp++;
+#endif
 
-        printf("Temperatura Medida: %d\n\n", temp_medida);
+        prvInjetarRegistro(&xCabecalho);
 
-        xSemaphoreGive(xMutex_temp);
-        vTaskDelay(250);
+        xModuloReproduzido = xModulosSensores[xCabecalho.ucSensor];
+        xTaskNotifyGive(xModuloReproduzido);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
+
+    ReproducaoFechar();
+
+    ullDecorridoMs = (ulGetRunTimeCounterValue() - ulInicio) / gatewayRUN_TIME_POR_MS;
+    if (xLatenciaDecisao.ulAmostras > 0)
+        ullMedia = xLatenciaDecisao.ullLatenciaTotal / xLatenciaDecisao.ulAmostras;
+
+    printf("[reproducao] %lu registros, %lu s gravados reproduzidos em %llu ms (%lu ticks)\n",
+           (unsigned long)ulRegistros,
+           (unsigned long)((ulUltimoTick - ulPrimeiroTick) / configTICK_RATE_HZ),
+           ullDecorridoMs,
+           (unsigned long)(xTaskGetTickCount() - xInicio));
+    printf("[reproducao] decisoes %lu  latencia media %llu us  max %llu us  zonas decididas %lu\n",
+           (unsigned long)xLatenciaDecisao.ulAmostras,
+           ullMedia * 1000ULL / gatewayRUN_TIME_POR_MS,
+           (unsigned long long)xLatenciaDecisao.ullLatenciaMax * 1000ULL / gatewayRUN_TIME_POR_MS,
+           (unsigned long)ulZonasDecididas);
+    MonitorExportar();
+    PerfilExportar();
+
+    vTaskSuspend(NULL);
 }
 
-void GeradorTensao() {
+#endif /* mainSENSORES_ORIGEM == mainSENSORES_REPRODUZIR */
 
-        srand(time(NULL));
-        xSemaphoreTake(xMutex_tensao, portMAX_DELAY);
+void GeradorFluxoPessoas() {
 
-        int sort1 = rand() % 11;
-        int sort2 = rand() % 46;
+    while (1) {
+        // Aguarda o pedido de uma nova amostra
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        UBaseType_t uxZonas = uxNumZonas;
+        int32_t* plFluxo = lFluxo[AnelPosicaoLivre(&xAneis[SENSOR_PRESENCA])];
+        PerfilInicioAtivacao();
+
+        for (UBaseType_t uxZona = 0; uxZona < uxZonas; uxZona++) {
+            plFluxo[uxZona] = SimularFluxo(&xSimulador, lOcupantes[uxZona]);
+            lOcupantes[uxZona] += plFluxo[uxZona];
+        }
 
-        if (sort1 < 1)
-            tensoes[0] = (rand() % 200);
-        else if (sort1 < 2)
-            tensoes[0] = 221 + (rand() % 40);
-        else
-            tensoes[0] = 200 + (rand() % 21);
+        AnelPublicar(&xAneis[SENSOR_PRESENCA], (int32_t)uxZonas);
+        mainGRAVAR_AMOSTRA(SENSOR_PRESENCA, uxZonas, plFluxo, NULL);
+        PerfilFimAtivacao();
+    }
+}
 
-        if (sort2 < 5)
-            tensoes[1] = (rand() % 200);
-        else if (sort2 < 10)
-            tensoes[1] = 221 + (rand() % 40);
-        else
-            tensoes[1] = 200 + (rand() % 21);
+void ModuloDetectorPresencaTask() {
 
-        xSemaphoreGive(xMutex_tensao);
-}
+    while (1) {
+        
+        configRUN_TIME_COUNTER_TYPE ulInicio = ulGetRunTimeCounterValue();
+        UBaseType_t uxZonas;
+        UBaseType_t uxMudancas = 0;
+        uint32_t ulAtual, ulAnterior;
+        int32_t lPessoasZona0 = 0;
+        int32_t lMaiorDelta = 0;
+        PerfilInicioAtivacao();
+        mainPEDIR_AMOSTRA(xGeradorFluxo);
+
+        uxZonas = prvConsumirGeracao(SENSOR_PRESENCA, &ulAtual, &ulAnterior);
+
+        Registrar0(MSG_SENSORIANDO_PRESENCA);
+        // Alteracao de uma variavel que indica o numero de pessoas em cada zona
+
+        for (UBaseType_t uxBloco = 0; uxBloco * estadoZONAS_POR_BLOCO < uxZonas; uxBloco++) {
+            const int32_t* plFluxo = &lFluxo[ulAtual][uxBloco * estadoZONAS_POR_BLOCO];
+            UBaseType_t uxNoBloco = prvZonasNoBloco(uxBloco, uxZonas);
+            BlocoEstado_t* pxBloco = EstadoIniciarEscrita(uxBloco);
+            uint32_t ulMudou = 0;
+
+            for (UBaseType_t i = 0; i < uxNoBloco; i++) {
+                pxBloco->lPessoasAnterior[i] = pxBloco->lPessoas[i];
+                pxBloco->lPessoas[i] += plFluxo[i];
+                if (plFluxo[i] != 0) {
+                    pxBloco->ulMudanca[i] = ulInicio;
+                    ulMudou |= 1UL << i;
+                    uxMudancas++;
+                    if (abs(plFluxo[i]) > lMaiorDelta)
+                        lMaiorDelta = abs(plFluxo[i]);
+                }
+            }
+            if (uxBloco == 0)
+                lPessoasZona0 = pxBloco->lPessoas[0];
 
-void ModuloMedidorTensaoTask() {
+            EstadoConcluirEscrita(uxBloco, ulMudou);
+        }
 
-    boolean defeitos[2] = {0, 0};
+        if (uxMudancas > 0)
+            xEventGroupSetBits(xEventosControle, EVENTO_PRESENCA);
 
-   while (1) {
-       
-       xTaskHandle GTs;
-       xTaskCreate(GeradorTensao, (signed char*)"Gerador de Tensoes", configMINIMAL_STACK_SIZE, (void*)NULL, 1, &GTs);
+        Registrar1(MSG_PESSOAS, lPessoasZona0);
+        if (uxZonas > 1)
+            Registrar2(MSG_ZONAS_PRESENCA, uxMudancas, uxZonas);
+
+        ulZonasAmostradas[SENSOR_PRESENCA] += uxZonas;
+        RegistrarAmostra(SENSOR_PRESENCA, ulInicio);
+        PerfilFimAtivacao();
+        mainAGUARDAR_PERIODO(mainPERIODO_AMOSTRAGEM(SENSOR_PRESENCA, 150, lMaiorDelta, 0));
+    }
+}
+
+void GeradorTemperatura() {
 
-       xSemaphoreTake(xMutex_tensao, portMAX_DELAY);
+    while (1) {
+        // Aguarda o pedido de uma nova amostra
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        UBaseType_t uxZonas = uxNumZonas;
+        int32_t* plMedida = lTemperaturaMedida[AnelPosicaoLivre(&xAneis[SENSOR_TEMPERATURA])];
+        PerfilInicioAtivacao();
+
+        for (UBaseType_t uxZona = 0; uxZona < uxZonas; uxZona++)
+            plMedida[uxZona] = SimularTemperatura(&xSimulador);
+
+        AnelPublicar(&xAneis[SENSOR_TEMPERATURA], (int32_t)uxZonas);
+        mainGRAVAR_AMOSTRA(SENSOR_TEMPERATURA, uxZonas, plMedida, NULL);
+        PerfilFimAtivacao();
+    }
+}
 
-       printf("Medindo a Tensao da Ventoinha e do Compressor de Ar...\n");
-        // Alteracao de duas variaveis que so: 1 - Tensao de Defeito e 0 - Tensao diferente de defeito
+void ModuloSensorTemperaturaTask() {
 
-        for (int i = 0; i < 2; i++) {
-            if (tensoes[i] < 200)
-                defeitos[i] = 1;
-            else {
-                defeitos[i] = 0;
-                defeitoTarefa = 3;
+    while (1) {
+        
+        configRUN_TIME_COUNTER_TYPE ulInicio = ulGetRunTimeCounterValue();
+        UBaseType_t uxZonas;
+        UBaseType_t uxMudancas = 0;
+        uint32_t ulAtual, ulAnterior;
+        int32_t lMaiorDelta = 0, lMaisQuente = INT32_MIN;
+        PerfilInicioAtivacao();
+        mainPEDIR_AMOSTRA(xGeradorTemp);
+
+        uxZonas = prvConsumirGeracao(SENSOR_TEMPERATURA, &ulAtual, &ulAnterior);
+
+        Registrar0(MSG_MEDINDO_TEMPERATURA);
+        // alteracao de uma variavel que indica a temperatura de cada zona
+
+        for (UBaseType_t uxBloco = 0; uxBloco * estadoZONAS_POR_BLOCO < uxZonas; uxBloco++) {
+            const int32_t* plMedida = &lTemperaturaMedida[ulAtual][uxBloco * estadoZONAS_POR_BLOCO];
+            const int32_t* plAnterior = &lTemperaturaMedida[ulAnterior][uxBloco * estadoZONAS_POR_BLOCO];
+            UBaseType_t uxNoBloco = prvZonasNoBloco(uxBloco, uxZonas);
+            BlocoEstado_t* pxBloco = EstadoIniciarEscrita(uxBloco);
+            uint32_t ulMudou = 0;
+
+            for (UBaseType_t i = 0; i < uxNoBloco; i++) {
+                pxBloco->lTemperaturaAnterior[i] = plAnterior[i];
+                pxBloco->lTemperatura[i] = plMedida[i];
+                if (pxBloco->lTemperaturaAnterior[i] != plMedida[i]) {
+                    pxBloco->ulMudanca[i] = ulInicio;
+                    ulMudou |= 1UL << i;
+                    uxMudancas++;
+                    if (abs(plMedida[i] - pxBloco->lTemperaturaAnterior[i]) > lMaiorDelta)
+                        lMaiorDelta = abs(plMedida[i] - pxBloco->lTemperaturaAnterior[i]);
+                }
+                if (plMedida[i] > lMaisQuente)
+                    lMaisQuente = plMedida[i];
             }
+
+            EstadoConcluirEscrita(uxBloco, ulMudou);
         }
 
-        Buffer_tensao_vento = defeitos[0];
-        Buffer_tensao_comp = defeitos[1];
+        if (uxMudancas > 0)
+            xEventGroupSetBits(xEventosControle, EVENTO_TEMPERATURA);
 
-        printf("Tensao na Ventoinha: %dV Defeito: %d\n", tensoes[0], defeitos[0]);
-        printf("Tensao no Compressor: %dV Defeito: %d\n\n", tensoes[1], defeitos[1]);
+        Registrar1(MSG_TEMPERATURA, lTemperaturaMedida[ulAtual][0]);
+        if (uxZonas > 1)
+            Registrar2(MSG_ZONAS_TEMPERATURA, uxMudancas, uxZonas);
 
-        xSemaphoreGive(xMutex_tensao);
-        vTaskDelay(2000);
+        ulZonasAmostradas[SENSOR_TEMPERATURA] += uxZonas;
+        RegistrarAmostra(SENSOR_TEMPERATURA, ulInicio);
+        PerfilFimAtivacao();
+        mainAGUARDAR_PERIODO(mainPERIODO_AMOSTRAGEM(SENSOR_TEMPERATURA, 250, lMaiorDelta, lMaisQuente));
     }
 }
 
-void GeradorParticulas() {
+void GeradorTensao() {
 
-        srand(time(NULL));
-        xSemaphoreTake(xMutex_part, portMAX_DELAY);
+    while (1) {
+        // Aguarda o pedido de uma nova amostra
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        UBaseType_t uxZonas = uxNumZonas;
+        uint32_t ulLinha = AnelPosicaoLivre(&xAneis[SENSOR_TENSAO]);
+        PerfilInicioAtivacao();
+
+        for (UBaseType_t uxZona = 0; uxZona < uxZonas; uxZona++) {
+            lTensaoVentoinha[ulLinha][uxZona] = SimularTensao(&xSimulador, TENSAO_VENTOINHA);
+            lTensaoCompressor[ulLinha][uxZona] = SimularTensao(&xSimulador, TENSAO_COMPRESSOR);
+        }
 
-        int sorteio = rand() % 11;
+        AnelPublicar(&xAneis[SENSOR_TENSAO], (int32_t)uxZonas);
+        mainGRAVAR_AMOSTRA(SENSOR_TENSAO, uxZonas, lTensaoVentoinha[ulLinha], lTensaoCompressor[ulLinha]);
+        PerfilFimAtivacao();
+    }
+}
 
-        if (sorteio <= 9)
-            particulas = 3000 + (rand() % 1500);
-        else
-            particulas = 4501 + (rand() % 1500);
+void ModuloMedidorTensaoTask() {
 
-        xSemaphoreGive(xMutex_part);
-}
+   while (1) {
+       
+       configRUN_TIME_COUNTER_TYPE ulInicio = ulGetRunTimeCounterValue();
+       UBaseType_t uxZonas;
+       UBaseType_t uxMudancas = 0;
+       uint32_t ulAtual, ulAnterior;
+       uint8_t ucDefeitosZona0 = 0;
+       int32_t lTrocasDefeito = 0, lMenorTensao = INT32_MAX;
+       PerfilInicioAtivacao();
+       mainPEDIR_AMOSTRA(xGeradorTensao);
+
+       uxZonas = prvConsumirGeracao(SENSOR_TENSAO, &ulAtual, &ulAnterior);
+       const int32_t* plVentoinha = lTensaoVentoinha[ulAtual];
+       const int32_t* plCompressor = lTensaoCompressor[ulAtual];
+
+       Registrar0(MSG_MEDINDO_TENSAO);
+        // Defeito quando a tensao da ventoinha ou do compressor fica abaixo de 200V
+
+        for (UBaseType_t uxBloco = 0; uxBloco * estadoZONAS_POR_BLOCO < uxZonas; uxBloco++) {
+            UBaseType_t uxBase = uxBloco * estadoZONAS_POR_BLOCO;
+            UBaseType_t uxNoBloco = prvZonasNoBloco(uxBloco, uxZonas);
+            BlocoEstado_t* pxBloco = EstadoIniciarEscrita(uxBloco);
+            uint32_t ulMudou = 0;
+
+            for (UBaseType_t i = 0; i < uxNoBloco; i++) {
+                boolean defeitoVentoinha = plVentoinha[uxBase + i] < 200;
+                boolean defeitoCompressor = plCompressor[uxBase + i] < 200;
+                uint8_t ucAntes = pxBloco->ucDefeitos[i];
+
+                pxBloco->ucDefeitos[i] &= ~(estadoDEFEITO_VENTOINHA | estadoDEFEITO_COMPRESSOR);
+                if (defeitoVentoinha)
+                    pxBloco->ucDefeitos[i] |= estadoDEFEITO_VENTOINHA;
+                if (defeitoCompressor)
+                    pxBloco->ucDefeitos[i] |= estadoDEFEITO_COMPRESSOR;
+
+                // Para a amostragem: defeitos que apareceram ou sumiram e a menor tensao
+                if (pxBloco->ucDefeitos[i] != ucAntes)
+                    lTrocasDefeito++;
+                if (plVentoinha[uxBase + i] < lMenorTensao)
+                    lMenorTensao = plVentoinha[uxBase + i];
+                if (plCompressor[uxBase + i] < lMenorTensao)
+                    lMenorTensao = plCompressor[uxBase + i];
+
+                if (defeitoVentoinha || defeitoCompressor) {
+                    pxBloco->ulDefeitos[i] += defeitoVentoinha + defeitoCompressor;
+                    pxBloco->ulMudanca[i] = ulInicio;
+                    ulMudou |= 1UL << i;
+                    uxMudancas++;
+                    ucDefeitoTarefa[uxBase + i] = 3;
+                }
+            }
+            if (uxBloco == 0)
+                ucDefeitosZona0 = pxBloco->ucDefeitos[0];
 
-void ModuloSensorParticulasTask() {
+            EstadoConcluirEscrita(uxBloco, ulMudou);
+        }
 
-    boolean defeito;
+        if (uxMudancas > 0)
+            xEventGroupSetBits(xEventosControle, EVENTO_DEFEITO);
+
+        Registrar2(MSG_TENSAO_VENTOINHA, plVentoinha[0], (ucDefeitosZona0 & estadoDEFEITO_VENTOINHA) != 0);
+        Registrar2(MSG_TENSAO_COMPRESSOR, plCompressor[0], (ucDefeitosZona0 & estadoDEFEITO_COMPRESSOR) != 0);
+        if (uxZonas > 1)
+            Registrar2(MSG_ZONAS_TENSAO, uxMudancas, uxZonas);
+
+        ulZonasAmostradas[SENSOR_TENSAO] += uxZonas;
+        RegistrarAmostra(SENSOR_TENSAO, ulInicio);
+        PerfilFimAtivacao();
+        mainAGUARDAR_PERIODO(mainPERIODO_AMOSTRAGEM(SENSOR_TENSAO, 2000, lTrocasDefeito, lMenorTensao));
+    }
+}
+
+void GeradorParticulas() {
 
     while (1) {
+        // Aguarda o pedido de uma nova amostra
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        UBaseType_t uxZonas = uxNumZonas;
+        int32_t* plParticulas = lParticulas[AnelPosicaoLivre(&xAneis[SENSOR_PARTICULAS])];
+        PerfilInicioAtivacao();
+
+        for (UBaseType_t uxZona = 0; uxZona < uxZonas; uxZona++)
+            plParticulas[uxZona] = SimularParticulas(&xSimulador);
+
+        AnelPublicar(&xAneis[SENSOR_PARTICULAS], (int32_t)uxZonas);
+        mainGRAVAR_AMOSTRA(SENSOR_PARTICULAS, uxZonas, plParticulas, NULL);
+        PerfilFimAtivacao();
+    }
+}
 
-        xTaskHandle GP;
-        xTaskCreate(GeradorParticulas, (signed char*)"Gerador de Particulas", configMINIMAL_STACK_SIZE, (void*)NULL, 1, &GP);
+void ModuloSensorParticulasTask() {
 
-        xSemaphoreTake(xMutex_part, portMAX_DELAY);
+    while (1) {
 
-        printf("Sensoriando a quantidade de particulas...\n");
-        // Alteracao de variavel que ser: 1 - Defeito na autolimpeza e 0 - Nao Defeito
+        configRUN_TIME_COUNTER_TYPE ulInicio = ulGetRunTimeCounterValue();
+        UBaseType_t uxZonas;
+        UBaseType_t uxMudancas = 0;
+        uint32_t ulAtual, ulAnterior;
+        int32_t lTrocasDefeito = 0, lMaisParticulas = INT32_MIN;
+        PerfilInicioAtivacao();
+        mainPEDIR_AMOSTRA(xGeradorPart);
+
+        uxZonas = prvConsumirGeracao(SENSOR_PARTICULAS, &ulAtual, &ulAnterior);
+        const int32_t* plParticulas = lParticulas[ulAtual];
+
+        Registrar0(MSG_SENSORIANDO_PARTICULAS);
+        // Defeito na autolimpeza quando a quantidade de particulas passa de 4500
+
+        for (UBaseType_t uxBloco = 0; uxBloco * estadoZONAS_POR_BLOCO < uxZonas; uxBloco++) {
+            UBaseType_t uxBase = uxBloco * estadoZONAS_POR_BLOCO;
+            UBaseType_t uxNoBloco = prvZonasNoBloco(uxBloco, uxZonas);
+            BlocoEstado_t* pxBloco = EstadoIniciarEscrita(uxBloco);
+            uint32_t ulMudou = 0;
+
+            for (UBaseType_t i = 0; i < uxNoBloco; i++) {
+                if ((plParticulas[uxBase + i] > 4500) != ((pxBloco->ucDefeitos[i] & estadoDEFEITO_PARTICULAS) != 0))
+                    lTrocasDefeito++;
+                if (plParticulas[uxBase + i] > lMaisParticulas)
+                    lMaisParticulas = plParticulas[uxBase + i];
+
+                if (plParticulas[uxBase + i] <= 4500)
+                    pxBloco->ucDefeitos[i] &= ~estadoDEFEITO_PARTICULAS;
+                else {
+                    pxBloco->ucDefeitos[i] |= estadoDEFEITO_PARTICULAS;
+                    pxBloco->ulDefeitos[i]++;
+                    pxBloco->ulMudanca[i] = ulInicio;
+                    ulMudou |= 1UL << i;
+                    uxMudancas++;
+                    ucDefeitoTarefa[uxBase + i] = 4;
+                }
+            }
 
-        if (particulas <= 4500)
-            defeito = 0;
-        else {
-            defeito = 1;
-            defeitoTarefa = 4;
+            EstadoConcluirEscrita(uxBloco, ulMudou);
         }
 
-        Buffer_part = defeito;
+        if (uxMudancas > 0)
+            xEventGroupSetBits(xEventosControle, EVENTO_DEFEITO);
 
-        printf("Quantidade de particulas: %d Defeito: %d\n\n", particulas, defeito);
+        Registrar2(MSG_PARTICULAS, plParticulas[0], plParticulas[0] > 4500);
+        if (uxZonas > 1)
+            Registrar2(MSG_ZONAS_PARTICULAS, uxMudancas, uxZonas);
 
-        xSemaphoreGive(xMutex_part);
-        vTaskDelay(2000);
+        ulZonasAmostradas[SENSOR_PARTICULAS] += uxZonas;
+        RegistrarAmostra(SENSOR_PARTICULAS, ulInicio);
+        PerfilFimAtivacao();
+        mainAGUARDAR_PERIODO(mainPERIODO_AMOSTRAGEM(SENSOR_PARTICULAS, 2000, lTrocasDefeito, lMaisParticulas));
     }
 }
 
 void GeradorPresencaGas() {
 
-        srand(time(NULL));
-        xSemaphoreTake(xMutex_gas, portMAX_DELAY);
-
-        int sorteio = rand() % 11;
-
-        if (sorteio <= 9)
-            presencaGas = 0;
-        else
-            presencaGas = 1;
-
-        xSemaphoreGive(xMutex_gas);
+    while (1) {
+        // Aguarda o pedido de uma nova amostra
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        UBaseType_t uxZonas = uxNumZonas;
+        int32_t* plGas = lPresencaGas[AnelPosicaoLivre(&xAneis[SENSOR_GAS])];
+        PerfilInicioAtivacao();
+
+        for (UBaseType_t uxZona = 0; uxZona < uxZonas; uxZona++)
+            plGas[uxZona] = SimularGas(&xSimulador);
+
+        AnelPublicar(&xAneis[SENSOR_GAS], (int32_t)uxZonas);
+        mainGRAVAR_AMOSTRA(SENSOR_GAS, uxZonas, plGas, NULL);
+        PerfilFimAtivacao();
+    }
 }
 
 void ModuloSensorPresencaGasRefrigeranteTask() {
 
     while (1) {
 
-        xTaskHandle GPG;
-        xTaskCreate(GeradorPresencaGas, (signed char*)"Gerador de Presenca de Gas", configMINIMAL_STACK_SIZE, (void*)NULL, 1, &GPG);
-
-        xSemaphoreTake(xMutex_gas, portMAX_DELAY);
-
-        printf("Sensoriando presenca de gas refrigerante...\n");
-        // Alteracao de variavel que ser: 1 - Presenca de gas e 0 - Nao Presenca de Gas
-
-        Buffer_gas = presencaGas;
+        configRUN_TIME_COUNTER_TYPE ulInicio = ulGetRunTimeCounterValue();
+        UBaseType_t uxZonas;
+        UBaseType_t uxMudancas = 0;
+        uint32_t ulAtual, ulAnterior;
+        int32_t lTrocasGas = 0;
+        PerfilInicioAtivacao();
+        mainPEDIR_AMOSTRA(xGeradorGas);
+
+        uxZonas = prvConsumirGeracao(SENSOR_GAS, &ulAtual, &ulAnterior);
+        const int32_t* plGas = lPresencaGas[ulAtual];
+
+        Registrar0(MSG_SENSORIANDO_GAS);
+        // Presenca de gas refrigerante em cada zona
+
+        for (UBaseType_t uxBloco = 0; uxBloco * estadoZONAS_POR_BLOCO < uxZonas; uxBloco++) {
+            UBaseType_t uxBase = uxBloco * estadoZONAS_POR_BLOCO;
+            UBaseType_t uxNoBloco = prvZonasNoBloco(uxBloco, uxZonas);
+            BlocoEstado_t* pxBloco = EstadoIniciarEscrita(uxBloco);
+            uint32_t ulMudou = 0;
+
+            for (UBaseType_t i = 0; i < uxNoBloco; i++) {
+                if ((plGas[uxBase + i] != 0) != ((pxBloco->ucDefeitos[i] & estadoPRESENCA_GAS) != 0))
+                    lTrocasGas++;
+
+                if (!plGas[uxBase + i])
+                    pxBloco->ucDefeitos[i] &= ~estadoPRESENCA_GAS;
+                else {
+                    pxBloco->ucDefeitos[i] |= estadoPRESENCA_GAS;
+                    pxBloco->ulDefeitos[i]++;
+                    pxBloco->ulMudanca[i] = ulInicio;
+                    ulMudou |= 1UL << i;
+                    uxMudancas++;
+                    ucDefeitoTarefa[uxBase + i] = 5;
+                }
+            }
 
-        if (Buffer_gas) {
-            defeitoTarefa = 5;
+            EstadoConcluirEscrita(uxBloco, ulMudou);
         }
 
-        printf("Gas Refrigerante no ambiente: %d\n\n", presencaGas);
+        if (uxMudancas > 0)
+            xEventGroupSetBits(xEventosControle, EVENTO_DEFEITO);
 
-        xSemaphoreGive(xMutex_gas);
-        vTaskDelay(2000);
+        Registrar1(MSG_GAS, plGas[0]);
+        if (uxZonas > 1)
+            Registrar2(MSG_ZONAS_GAS, uxMudancas, uxZonas);
+
+        ulZonasAmostradas[SENSOR_GAS] += uxZonas;
+        RegistrarAmostra(SENSOR_GAS, ulInicio);
+        PerfilFimAtivacao();
+        mainAGUARDAR_PERIODO(mainPERIODO_AMOSTRAGEM(SENSOR_GAS, 2000, lTrocasGas, 0));
     }
 }
 
-void LigarArCondicionadoTask() {
-    printf("Ligando o ar Condicionado...\n\n");
-    arCondicionadoLigado = 1;
+// As acoes recebem a zona como parametro (ver ComandosAtuador.h)
+
+void LigarArCondicionadoTask(void* pvZona) {
+    UBaseType_t uxZona = (UBaseType_t)(uintptr_t)pvZona;
+    Registrar1(MSG_LIGANDO, uxZona);
+    ucArLigado[uxZona] = 1;
     // Tempo de execucao = 40ms
     // Deadline = 500ms
     // Acionado quando variavel de numero de pessoas variar de 0 para 1
 }
 
-void ControlarTemperaturaTask() {
-    printf("Mudando Temperatura do Ar Condicionado...\n\n");
+void ControlarTemperaturaTask(void* pvZona) {
+    UBaseType_t uxZona = (UBaseType_t)(uintptr_t)pvZona;
+    Registrar1(MSG_CONTROLANDO, uxZona);
     // Tempo de execucao = 30ms
     // Deadline = 250ms
     // Acionado quando variavel de numero de pessoas ou a temperatura do ambiente variarem
 }
 
-void DesligarArCondicionadoTask() {
-    printf("Desligando o ar Condicionado...\n\n");
-    arCondicionadoLigado = 0;
+void DesligarArCondicionadoTask(void* pvZona) {
+    UBaseType_t uxZona = (UBaseType_t)(uintptr_t)pvZona;
+    Registrar1(MSG_DESLIGANDO, uxZona);
+    ucArLigado[uxZona] = 0;
     // Tempo de execucao = 40ms
     // Deadline = 500ms
     // Acionado quando variavel de numero de pessoas variar para 0
 }
 
-void NotificarDispositivoMovelTask() {
-    printf("Notificando usuario...\n\n");
+void NotificarDispositivoMovelTask(void* pvZona) {
+    UBaseType_t uxZona = (UBaseType_t)(uintptr_t)pvZona;
+    Registrar1(MSG_NOTIFICANDO, uxZona);
     // Tempo de execucao = 15ms
     // Deadline = 250ms
     // Acionado quando uma das tarefas T3, T4 ou T5 tiver retorno = 1
-    switch (defeitoTarefa) {
+    switch (ucDefeitoTarefa[uxZona]) {
     case 3:
-        printf("Foi verificado um problema eletrico no seu ar condicionado.\nDesligue-o e contate o Suporte Tecnico.\n\n");
-        defeitoTarefa = 0;
-        Buffer_tensao_comp = 0;
-        Buffer_tensao_vento = 0;
+        Registrar0(MSG_DEFEITO_ELETRICO);
+        ucDefeitoTarefa[uxZona] = 0;
         break;
     case 4:
-        printf("Foi verificada uma possivel falha no sistema de autolimpeza de seu ar condicionado.\nContate o Suporte Tecnico\n\n");
-        defeitoTarefa = 0;
-        Buffer_part = 0;
+        Registrar0(MSG_DEFEITO_AUTOLIMPEZA);
+        ucDefeitoTarefa[uxZona] = 0;
         break;
     case 5:
-        printf("Foi verificada presenca de gas refrigerante no ambiente.\nContate o Suporte Tecnico\n\n");
-        defeitoTarefa = 0;
-        Buffer_gas = 0;
+        Registrar0(MSG_DEFEITO_GAS);
+        ucDefeitoTarefa[uxZona] = 0;
         break;
     default:
         break;
     }
 }
 
+/* Decisoes sobre a zona i do bloco copiado.  xMudou indica que a zona foi
+ * marcada por um modulo sensor desde a ultima passada (e nao so repetida).
+ * Retorna pdFAIL se algum comando foi recusado por fila cheia. */
+static BaseType_t prvDecidirZona(UBaseType_t uxZona, const BlocoEstado_t* pxBloco, UBaseType_t i, BaseType_t xMudou) {
+
+    UBaseType_t uxBloco = uxZona / estadoZONAS_POR_BLOCO;
+    uint32_t ulBit = 1UL << i;
+    int32_t lPessoasAnterior = pxBloco->lPessoasAnterior[i];
+    int32_t lPessoas = pxBloco->lPessoas[i];
+    BaseType_t xResultado = pdPASS;
+    boolean decidiu = 0;
+
+    if (pxBloco->ulDefeitos[i] != ulDefeitosVistos[uxZona]) {
+        ulDefeitosVistos[uxZona] = pxBloco->ulDefeitos[i];
+        ulDefeitoPendente[uxBloco] |= ulBit;
+    }
+
+    if (lPessoasAnterior == 0 && lPessoas == 1) {
+        if (ComandoEnviar(uxZona, COMANDO_LIGAR) != pdPASS)
+            xResultado = pdFAIL;
+        decidiu = 1;
+    }
+
+    if (ucArLigado[uxZona]) {
+        boolean mudancaTemp = pxBloco->lTemperaturaAnterior[i] != pxBloco->lTemperatura[i];
+        boolean mudancaPres = lPessoasAnterior != lPessoas;
+
+        if (lPessoasAnterior == 1 && lPessoas == 0) {
+            if (ComandoEnviar(uxZona, COMANDO_DESLIGAR) != pdPASS)
+                xResultado = pdFAIL;
+            decidiu = 1;
+        }
+        else {
+            if (mudancaTemp || mudancaPres) {
+                if (ComandoEnviar(uxZona, COMANDO_CONTROLAR) != pdPASS)
+                    xResultado = pdFAIL;
+                decidiu = 1;
+            }
+            // Com a fila cheia o defeito continua pendente para a proxima passada
+            if (ulDefeitoPendente[uxBloco] & ulBit) {
+                if (ComandoEnviar(uxZona, COMANDO_NOTIFICAR) == pdPASS) {
+                    ulDefeitoPendente[uxBloco] &= ~ulBit;
+                    decidiu = 1;
+                }
+                else
+                    xResultado = pdFAIL;
+            }
+        }
+    }
+
+    // Latencia entre a mudanca mais recente e a decisao tomada sobre ela
+    if (decidiu && xMudou)
+        RegistrarLatencia(&xLatenciaDecisao, pxBloco->ulMudanca[i]);
+
+    return xResultado;
+}
+
+void ControleSelecionarPolitica(BaseType_t xPorEventos) {
+
+    xPoliticaPedida = xPorEventos;
+    xEventGroupSetBits(xEventosControle, EVENTO_POLITICA);
+}
+
 void PoolingServerTask() {
+
+    // Alguma zona tem comando recusado a repetir
+    BaseType_t xRepetir = pdFALSE;
+    BaseType_t xPorEventos = xPoliticaPedida;
+
     while (1) {
-        if (Buffer_pres[0] == 0 && Buffer_pres[1] == 1) {
-            xTaskHandle T6;
-            xTaskCreate(LigarArCondicionadoTask, (signed char*)"Ligar Ar Condicionado", configMINIMAL_STACK_SIZE, (void*)NULL, 1, &T6);
+        UBaseType_t uxZonas;
+        uint32_t ulZonasAvaliadas = 0;
+        EventBits_t uxEventos;
+
+        if (xPorEventos) {
+            // Bloqueia ate algum modulo sensor sinalizar uma mudanca.  Com comandos
+            // a repetir acorda tambem depois de uma recarga do servidor.
+            uxEventos = xEventGroupWaitBits(xEventosControle, EVENTOS_CONTROLE | EVENTO_POLITICA, pdTRUE, pdFALSE,
+                                            xRepetir ? mainSERVIDOR_PERIODO : portMAX_DELAY);
+        }
+        else
+            uxEventos = xEventGroupClearBits(xEventosControle, EVENTO_POLITICA);
+
+        // Troca de politica: as estatisticas, que so esta tarefa escreve,
+        // recomecam aqui para medir apenas a politica nova
+        if (uxEventos & EVENTO_POLITICA) {
+            xPorEventos = xPoliticaPedida;
+            memset(&xLatenciaDecisao, 0, sizeof(xLatenciaDecisao));
+            ulDespertaresControle = 0;
         }
 
-        if (arCondicionadoLigado) {
-            boolean mudancaTemp = Buffer_temp[0] != Buffer_temp[1];
-            boolean mudancaPres = Buffer_pres[0] != Buffer_pres[1];
-            boolean defeito = Buffer_gas || Buffer_part || Buffer_tensao_vento || Buffer_tensao_comp;
+        PerfilInicioAtivacao();
+        ulDespertaresControle++;
+        xRepetir = pdFALSE;
+        uxZonas = uxNumZonas;
 
-            if (Buffer_pres[0] == 1 && Buffer_pres[1] == 0) {
-                xTaskHandle T8;
-                xTaskCreate(DesligarArCondicionadoTask, (signed char*)"Desligar Ar Condicionado", configMINIMAL_STACK_SIZE, (void*)NULL, 1, &T8);
-            }
-            else {
-                if (mudancaTemp || mudancaPres) {
-                    xTaskHandle T7;
-                    xTaskCreate(ControlarTemperaturaTask, (signed char*)"Controlar Ar Condicionado", configMINIMAL_STACK_SIZE, (void*)NULL, 1, &T7);
-                }
-                if (defeito) {
-                    xTaskHandle T9;
-                    xTaskCreate(NotificarDispositivoMovelTask, (signed char*)"Notificar Dispositivo Movel", configMINIMAL_STACK_SIZE, (void*)NULL, 1, &T9);
+        // So os blocos com zonas marcadas sao copiados e so essas zonas avaliadas
+        for (UBaseType_t uxBloco = 0; uxBloco * estadoZONAS_POR_BLOCO < uxZonas; uxBloco++) {
+            UBaseType_t uxNoBloco = prvZonasNoBloco(uxBloco, uxZonas);
+            uint32_t ulMudancas = EstadoTomarMudancas(uxBloco);
+            uint32_t ulAvaliar = ulMudancas | ulRepetir[uxBloco];
+
+            if (ulAvaliar == 0)
+                continue;
+
+            ulRepetir[uxBloco] = 0;
+
+            // Todas as decisoes sobre uma zona usam a mesma copia do bloco
+            EstadoLerBloco(uxBloco, &xCopiaBloco);
+
+            for (UBaseType_t i = 0; i < uxNoBloco; i++) {
+                if ((ulAvaliar & (1UL << i)) == 0)
+                    continue;
+
+                ulZonasAvaliadas++;
+                if (prvDecidirZona(uxBloco * estadoZONAS_POR_BLOCO + i, &xCopiaBloco, i, (ulMudancas >> i) & 1) != pdPASS) {
+                    ulRepetir[uxBloco] |= 1UL << i;
+                    xRepetir = pdTRUE;
                 }
             }
         }
-        vTaskDelay(200);
+
+        ulZonasDecididas += ulZonasAvaliadas;
+        PerfilFimAtivacao();
+
+        if (!xPorEventos)
+            vTaskDelay(200);
+    }
+}
+/*-----------------------------------------------------------*/
+
+#if ( mainAMOSTRAGEM_ADAPTATIVA == 1 )
+
+/* Limites da amostragem adaptativa, na ordem de Sensor_t.  O periodo base e o
+ * fixo de antes; Ferramentas/AnaliseRTA usa os minimos, o pior caso.
+ *
+ * Ajustados ao xCenarioPadrao com uma zona: a temperatura varia +-2 graus a
+ * cada amostra, entao mudancas de ate 4 sao ruido (estavel) e so acima disso
+ * contam como grandes.  Nos sensores de defeito a margem e 0, so o alarme dos
+ * modulos (abaixo de 200V, acima de 4500), e uma troca isolada e mudanca
+ * intermediaria: as leituras normais nao prendem o periodo no minimo.  Com
+ * muitas zonas alguma esta sempre em alarme nesse cenario, e os sensores de
+ * defeito ficam no minimo. */
+static const ConfigAmostragem_t xConfigAmostragem[NUM_SENSORES] = {
+    /* minimo               base                    maximo                  janela estavel           estavel grande  limiar                  margem */
+    { pdMS_TO_TICKS(140),   pdMS_TO_TICKS(150),     pdMS_TO_TICKS(600),     pdMS_TO_TICKS(3000),     0,      2,      LIMIAR_NENHUM, 0,       0   },  /* Pessoas por amostra */
+    { pdMS_TO_TICKS(140),   pdMS_TO_TICKS(250),     pdMS_TO_TICKS(2000),    pdMS_TO_TICKS(5000),     4,      5,      LIMIAR_ACIMA,  30,      1   },  /* Graus */
+    { pdMS_TO_TICKS(500),   pdMS_TO_TICKS(2000),    pdMS_TO_TICKS(8000),    pdMS_TO_TICKS(10000),    0,      2,      LIMIAR_ABAIXO, 200,     0   },  /* Defeitos trocados; volts */
+    { pdMS_TO_TICKS(500),   pdMS_TO_TICKS(2000),    pdMS_TO_TICKS(8000),    pdMS_TO_TICKS(10000),    0,      2,      LIMIAR_ACIMA,  4500,    0   },  /* Defeitos trocados; particulas */
+    { pdMS_TO_TICKS(500),   pdMS_TO_TICKS(2000),    pdMS_TO_TICKS(8000),    pdMS_TO_TICKS(10000),    0,      2,      LIMIAR_NENHUM, 0,       0   },  /* Deteccoes trocadas */
+};
+
+#endif /* mainAMOSTRAGEM_ADAPTATIVA */
+
+/* Tabela central das tarefas do gateway, criadas em main(). */
+
+typedef struct {
+    TaskFunction_t pxCodigo;
+    const char* pcNome;
+    UBaseType_t uxPrioridade;
+    TaskHandle_t* pxHandle;
+} TarefaGateway_t;
+
+typedef struct {
+    const char* pcItem;
+    size_t xBytes;
+} ItemOrcamento_t;
+
+static TaskHandle_t HT1, HT2, HT3, HT4, HT5, HT6;
+
+static const TarefaGateway_t xTarefasGateway[] = {
+#if ( mainSENSORES_ORIGEM != mainSENSORES_REPRODUZIR )
+    /* Geradores persistentes: alocados uma unica vez, antes do escalonador */
+    { GeradorFluxoPessoas,                      "Gerador de Fluxo",                     1, &xGeradorFluxo },
+    { GeradorTemperatura,                       "Gerador de Temperatura",               1, &xGeradorTemp },
+    { GeradorTensao,                            "Gerador de Tensoes",                   1, &xGeradorTensao },
+    { GeradorParticulas,                        "Gerador de Particulas",                1, &xGeradorPart },
+    { GeradorPresencaGas,                       "Gerador de Presenca de Gas",           1, &xGeradorGas },
+#else
+    { prvReproducaoTask,                        "Reproducao",                           tskIDLE_PRIORITY, &xTarefaReproducao },
+#endif
+    { ModuloDetectorPresencaTask,               "DetectorPresencaTask",                 6, &HT1 },
+    { ModuloSensorTemperaturaTask,              "SensorTemperaturaTask",                5, &HT2 },
+    { ModuloMedidorTensaoTask,                  "MedidorTensaoTask",                    4, &HT3 },
+    { ModuloSensorParticulasTask,               "SensorParticulasTask",                 3, &HT4 },
+    { ModuloSensorPresencaGasRefrigeranteTask,  "SensorPresencaGasRefrigeranteTask",    2, &HT5 },
+    { PoolingServerTask,                        "BackgroundServerTask",                 1, &HT6 },
+};
+#define mainNUM_TAREFAS_GATEWAY               ( sizeof( xTarefasGateway ) / sizeof( xTarefasGateway[ 0 ] ) )
+
+#if ( mainALOCACAO_ESTATICA == 1 )
+static StaticTask_t xTCBsGateway[mainNUM_TAREFAS_GATEWAY];
+static StackType_t uxPilhasGateway[mainNUM_TAREFAS_GATEWAY][mainPILHA_GATEWAY];
+static StaticEventGroup_t xEventosControleEstatico;
+#endif
+
+/* Tarefas com memoria estatica fora da tabela: ociosa, temporizadores,
+ * drenagem do registro, despejo do rastreio, monitor de pilhas e, conforme a configuracao,
+ * rotacao do rastreio e gravacao dos sensores.  O servidor aperiodico guarda
+ * TCB, pilha, fila e temporizadores na propria estrutura. */
+#if ( TRC_USE_TRACEALYZER_RECORDER == 1 ) && ( TRC_CFG_RECORDER_MODE == TRC_RECORDER_MODE_STREAMING )
+    #define mainTAREFAS_RASTREIO              1
+    #define mainPILHA_RASTREIO                rastreioTAMANHO_PILHA
+    #define mainRAM_RASTREIO                  ( sizeof( TraceStreamPortBuffer_t ) + TRC_CFG_CTRL_TASK_STACK_SIZE * sizeof( StackType_t ) )
+#elif ( TRC_USE_TRACEALYZER_RECORDER == 1 )
+    #define mainTAREFAS_RASTREIO              0
+    #define mainPILHA_RASTREIO                0
+    #define mainRAM_RASTREIO                  sizeof( RecorderDataType )
+#else
+    #define mainTAREFAS_RASTREIO              0
+    #define mainPILHA_RASTREIO                0
+    #define mainRAM_RASTREIO                  0
+#endif
+
+#if ( mainSENSORES_ORIGEM == mainSENSORES_GRAVAR )
+    #define mainTAREFAS_GRAVACAO              1
+    #define mainPILHA_GRAVACAO                gravacaoTAMANHO_PILHA
+#else
+    #define mainTAREFAS_GRAVACAO              0
+    #define mainPILHA_GRAVACAO                0
+#endif
+
+#define mainNUM_TAREFAS_SISTEMA               ( 5 + mainTAREFAS_RASTREIO + mainTAREFAS_GRAVACAO )
+#define mainPALAVRAS_PILHA_SISTEMA            ( configMINIMAL_STACK_SIZE + configTIMER_TASK_STACK_DEPTH + registroTAMANHO_PILHA + \
+                                                despejoTAMANHO_PILHA + pilhasTAMANHO_PILHA + mainPILHA_RASTREIO + mainPILHA_GRAVACAO )
+
+#define mainRAM_TCBS                          ( ( mainNUM_TAREFAS_GATEWAY + mainNUM_TAREFAS_SISTEMA ) * sizeof( StaticTask_t ) )
+#define mainRAM_PILHAS                        ( ( mainNUM_TAREFAS_GATEWAY * mainPILHA_GATEWAY + mainPALAVRAS_PILHA_SISTEMA ) * sizeof( StackType_t ) )
+#define mainRAM_OBJETOS                       sizeof( StaticEventGroup_t )
+#define mainRAM_SERVIDOR                      sizeof( ServidorAperiodico_t )
+
+#if ( mainSENSORES_ORIGEM == mainSENSORES_REPRODUZIR )
+    #define mainRAM_REPRODUCAO                ( sizeof( lReproducaoCanal0 ) + sizeof( lReproducaoCanal1 ) )
+#else
+    #define mainRAM_REPRODUCAO                0
+#endif
+
+/* Vetores por zona deste arquivo, com os aneis dos geradores e o simulador
+ * que os alimenta. */
+#define mainRAM_ZONAS                         ( sizeof( xAneis ) + sizeof( xGeracoes ) + sizeof( lFluxo ) + sizeof( lTemperaturaMedida ) + \
+                                                sizeof( lTensaoVentoinha ) + sizeof( lTensaoCompressor ) + sizeof( lParticulas ) + \
+                                                sizeof( lPresencaGas ) + sizeof( lOcupantes ) + sizeof( ucArLigado ) + sizeof( ucDefeitoTarefa ) + \
+                                                sizeof( ulDefeitosVistos ) + sizeof( ulDefeitoPendente ) + sizeof( ulRepetir ) + \
+                                                sizeof( xCopiaBloco ) + sizeof( xSimulador ) + mainRAM_REPRODUCAO )
+
+#define mainRAM_MAIN                          ( mainRAM_TCBS + mainRAM_PILHAS + mainRAM_OBJETOS + mainRAM_SERVIDOR + \
+                                                mainRAM_ZONAS + mainRAM_RASTREIO )
+
+/* Falha a compilacao (vetor de tamanho negativo) se so o que main.c enxerga
+ * ja estourar o orcamento.  As tabelas dos modulos sao estaticas nos seus
+ * arquivos e entram na soma de prvRelatorioMemoria(). */
+typedef char cOrcamentoRamExcedido[( mainRAM_MAIN <= mainORCAMENTO_RAM ) ? 1 : -1];
+
+/*-----------------------------------------------------------*/
+
+static void prvCriarEventos(void)
+{
+#if ( mainALOCACAO_ESTATICA == 1 )
+    xEventosControle = xEventGroupCreateStatic(&xEventosControleEstatico);
+#else
+    xEventosControle = xEventGroupCreate();
+#endif
+    configASSERT(xEventosControle != NULL);
+}
+/*-----------------------------------------------------------*/
+
+static void prvCriarTarefas(void)
+{
+    for (int i = 0; i < mainNUM_TAREFAS_GATEWAY; i++) {
+        const TarefaGateway_t* pxTarefa = &xTarefasGateway[i];
+
+#if ( mainALOCACAO_ESTATICA == 1 )
+        *pxTarefa->pxHandle = xTaskCreateStatic(pxTarefa->pxCodigo, pxTarefa->pcNome, mainPILHA_GATEWAY, NULL,
+                                                pxTarefa->uxPrioridade, uxPilhasGateway[i], &xTCBsGateway[i]);
+#else
+        xTaskCreate(pxTarefa->pxCodigo, pxTarefa->pcNome, mainPILHA_GATEWAY, NULL,
+                    pxTarefa->uxPrioridade, pxTarefa->pxHandle);
+#endif
+        configASSERT(*pxTarefa->pxHandle != NULL);
+        PilhasRegistrar(*pxTarefa->pxHandle, mainPILHA_GATEWAY);
     }
 }
+/*-----------------------------------------------------------*/
+
+static void prvRelatorioMemoria(void)
+{
+    /* xRam* vem do sizeof dos objetos de cada modulo: nao sao constantes de
+     * compilacao, entao a tabela e montada aqui. */
+    const ItemOrcamento_t xOrcamentoRam[] = {
+        { "TCBs",                                   mainRAM_TCBS },
+        { "pilhas",                                 mainRAM_PILHAS },
+        { "grupo de eventos",                       mainRAM_OBJETOS },
+        { "servidor (TCB, pilha, fila, timers)",    mainRAM_SERVIDOR },
+        { "vetores por zona, aneis e simulador",    mainRAM_ZONAS },
+        { "estado consolidado (blocos)",            xRamEstado },
+        { "comandos pendentes por zona",            xRamComandos },
+        { "monitor de prazos",                      xRamMonitor },
+        { "anel do registro",                       xRamRegistro },
+        { "buffers da gravacao",                    xRamGravacao },
+        { "perfis de execucao",                     xRamPerfil },
+        { "tabelas do monitor de pilhas",           xRamPilhas },
+        { "heap por tarefa",                        xRamHeapTarefas },
+        { "heap (arena e sequencia gravada)",       xRamAlocador },
+        { "benchmarks",                             xRamBenchmarks },
+        { "buffers do rastreio",                    mainRAM_RASTREIO },
+        { "copia do cabecalho do rastreio",         xRamDespejo },
+    };
+    HeapStats_t xHeap;
+    size_t xTotal = 0;
+
+    vPortGetHeapStats(&xHeap);
+
+    printf("[memoria] %u tarefas do gateway e %u do sistema, objetos do gateway %s\n",
+           (unsigned)mainNUM_TAREFAS_GATEWAY, (unsigned)mainNUM_TAREFAS_SISTEMA,
+           mainALOCACAO_ESTATICA == 1 ? "estaticos" : "no heap");
+    for (int i = 0; i < sizeof(xOrcamentoRam) / sizeof(xOrcamentoRam[0]); i++) {
+        printf("[memoria]   %-36s %8u bytes\n", xOrcamentoRam[i].pcItem, (unsigned)xOrcamentoRam[i].xBytes);
+        xTotal += xOrcamentoRam[i].xBytes;
+    }
+    printf("[memoria]   %-36s %8u bytes (orcamento %u)\n", "total", (unsigned)xTotal, (unsigned)mainORCAMENTO_RAM);
+    printf("[memoria] alocacoes no heap durante a partida: %u (%u bytes)\n\n",
+           (unsigned)xHeap.xNumberOfSuccessfulAllocations,
+           (unsigned)(xHeap.xMinimumEverFreeBytesRemaining < xHeap.xAvailableHeapSpaceInBytes ?
+                      0 : xHeap.xAvailableHeapSpaceInBytes - xHeap.xMinimumEverFreeBytesRemaining));
+
+    configASSERT(xTotal <= mainORCAMENTO_RAM);
+#if ( mainALOCACAO_ESTATICA == 1 )
+    configASSERT(xHeap.xNumberOfSuccessfulAllocations == 0);
+#endif
+}
+/*-----------------------------------------------------------*/
 
 int main(void)
 {
-    /* This demo uses heap_5.c, so start by defining some heap regions.  heap_5
-     * is only used for test and example reasons.  Heap_4 is more appropriate.  See
-     * http://www.freertos.org/a00111.html for an explanation. */
-    prvInitialiseHeap();
+    /* pvPortMalloc() e vPortFree() vem de AlocadorPools.c, que monta as
+     * classes na primeira alocacao: nao ha regioes de heap a definir. */
 
     /* Initialise the trace recorder.  Use of the trace recorder is optional.
      * See http://www.FreeRTOS.org/trace for more information. */
 
     vTraceEnable(TRC_START);
 
-    xMutex_pres = xSemaphoreCreateMutex();
-    xMutex_temp = xSemaphoreCreateMutex();
-    xMutex_gas = xSemaphoreCreateMutex();
-    xMutex_tensao = xSemaphoreCreateMutex();
-    xMutex_part = xSemaphoreCreateMutex();
+    SonoOciosoIniciar();
+    prvCriarEventos();
+
+    RegistroInicializar(pcFormatosMensagem, NUM_MENSAGENS, mainREGISTRO_SAIDA, tskIDLE_PRIORITY);
+    RegistroDefinirModo(mainREGISTRO_MODO);
 
-    index_pres = 0;
-    index_temp = 0;
+    /* No modo streaming do recorder, troca o arquivo do rastreio continuo. */
+    RastreioIniciarRotacao(tskIDLE_PRIORITY);
+    DespejoIniciar(mainTRACE_FILE_NAME, tskIDLE_PRIORITY);
+    PilhasIniciar(tskIDLE_PRIORITY);
 
-    xTaskHandle HT1;
-    xTaskHandle HT2;
-    xTaskHandle HT3;
-    xTaskHandle HT4;
-    xTaskHandle HT5;
-    xTaskHandle HT6;
+    SimuladorInicializar(&xSimulador, mainSIMULACAO_SEMENTE, &mainSIMULACAO_CENARIO);
+    EstadoInicializar();
+    prvInicializarZonas();
+
+#if ( mainSENSORES_ORIGEM == mainSENSORES_GRAVAR )
+    if (GravacaoIniciar(mainGRAVACAO_ARQUIVO, tskIDLE_PRIORITY) != pdPASS)
+        printf("[gravacao] nao foi possivel criar %s\n", mainGRAVACAO_ARQUIVO);
+#endif
+
+#if ( mainAMOSTRAGEM_ADAPTATIVA == 1 ) && ( mainSENSORES_ORIGEM != mainSENSORES_REPRODUZIR )
+    AmostragemInicializar(xConfigAmostragem);
+#endif
 
     /* create task */
-    xTaskCreate(ModuloDetectorPresencaTask, (signed char*)"DetectorPresencaTask", configMINIMAL_STACK_SIZE, (void*)NULL, 6, &HT1);
-    xTaskCreate(ModuloSensorTemperaturaTask, (signed char*)"SensorTemperaturaTask", configMINIMAL_STACK_SIZE, (void*)NULL, 5, &HT2);
-    xTaskCreate(ModuloMedidorTensaoTask, (signed char*)"MedidorTensaoTask", configMINIMAL_STACK_SIZE, (void*)NULL, 4, &HT3);
-    xTaskCreate(ModuloSensorParticulasTask, (signed char*)"SensorParticulasTask", configMINIMAL_STACK_SIZE, (void*)NULL, 3, &HT4);
-    xTaskCreate(ModuloSensorPresencaGasRefrigeranteTask, (signed char*)"SensorPresencaGasRefrigeranteTask", configMINIMAL_STACK_SIZE, (void*)NULL, 2, &HT5);
+    prvCriarTarefas();
+
+#if ( mainSENSORES_ORIGEM == mainSENSORES_REPRODUZIR )
+    xModulosSensores[SENSOR_PRESENCA] = HT1;
+    xModulosSensores[SENSOR_TEMPERATURA] = HT2;
+    xModulosSensores[SENSOR_TENSAO] = HT3;
+    xModulosSensores[SENSOR_PARTICULAS] = HT4;
+    xModulosSensores[SENSOR_GAS] = HT5;
+#endif
     
-    // Ver questo do Deferrable Server para tarefas aperidicas
-    //xTaskCreate(PoolingServerTask, (signed char*)"BackgroundServerTask", configMINIMAL_STACK_SIZE, (void*)NULL, 1, &HT6);
+    // As tarefas aperiodicas rodam no servidor, com capacidade reservada
+    const ConfigServidor_t xConfigServidor = {
+        "ServidorAtuadores",
+        mainSERVIDOR_POLITICA,
+        mainSERVIDOR_CAPACIDADE,
+        mainSERVIDOR_PERIODO,
+        mainSERVIDOR_PRIORIDADE,
+        mainSERVIDOR_TAMANHO_FILA
+    };
+    ServidorCriar(&xServidorAtuadores, &xConfigServidor);
+
+    /* Orcamentos e prazos documentados em cada tarefa T6 a T9. */
+    const PrazoTarefa_t pxPrazos[NUM_COMANDOS] = {
+        { "Ligar",     40, 500 },
+        { "Controlar", 30, 250 },
+        { "Desligar",  40, 500 },
+        { "Notificar", 15, 250 }
+    };
+    MonitorInicializar(pxPrazos, NUM_COMANDOS);
+
+    const TrabalhoAperiodico_t pxAcoes[NUM_COMANDOS] = {
+        LigarArCondicionadoTask,        // COMANDO_LIGAR
+        ControlarTemperaturaTask,       // COMANDO_CONTROLAR
+        DesligarArCondicionadoTask,     // COMANDO_DESLIGAR
+        NotificarDispositivoMovelTask   // COMANDO_NOTIFICAR
+    };
+    ComandosInicializar(&xServidorAtuadores, pxAcoes);
+
+    /* As demais tarefas dos modulos tem configMINIMAL_STACK_SIZE, o tamanho
+     * que o monitor de pilhas presume. */
+    PilhasRegistrar(xServidorAtuadores.xTarefa, servidorTAMANHO_PILHA);
+    PilhasRegistrar(RegistroObterTarefaDrenagem(), registroTAMANHO_PILHA);
+
+    /* Tempo de execucao por ativacao de cada tarefa da aplicacao */
+    const TaskHandle_t xPerfiladas[] = {
+#if ( mainSENSORES_ORIGEM == mainSENSORES_REPRODUZIR )
+        xTarefaReproducao,
+#else
+        xGeradorFluxo, xGeradorTemp, xGeradorTensao, xGeradorPart, xGeradorGas,
+#endif
+        HT1, HT2, HT3, HT4, HT5, HT6, xServidorAtuadores.xTarefa, RegistroObterTarefaDrenagem()
+    };
+    for (int i = 0; i < sizeof(xPerfiladas) / sizeof(xPerfiladas[0]); i++)
+        PerfilRegistrar(xPerfiladas[i]);
+
+#if ( mainESCALONAMENTO_EDF == 1 )
+    /* Prazo igual ao periodo */
+    EscalonadorInicializar(ESCALONAMENTO_EDF, mainEDF_PRIORIDADE_MINIMA, mainEDF_PRIORIDADE_MAXIMA);
+    EscalonadorRegistrar(HT1, 150, 150, 6);
+    EscalonadorRegistrar(HT2, 250, 250, 5);
+    EscalonadorRegistrar(HT3, 2000, 2000, 4);
+    EscalonadorRegistrar(HT4, 2000, 2000, 3);
+    EscalonadorRegistrar(HT5, 2000, 2000, 2);
+#endif
+
+    /* Antes dos benchmarks, que alocam do heap: so os objetos do gateway. */
+    prvRelatorioMemoria();
+
+#if ( mainBENCHMARK == mainBENCHMARK_SOAK )
+    xTaskCreate(BenchmarkSoakTask, (signed char*)"BenchSoak", configMINIMAL_STACK_SIZE, (void*)NULL, 1, NULL);
+#elif ( mainBENCHMARK == mainBENCHMARK_ANEL )
+    xTaskCreate(BenchmarkAnelTask, (signed char*)"BenchAnel", configMINIMAL_STACK_SIZE, (void*)NULL, 1, NULL);
+#elif ( mainBENCHMARK == mainBENCHMARK_DECISAO )
+    xTaskCreate(BenchmarkDecisaoTask, (signed char*)"BenchDecisao", configMINIMAL_STACK_SIZE, (void*)NULL, 1, NULL);
+#elif ( mainBENCHMARK == mainBENCHMARK_EDF )
+    xTaskCreate(BenchmarkEDFTask, (signed char*)"BenchEDF", configMINIMAL_STACK_SIZE, (void*)NULL, configMAX_PRIORITIES - 1, NULL);
+#elif ( mainBENCHMARK == mainBENCHMARK_ZONAS )
+    xTaskCreate(BenchmarkZonasTask, (signed char*)"BenchZonas", configMINIMAL_STACK_SIZE, (void*)NULL, configMAX_PRIORITIES - 1, NULL);
+#elif ( mainBENCHMARK == mainBENCHMARK_REGISTRO )
+    xTaskCreate(BenchmarkRegistroTask, (signed char*)"BenchRegistro", configMINIMAL_STACK_SIZE, (void*)NULL, configMAX_PRIORITIES - 1, NULL);
+#elif ( mainBENCHMARK == mainBENCHMARK_SIMULACAO )
+    xTaskCreate(BenchmarkSimulacaoTask, (signed char*)"BenchSimulacao", configMINIMAL_STACK_SIZE, (void*)NULL, configMAX_PRIORITIES - 1, NULL);
+#elif ( mainBENCHMARK == mainBENCHMARK_HEAP )
+    xTaskCreate(BenchmarkHeapTask, (signed char*)"BenchHeap", configMINIMAL_STACK_SIZE, (void*)NULL, configMAX_PRIORITIES - 1, NULL);
+#elif ( mainBENCHMARK == mainBENCHMARK_SONO )
+    xTaskCreate(BenchmarkSonoTask, (signed char*)"BenchSono", configMINIMAL_STACK_SIZE, (void*)NULL, configMAX_PRIORITIES - 1, NULL);
+#endif
+
+    /* Teclas 't' (rastreio) e 'p' (pilhas): a thread do Windows le o teclado
+     * e gera a interrupcao simulada, atendida por prvKeyboardInterruptHandler. */
+    vPortSetInterruptHandler(mainINTERRUPT_NUMBER_KEYBOARD, prvKeyboardInterruptHandler);
+    xWindowsKeyboardInputThreadHandle = CreateThread(NULL, 0, prvWindowsKeyboardInputThread, NULL, 0, NULL);
+
+    /* Fora do nucleo das threads do simulador, como no demo do porte. */
+    SetThreadAffinityMask(xWindowsKeyboardInputThreadHandle, ~0x01u);
+    printf("Tecle '%c' para gravar o rastreio e '%c' para o relatorio de pilhas.\n",
+           mainOUTPUT_TRACE_KEY, mainPILHAS_KEY);
 
     /* start the scheduler */
     vTaskStartScheduler();
@@ -578,6 +1537,9 @@ void vApplicationMallocFailedHook( void )
      * (although it does not provide information on how the remaining heap might be
      * fragmented).  See http://www.freertos.org/a00111.html for more
      * information. */
+
+    /* Quem esta segurando o heap, antes de parar. */
+    HeapTarefasExportar();
     vAssertCalled( __LINE__, __FILE__ );
 }
 /*-----------------------------------------------------------*/
@@ -594,6 +1556,13 @@ void vApplicationIdleHook( void )
      * because it is the responsibility of the idle task to clean up memory
      * allocated by the kernel to any task that has since deleted itself. */
 
+    #if ( configTEMPO_VIRTUAL == 1 )
+        {
+            /* O tempo avanca se todas as outras tarefas estao bloqueadas. */
+            TempoVirtualOcioso();
+        }
+    #endif
+
     #if ( mainCREATE_SIMPLE_BLINKY_DEMO_ONLY != 1 )
         {
             /* Call the idle task processing used by the full demo.  The simple
@@ -633,15 +1602,33 @@ void vApplicationTickHook( void )
             vFullDemoTickHookFunction();
         }
     #endif /* mainCREATE_SIMPLE_BLINKY_DEMO_ONLY */
+
+    /* Ticks realmente tratados, para BenchmarkSonoTask(). */
+    SonoOciosoTick();
 }
 /*-----------------------------------------------------------*/
 
 void vApplicationDaemonTaskStartupHook( void )
 {
+    FonteRunTime_t xFonte;
+
     /* This function will be called once only, when the daemon task starts to
      * execute	(sometimes called the timer task).  This is useful if the
      * application includes initialisation code that would benefit from executing
      * after the scheduler has been started. */
+
+    /* Configurada pelo vTaskStartScheduler(). */
+    RunTimeObterFonte(&xFonte);
+    printf("[run time] fonte %s, %llu Hz, leitura %lu ns\n",
+           xFonte.pcNome, (unsigned long long)xFonte.ullFrequenciaHz,
+           (unsigned long)xFonte.ulCustoLeituraNs);
+
+    #if ( configTEMPO_VIRTUAL == 1 )
+        {
+            /* O port instala o seu tratador do tick ao iniciar o escalonador. */
+            TempoVirtualIniciar();
+        }
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -663,8 +1650,7 @@ void vAssertCalled( unsigned long ulLine,
         printf("ASSERT! Line %ld, file %s, GetLastError() %ld\r\n", ulLine, pcFileName, GetLastError());
 
         /* Stop the trace recording and save the trace. */
-        ( void ) xTraceDisable();
-        prvSaveTraceFile();
+        DespejoImediato();
 
         /* Cause debugger break point if being debugged. */
         __debugbreak();
@@ -689,59 +1675,6 @@ void vAssertCalled( unsigned long ulLine,
 }
 /*-----------------------------------------------------------*/
 
-static void prvSaveTraceFile( void )
-{
-    FILE * pxOutputFile;
-
-    fopen_s( &pxOutputFile, mainTRACE_FILE_NAME, "wb" );
-
-    if( pxOutputFile != NULL )
-    {
-        fwrite( RecorderDataPtr, sizeof( RecorderDataType ), 1, pxOutputFile );
-        fclose( pxOutputFile );
-        printf( "\r\nTrace output saved to %s\r\n\r\n", mainTRACE_FILE_NAME );
-    }
-    else
-    {
-        printf( "\r\nFailed to create trace dump file\r\n\r\n" );
-    }
-}
-/*-----------------------------------------------------------*/
-
-static void prvInitialiseHeap( void )
-{
-/* The Windows demo could create one large heap region, in which case it would
- * be appropriate to use heap_4.  However, purely for demonstration purposes,
- * heap_5 is used instead, so start by defining some heap regions.  No
- * initialisation is required when any other heap implementation is used.  See
- * http://www.freertos.org/a00111.html for more information.
- *
- * The xHeapRegions structure requires the regions to be defined in start address
- * order, so this just creates one big array, then populates the structure with
- * offsets into the array - with gaps in between and messy alignment just for test
- * purposes. */
-    static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
-    volatile uint32_t ulAdditionalOffset = 19; /* Just to prevent 'condition is always true' warnings in configASSERT(). */
-    const HeapRegion_t xHeapRegions[] =
-    {
-        /* Start address with dummy offsets						Size */
-        { ucHeap + 1,                                          mainREGION_1_SIZE },
-        { ucHeap + 15 + mainREGION_1_SIZE,                     mainREGION_2_SIZE },
-        { ucHeap + 19 + mainREGION_1_SIZE + mainREGION_2_SIZE, mainREGION_3_SIZE },
-        { NULL,                                                0                 }
-    };
-
-    /* Sanity check that the sizes and offsets defined actually fit into the
-     * array. */
-    configASSERT( ( ulAdditionalOffset + mainREGION_1_SIZE + mainREGION_2_SIZE + mainREGION_3_SIZE ) < configTOTAL_HEAP_SIZE );
-
-    /* Prevent compiler warnings when configASSERT() is not defined. */
-    ( void ) ulAdditionalOffset;
-
-    vPortDefineHeapRegions( xHeapRegions );
-}
-/*-----------------------------------------------------------*/
-
 /* configUSE_STATIC_ALLOCATION is set to 1, so the application must provide an
  * implementation of vApplicationGetIdleTaskMemory() to provide the memory that is
  * used by the Idle task. */
@@ -800,22 +1733,21 @@ void vApplicationGetTimerTaskMemory( StaticTask_t ** ppxTimerTaskTCBBuffer,
  */
 static uint32_t prvKeyboardInterruptHandler(void)
 {
+    BaseType_t xTrocarContexto = pdFALSE;
+
     /* Handle keyboard input. */
     switch (xKeyPressed)
     {
     case mainNO_KEY_PRESS_VALUE:
         break;
     case mainOUTPUT_TRACE_KEY:
-        /* Saving the trace file requires Windows system calls, so enter a critical
-           section to prevent deadlock or errors resulting from calling a Windows
-           system call from within the FreeRTOS simulator. */
-        portENTER_CRITICAL();
-        {
-            ( void ) xTraceDisable();
-            prvSaveTraceFile();
-            ( void ) xTraceEnable(TRC_START);
-        }
-        portEXIT_CRITICAL();
+        /* A gravacao usa chamadas ao Windows e leva varios milissegundos:
+           fica com a tarefa de despejo, em blocos curtos (DespejoRastreio.h). */
+        xTrocarContexto = DespejoSolicitarDeISR();
+        break;
+    case mainPILHAS_KEY:
+        /* Relatorio de pilhas, impresso pela tarefa do monitor. */
+        xTrocarContexto = PilhasSolicitarDeISR();
         break;
     default:
         #if ( mainCREATE_SIMPLE_BLINKY_DEMO_ONLY == 1 )
@@ -827,8 +1759,7 @@ static uint32_t prvKeyboardInterruptHandler(void)
     break;
     }
 
-    /* This interrupt does not require a context switch so return pdFALSE */
-    return pdFALSE;
+    return xTrocarContexto;
 }
 
 /*-----------------------------------------------------------*/
@@ -845,6 +1776,10 @@ static DWORD WINAPI prvWindowsKeyboardInputThread( void * pvParam )
     {
         /* Block on acquiring a key press. */
         xKeyPressed = _getch();
+
+        /* Com a tarefa ociosa dormindo a interrupcao so entra quando ela
+         * acorda. */
+        SonoOciosoAcordar();
         
         /* Notify FreeRTOS simulator that there is a keyboard interrupt.
          * This will trigger prvKeyboardInterruptHandler.
@@ -858,20 +1793,29 @@ static DWORD WINAPI prvWindowsKeyboardInputThread( void * pvParam )
 
 /*-----------------------------------------------------------*/
 
-/* The below code is used by the trace recorder for timing. */
+/* The below code is used by the trace recorder for timing.  Os eventos sao
+ * carimbados com o contador de run time, nao com o tick, reduzido a
+ * microssegundos: no snapshot cada evento guarda a diferenca para o anterior
+ * em 8 bits, e acima de 255 unidades o recorder grava um evento XTS a mais.
+ * Em ns quase todo evento precisava dele, e o buffer guardava metade dos
+ * eventos.  Os 32 bits em us voltam a cada 71 min, tratado pela diferenca
+ * entre eventos. */
+#define mainRASTREIO_NS_POR_UNIDADE           1000ULL
+
 static uint32_t ulEntryTime = 0;
 
 void vTraceTimerReset( void )
 {
-    ulEntryTime = xTaskGetTickCount();
+    ulEntryTime = ( uint32_t ) ( ulGetRunTimeCounterValue() / mainRASTREIO_NS_POR_UNIDADE );
 }
 
 uint32_t uiTraceTimerGetFrequency( void )
 {
-    return configTICK_RATE_HZ;
+    return ( uint32_t ) ( gatewayRUN_TIME_POR_MS * 1000ULL / mainRASTREIO_NS_POR_UNIDADE );
 }
 
 uint32_t uiTraceTimerGetValue( void )
 {
-    return( xTaskGetTickCount() - ulEntryTime );
+    /* Divide os 64 bits antes de truncar, para a volta cair em 2^32 us. */
+    return( ( uint32_t ) ( ulGetRunTimeCounterValue() / mainRASTREIO_NS_POR_UNIDADE ) - ulEntryTime );
 }